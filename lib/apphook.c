@@ -159,7 +159,6 @@ app_startup(void)
   crypto_init();
   hostname_global_init();
   dns_caching_global_init();
-  dns_caching_thread_init();
   afinter_global_init();
   child_manager_init();
   alarm_init();
@@ -218,7 +217,6 @@ app_shutdown(void)
   child_manager_deinit();
   g_list_foreach(application_hooks, (GFunc) g_free, NULL);
   g_list_free(application_hooks);
-  dns_caching_thread_deinit();
   dns_caching_global_deinit();
   hostname_global_deinit();
   crypto_deinit();
@@ -256,7 +254,6 @@ void
 app_thread_start(void)
 {
   scratch_buffers_allocator_init();
-  dns_caching_thread_init();
   main_loop_call_thread_init();
 }
 
@@ -264,6 +261,5 @@ void
 app_thread_stop(void)
 {
   main_loop_call_thread_deinit();
-  dns_caching_thread_deinit();
   scratch_buffers_allocator_deinit();
 }
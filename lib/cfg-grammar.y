@@ -222,10 +222,12 @@ extern struct _StatsOptions *last_stats_options;
 %token KW_DNS_CACHE_EXPIRE            10130
 %token KW_DNS_CACHE_EXPIRE_FAILED     10131
 %token KW_DNS_CACHE_HOSTS             10132
+%token KW_DNS_CACHE_RESOLVERS         10133
 
 %token KW_PERSIST_ONLY                10140
 %token KW_USE_RCPTID                  10141
 %token KW_USE_UNIQID                  10142
+%token KW_ASYNC                       10143
 
 %token KW_TZ_CONVERT                  10150
 %token KW_TS_FORMAT                   10151
@@ -1015,6 +1017,8 @@ dns_cache_option
 	| KW_DNS_CACHE_EXPIRE_FAILED '(' positive_integer ')'
 	                                        { last_dns_cache_options->expire_failed = $3; }
 	| KW_DNS_CACHE_HOSTS '(' string ')'     { last_dns_cache_options->hosts = g_strdup($3); free($3); }
+	| KW_DNS_CACHE_RESOLVERS '(' positive_integer ')'
+	                                        { last_dns_cache_options->resolver_threads = $3; }
         ;
 
 
@@ -1034,7 +1038,8 @@ yesno
 
 dnsmode
 	: yesno					{ $$ = $1; }
-	| KW_PERSIST_ONLY                       { $$ = 2; }
+	| KW_PERSIST_ONLY                       { $$ = HOST_RESOLVE_USE_DNS_PERSIST_ONLY; }
+	| KW_ASYNC                              { $$ = HOST_RESOLVE_USE_DNS_ASYNC; }
 	;
 
 nonnegative_integer64
@@ -150,11 +150,13 @@ static CfgLexerKeyword main_keywords[] =
   { "template_function",  KW_TEMPLATE_FUNCTION },
   { "on_error",           KW_ON_ERROR },
   { "persist_only",       KW_PERSIST_ONLY },
+  { "async",              KW_ASYNC },
   { "dns_cache_hosts",    KW_DNS_CACHE_HOSTS },
   { "dns_cache",          KW_DNS_CACHE },
   { "dns_cache_size",     KW_DNS_CACHE_SIZE },
   { "dns_cache_expire",   KW_DNS_CACHE_EXPIRE },
   { "dns_cache_expire_failed", KW_DNS_CACHE_EXPIRE_FAILED },
+  { "dns_cache_resolvers", KW_DNS_CACHE_RESOLVERS },
   { "pass_unix_credentials",   KW_PASS_UNIX_CREDENTIALS },
   { "persist_name",            KW_PERSIST_NAME, VERSION_VALUE_3_8 },
 
@@ -25,7 +25,6 @@
 #include "dnscache.h"
 #include "messages.h"
 #include "timeutils/cache.h"
-#include "tls-support.h"
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -74,6 +73,8 @@ struct _DNSCache
   gint persistent_count;
   time_t hosts_mtime;
   time_t hosts_checktime;
+  DNSCacheHostsFilterFunc hosts_filter;
+  gpointer hosts_filter_data;
 };
 
 
@@ -272,6 +273,8 @@ dns_cache_check_hosts(DNSCache *self, glong t)
               if (!p)
                 continue;
               inet_pton(family, ip, &ia);
+              if (self->hosts_filter && !self->hosts_filter(family, &ia, self->hosts_filter_data))
+                continue;
               dns_cache_store_persistent(self, family, &ia, p);
             }
           fclose(hosts);
@@ -343,6 +346,14 @@ dns_cache_new(const DNSCacheOptions *options)
   return self;
 }
 
+/* only the hosts file entries accepted by @filter are loaded into this cache */
+void
+dns_cache_set_hosts_filter(DNSCache *self, DNSCacheHostsFilterFunc filter, gpointer user_data)
+{
+  self->hosts_filter = filter;
+  self->hosts_filter_data = user_data;
+}
+
 void
 dns_cache_free(DNSCache *self)
 {
@@ -357,6 +368,7 @@ dns_cache_options_defaults(DNSCacheOptions *options)
   options->expire = 3600;
   options->expire_failed = 60;
   options->hosts = NULL;
+  options->resolver_threads = 2;
 }
 
 void
@@ -375,13 +387,34 @@ dns_cache_options_destroy(DNSCacheOptions *options)
  * detail.
  **************************************************************************/
 
-TLS_BLOCK_START
+
+/* The cache is shared by all threads, split into shards by the hash of the
+ * address, each protected by its own lock, so that threads resolving
+ * different addresses rarely contend with each other.  The shards also
+ * keep track of the lookups queued to the resolver threads, so that a
+ * burst of messages from the same unknown address results in a single DNS
+ * query.
+ */
+#define DNS_CACHE_SHARDS 16
+
+/* upper limit of lookups waiting for a resolver thread, if more than this
+ * many are queued, new addresses are not resolved until the backlog drains */
+#define DNS_CACHE_MAX_QUEUED_LOOKUPS 1024
+
+typedef struct _DNSCacheShard
 {
-  DNSCache *dns_cache;
-}
-TLS_BLOCK_END;
+  GStaticMutex lock;
+  DNSCache *cache;
+  /* DNSCacheKey -> DNSCacheLookup, lookups queued or being resolved */
+  GHashTable *pending_lookups;
+} DNSCacheShard;
 
-#define dns_cache __tls_deref(dns_cache)
+typedef struct _DNSCacheLookup
+{
+  DNSCacheKey key;
+  GSockAddr *saddr;
+  DNSCachingResolveFunc resolve;
+} DNSCacheLookup;
 
 /* DNS cache related options are global, independent of the configuration
  * (e.g.  GlobalConfig instance), and they are stored in the
@@ -391,7 +424,7 @@ TLS_BLOCK_END;
  *
  * Some notes:
  *   1) DNS cache contents are better retained between configuration reloads
- *   2) There are multiple DNSCache instances as they are per-thread data structs.
+ *   2) There are multiple DNSCache instances as the cache is sharded.
  *
  * The usual pattern would be:
  *    DNSCache->options -> DNSCacheOptions
@@ -401,35 +434,177 @@ TLS_BLOCK_END;
  *
  * The problem with this approach is that we don't want to recreate DNSCache
  * instances when reloading the configuration (as we want to keep their
- * config), and this would mean that we'd have to update the "options"
- * pointers in each of the existing instances.  And those instances are
- * per-thread variables, making it a bit more difficult to track them.
+ * contents), and this would mean that we'd have to update the "options"
+ * pointers in each of the existing instances.
  *
  * For this reason, it was a lot simpler to use a global variable to hold
  * configuration options, one that can be updated as the configuration is
  * reloaded.  Then DNSCache instances transparently take the options changes
- * into account as they continue to resolve names.
- *
- * I could come up with even better solutions to this problem (like using a
- * layer above GlobalConfig, a state that encapsulates per-execution state
- * of syslog-ng), however, right now that would be an overkill and I want to
- * get the DNSCache refactors into the master tree.
+ * into account as they continue to resolve names.  The shards use a copy
+ * of these options, with cache_size divided among them, rounded up so that
+ * small caches are not shrunk any further.  Each shard loads only those
+ * entries of the hosts file that hash to it.
  */
 
 static DNSCacheOptions effective_dns_cache_options;
-G_LOCK_DEFINE_STATIC(unused_dns_caches);
-static GList *unused_dns_caches;
+static DNSCacheOptions dns_cache_shard_options;
+static DNSCacheShard dns_cache_shards[DNS_CACHE_SHARDS];
+static GThreadPool *dns_cache_resolvers;
+
+static DNSCacheShard *
+_get_shard(const DNSCacheKey *key)
+{
+  guint hash = dns_cache_key_hash((DNSCacheKey *) key);
+
+  return &dns_cache_shards[(hash ^ (hash >> 16)) % DNS_CACHE_SHARDS];
+}
+
+static gboolean
+_shard_owns_address(gint family, void *addr, gpointer user_data)
+{
+  DNSCacheKey key;
+
+  dns_cache_fill_key(&key, family, addr);
+  return _get_shard(&key) == (DNSCacheShard *) user_data;
+}
 
+static void
+_dns_cache_lookup_free(DNSCacheLookup *lookup)
+{
+  g_sockaddr_unref(lookup->saddr);
+  g_free(lookup);
+}
+
+static void
+_resolve_pending_lookup(DNSCacheLookup *lookup, gpointer user_data)
+{
+  DNSCacheShard *shard = _get_shard(&lookup->key);
+  gchar buf[256];
+  const gchar *hostname;
+  gboolean positive;
+
+  hostname = lookup->resolve(lookup->saddr, buf, sizeof(buf));
+  positive = (hostname != NULL);
+  if (!hostname)
+    hostname = g_sockaddr_format(lookup->saddr, buf, sizeof(buf), GSA_ADDRESS_ONLY);
+
+  g_static_mutex_lock(&shard->lock);
+  dns_cache_store_dynamic(shard->cache, lookup->key.family, &lookup->key.addr, hostname, positive);
+  /* frees lookup */
+  g_hash_table_remove(shard->pending_lookups, &lookup->key);
+  g_static_mutex_unlock(&shard->lock);
+}
+
+/*
+ * Copies the cached name into @hostname, as the entry itself may be
+ * evicted by another thread as soon as the shard lock is released.
+ */
 gboolean
-dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive)
+dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                   gboolean *positive)
 {
-  return dns_cache_lookup(dns_cache, family, addr, hostname, hostname_len, positive);
+  DNSCacheKey key;
+  DNSCacheShard *shard;
+  const gchar *cached_hostname;
+  gsize cached_hostname_len;
+  gboolean found;
+
+  dns_cache_fill_key(&key, family, addr);
+  shard = _get_shard(&key);
+
+  g_static_mutex_lock(&shard->lock);
+  found = dns_cache_lookup(shard->cache, family, addr, &cached_hostname, &cached_hostname_len, positive);
+  if (found)
+    {
+      g_strlcpy(hostname, cached_hostname, hostname_size);
+      *hostname_len = MIN(cached_hostname_len, hostname_size - 1);
+    }
+  g_static_mutex_unlock(&shard->lock);
+  return found;
 }
 
 void
 dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive)
 {
-  dns_cache_store_dynamic(dns_cache, family, addr, hostname, positive);
+  DNSCacheKey key;
+  DNSCacheShard *shard;
+
+  dns_cache_fill_key(&key, family, addr);
+  shard = _get_shard(&key);
+
+  g_static_mutex_lock(&shard->lock);
+  dns_cache_store_dynamic(shard->cache, family, addr, hostname, positive);
+  g_static_mutex_unlock(&shard->lock);
+}
+
+/*
+ * Queues the reverse lookup of @saddr to the resolver threads, unless a
+ * lookup for the same address is already pending.  The result is stored
+ * in the cache, where subsequent dns_caching_lookup() calls will find it.
+ *
+ * Returns FALSE if the lookup could not be queued as the resolvers are
+ * lagging behind.
+ */
+gboolean
+dns_caching_resolve_async(gint family, void *addr, GSockAddr *saddr, DNSCachingResolveFunc resolve)
+{
+  DNSCacheLookup *lookup;
+  DNSCacheShard *shard;
+
+  lookup = g_new0(DNSCacheLookup, 1);
+  dns_cache_fill_key(&lookup->key, family, addr);
+  shard = _get_shard(&lookup->key);
+
+  g_static_mutex_lock(&shard->lock);
+  if (g_hash_table_lookup(shard->pending_lookups, &lookup->key))
+    {
+      g_static_mutex_unlock(&shard->lock);
+      g_free(lookup);
+      return TRUE;
+    }
+  if (g_thread_pool_unprocessed(dns_cache_resolvers) >= DNS_CACHE_MAX_QUEUED_LOOKUPS)
+    {
+      g_static_mutex_unlock(&shard->lock);
+      g_free(lookup);
+      return FALSE;
+    }
+
+  lookup->saddr = g_sockaddr_ref(saddr);
+  lookup->resolve = resolve;
+  g_hash_table_insert(shard->pending_lookups, &lookup->key, lookup);
+  g_static_mutex_unlock(&shard->lock);
+
+  g_thread_pool_push(dns_cache_resolvers, lookup, NULL);
+  return TRUE;
+}
+
+static void
+_lock_all_shards(void)
+{
+  gint i;
+
+  for (i = 0; i < DNS_CACHE_SHARDS; i++)
+    g_static_mutex_lock(&dns_cache_shards[i].lock);
+}
+
+static void
+_unlock_all_shards(void)
+{
+  gint i;
+
+  for (i = DNS_CACHE_SHARDS - 1; i >= 0; i--)
+    g_static_mutex_unlock(&dns_cache_shards[i].lock);
+}
+
+static void
+_update_shard_options(void)
+{
+  DNSCacheOptions *options = &effective_dns_cache_options;
+
+  dns_cache_shard_options.cache_size = MAX(1, (options->cache_size + DNS_CACHE_SHARDS - 1) / DNS_CACHE_SHARDS);
+  dns_cache_shard_options.expire = options->expire;
+  dns_cache_shard_options.expire_failed = options->expire_failed;
+  dns_cache_shard_options.hosts = options->hosts;
 }
 
 void
@@ -437,6 +612,7 @@ dns_caching_update_options(const DNSCacheOptions *new_options)
 {
   DNSCacheOptions *options = &effective_dns_cache_options;
 
+  _lock_all_shards();
   if (options->hosts)
     g_free(options->hosts);
 
@@ -444,49 +620,51 @@ dns_caching_update_options(const DNSCacheOptions *new_options)
   options->expire = new_options->expire;
   options->expire_failed = new_options->expire_failed;
   options->hosts = g_strdup(new_options->hosts);
+  options->resolver_threads = new_options->resolver_threads;
+  _update_shard_options();
+  _unlock_all_shards();
+
+  g_thread_pool_set_max_threads(dns_cache_resolvers, options->resolver_threads, NULL);
 }
 
 void
-dns_caching_thread_init(void)
+dns_caching_global_init(void)
 {
-  g_assert(dns_cache == NULL);
+  gint i;
 
-  G_LOCK(unused_dns_caches);
-  if (unused_dns_caches)
+  dns_cache_options_defaults(&effective_dns_cache_options);
+  _update_shard_options();
+  for (i = 0; i < DNS_CACHE_SHARDS; i++)
     {
-      dns_cache = unused_dns_caches->data;
-      unused_dns_caches = g_list_delete_link(unused_dns_caches, unused_dns_caches);
-    }
-  G_UNLOCK(unused_dns_caches);
+      DNSCacheShard *shard = &dns_cache_shards[i];
 
-  if (!dns_cache)
-    dns_cache = dns_cache_new(&effective_dns_cache_options);
+      g_static_mutex_init(&shard->lock);
+      shard->cache = dns_cache_new(&dns_cache_shard_options);
+      dns_cache_set_hosts_filter(shard->cache, _shard_owns_address, shard);
+      shard->pending_lookups = g_hash_table_new_full((GHashFunc) dns_cache_key_hash, (GEqualFunc) dns_cache_key_equal,
+                                                     NULL, (GDestroyNotify) _dns_cache_lookup_free);
+    }
+  dns_cache_resolvers = g_thread_pool_new((GFunc) _resolve_pending_lookup, NULL,
+                                          effective_dns_cache_options.resolver_threads, FALSE, NULL);
 }
 
 void
-dns_caching_thread_deinit(void)
+dns_caching_global_deinit(void)
 {
-  g_assert(dns_cache != NULL);
+  gint i;
 
-  G_LOCK(unused_dns_caches);
-  unused_dns_caches = g_list_prepend(unused_dns_caches, dns_cache);
-  G_UNLOCK(unused_dns_caches);
-  dns_cache = NULL;
-}
+  /* lookups still in the queue are dropped, they are freed along with
+   * pending_lookups below */
+  g_thread_pool_free(dns_cache_resolvers, TRUE, TRUE);
+  dns_cache_resolvers = NULL;
 
-void
-dns_caching_global_init(void)
-{
-  dns_cache_options_defaults(&effective_dns_cache_options);
-}
+  for (i = 0; i < DNS_CACHE_SHARDS; i++)
+    {
+      DNSCacheShard *shard = &dns_cache_shards[i];
 
-void
-dns_caching_global_deinit(void)
-{
-  G_LOCK(unused_dns_caches);
-  g_list_foreach(unused_dns_caches, (GFunc) dns_cache_free, NULL);
-  g_list_free(unused_dns_caches);
-  unused_dns_caches = NULL;
-  G_UNLOCK(unused_dns_caches);
+      g_hash_table_destroy(shard->pending_lookups);
+      dns_cache_free(shard->cache);
+      g_static_mutex_free(&shard->lock);
+    }
   dns_cache_options_destroy(&effective_dns_cache_options);
 }
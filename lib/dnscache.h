@@ -27,6 +27,7 @@
 #define DNSCACHE_H_INCLUDED
 
 #include "syslog-ng.h"
+#include "gsockaddr.h"
 
 typedef struct
 {
@@ -34,26 +35,31 @@ typedef struct
   gint expire;
   gint expire_failed;
   gchar *hosts;
+  gint resolver_threads;
 } DNSCacheOptions;
 
 typedef struct _DNSCache DNSCache;
+typedef gboolean (*DNSCacheHostsFilterFunc)(gint family, void *addr, gpointer user_data);
 
 void dns_cache_store_persistent(DNSCache *self, gint family, void *addr, const gchar *hostname);
 void dns_cache_store_dynamic(DNSCache *self, gint family, void *addr, const gchar *hostname, gboolean positive);
 gboolean dns_cache_lookup(DNSCache *self, gint family, void *addr, const gchar **hostname, gsize *hostname_len,
                           gboolean *positive);
 DNSCache *dns_cache_new(const DNSCacheOptions *options);
+void dns_cache_set_hosts_filter(DNSCache *self, DNSCacheHostsFilterFunc filter, gpointer user_data);
 void dns_cache_free(DNSCache *self);
 
 void dns_cache_options_defaults(DNSCacheOptions *options);
 void dns_cache_options_destroy(DNSCacheOptions *options);
 
-gboolean dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive);
+typedef const gchar *(*DNSCachingResolveFunc)(GSockAddr *saddr, gchar *buf, gsize buf_len);
+
+gboolean dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                            gboolean *positive);
 void dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive);
+gboolean dns_caching_resolve_async(gint family, void *addr, GSockAddr *saddr, DNSCachingResolveFunc resolve);
 void dns_caching_update_options(const DNSCacheOptions *dns_cache_options);
 
-void dns_caching_thread_init(void);
-void dns_caching_thread_deinit(void);
 void dns_caching_global_init(void);
 void dns_caching_global_deinit(void);
 
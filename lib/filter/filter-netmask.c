@@ -107,3 +107,18 @@ filter_netmask_new(const gchar *cidr)
   self->super.eval = filter_netmask_eval;
   return &self->super;
 }
+
+/* returns the network (both in network byte order) of a non-negated
+ * netmask() filter, so that callers can index filters by address */
+gboolean
+filter_netmask_get_network(FilterExprNode *s, guint32 *address, guint32 *netmask)
+{
+  FilterNetmask *self = (FilterNetmask *) s;
+
+  if (s->eval != filter_netmask_eval || s->comp)
+    return FALSE;
+
+  *address = self->address.s_addr;
+  *netmask = self->netmask.s_addr;
+  return TRUE;
+}
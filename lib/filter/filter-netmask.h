@@ -28,5 +28,6 @@
 #include "filter-expr.h"
 
 FilterExprNode *filter_netmask_new(const gchar *cidr);
+gboolean filter_netmask_get_network(FilterExprNode *s, guint32 *address, guint32 *netmask);
 
 #endif
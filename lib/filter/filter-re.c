@@ -93,6 +93,71 @@ filter_re_compile_pattern(FilterRE *self, GlobalConfig *cfg, const gchar *re, GE
   return log_matcher_compile(self->matcher, re, error);
 }
 
+/* turns "^literal$" into "literal", returns NULL if the regexp contains
+ * anything that would match more than a single string */
+static gchar *
+_extract_literal_from_anchored_regexp(const gchar *re)
+{
+  gsize len = strlen(re);
+  const gchar *p, *end = re + len - 1;
+  GString *literal;
+  gboolean opaque = FALSE;
+
+  if (len < 2 || re[0] != '^' || *end != '$')
+    return NULL;
+
+  literal = g_string_sized_new(len);
+  for (p = re + 1; p < end && !opaque; p++)
+    {
+      if (*p == '\\')
+        {
+          /* escaped alphanumerics are character classes and friends, a
+           * backslash right before the final '$' would unanchor the regexp */
+          p++;
+          opaque = (p == end || g_ascii_isalnum(*p));
+        }
+      else
+        {
+          opaque = (strchr("^$.|?*+()[]{}", *p) != NULL);
+        }
+      g_string_append_c(literal, *p);
+    }
+
+  return g_string_free(literal, opaque);
+}
+
+/* Returns the single value that a non-negated host(), program(), etc.
+ * filter can match, so that callers can index filters by value.  Only
+ * case sensitive exact string matches and fully anchored literal regexps
+ * qualify.  NOTE: "$" in a PCRE also matches before a trailing newline,
+ * callers have to take care of values ending in '\n'. */
+gboolean
+filter_re_get_literal(FilterExprNode *s, NVHandle *value_handle, gchar **literal)
+{
+  FilterRE *self = (FilterRE *) s;
+  const gchar *type;
+
+  if (s->eval != filter_re_eval || s->comp || s->modify || !self->matcher)
+    return FALSE;
+
+  if (self->matcher_options.flags & (LMF_ICASE | LMF_NEWLINE | LMF_PREFIX | LMF_SUBSTRING))
+    return FALSE;
+
+  type = self->matcher_options.type;
+  if (g_strcmp0(type, "string") == 0)
+    *literal = g_strdup(self->matcher->pattern);
+  else if (g_strcmp0(type, "pcre") == 0)
+    *literal = _extract_literal_from_anchored_regexp(self->matcher->pattern);
+  else
+    return FALSE;
+
+  if (!*literal)
+    return FALSE;
+
+  *value_handle = self->value_handle;
+  return TRUE;
+}
+
 static void
 filter_re_init_instance(FilterRE *self, NVHandle value_handle)
 {
@@ -286,6 +286,16 @@ resolve_address_using_gethostbyaddr(GSockAddr *saddr, gchar *buf, gsize buf_len)
 
 #endif
 
+static const gchar *
+resolve_address(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
+  return resolve_address_using_getnameinfo(saddr, buf, buf_len);
+#else
+  return resolve_address_using_gethostbyaddr(saddr, buf, buf_len);
+#endif
+}
+
 static void *
 sockaddr_to_dnscache_key(GSockAddr *saddr)
 {
@@ -319,17 +329,26 @@ resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
 
   if (host_resolve_options->use_dns_cache)
     {
-      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, (const gchar **) &hname, &hname_len, &positive))
-        return hostname_apply_options_fqdn(hname_len, result_len, hname, positive, host_resolve_options);
+      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, hostname_buffer, sizeof(hostname_buffer), &hname_len,
+                             &positive))
+        return hostname_apply_options_fqdn(hname_len, result_len, hostname_buffer, positive, host_resolve_options);
     }
 
-  if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
+  if (host_resolve_options->use_dns == HOST_RESOLVE_USE_DNS_ASYNC)
     {
-#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
-      hname = resolve_address_using_getnameinfo(saddr, hostname_buffer, sizeof(hostname_buffer));
-#else
-      hname = resolve_address_using_gethostbyaddr(saddr, hostname_buffer, sizeof(hostname_buffer));
-#endif
+      /* best-effort: the name is not known yet, so this message gets
+       * the address, the ones following it get the name as soon as a
+       * resolver thread has stored it in the cache.  The message is not
+       * parked until then, that would reorder it against later traffic
+       * and hand it to the pipeline from a resolver thread. */
+      dns_caching_resolve_async(saddr->sa.sa_family, dnscache_key, saddr, resolve_address);
+      hname = g_sockaddr_format(saddr, hostname_buffer, sizeof(hostname_buffer), GSA_ADDRESS_ONLY);
+      return hostname_apply_options_fqdn(-1, result_len, hname, FALSE, host_resolve_options);
+    }
+
+  if (host_resolve_options->use_dns && host_resolve_options->use_dns != HOST_RESOLVE_USE_DNS_PERSIST_ONLY)
+    {
+      hname = resolve_address(saddr, hostname_buffer, sizeof(hostname_buffer));
       positive = (hname != NULL);
     }
 
@@ -403,6 +422,11 @@ _init_options(HostResolveOptions *options)
         }
       options->use_dns_cache = 0;
     }
+  if (options->use_dns == HOST_RESOLVE_USE_DNS_ASYNC && options->use_dns_cache == 0)
+    {
+      msg_warning("WARNING: use-dns(async) requires dns-cache(yes), falling back to use-dns(yes)");
+      options->use_dns = TRUE;
+    }
 }
 
 void
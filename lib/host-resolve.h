@@ -26,6 +26,13 @@
 #include "syslog-ng.h"
 #include "gsockaddr.h"
 
+/* use_dns values besides yes/no */
+#define HOST_RESOLVE_USE_DNS_PERSIST_ONLY 2
+/* best-effort resolution: a cache miss never blocks, the message gets the
+ * address and the name is resolved in the background for the messages
+ * following it.  Messages are not held back until their name is known. */
+#define HOST_RESOLVE_USE_DNS_ASYNC        3
+
 typedef struct _HostResolveOptions
 {
   gboolean use_dns;
@@ -182,10 +182,20 @@ log_proto_text_server_split_buffer(LogProtoTextServer *self, LogProtoBufferedSer
 {
   gsize raw_split_size;
 
-  /* buffer is not full, but no EOL is present, move partial line
-   * to the beginning of the buffer to make space for new data.
+  /* buffer is not full, but no EOL is present.  As long as a decent
+   * amount of space is left at the end of the buffer, keep reading into
+   * that, so that a long line spanning several reads is not moved around
+   * after each of them.  With an encoding the raw position of the split
+   * has to be calculated anyway, so we always move in that case.
    */
 
+  if (!self->super.super.options->encoding &&
+      state->buffer_size - state->pending_buffer_end >= state->buffer_size / 4)
+    return;
+
+  /* move partial line to the beginning of the buffer to make space for
+   * new data. */
+
   memmove(self->super.buffer, buffer_start, buffer_bytes);
   state->pending_buffer_pos = 0;
   state->pending_buffer_end = buffer_bytes;
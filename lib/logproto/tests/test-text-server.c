@@ -273,6 +273,27 @@ test_log_proto_text_server_multi_read(void)
   log_proto_server_free(proto);
 }
 
+static void
+test_log_proto_text_server_line_spanning_multiple_reads(void)
+{
+  LogProtoServer *proto;
+
+  proto = construct_test_proto(
+            log_transport_mock_records_new(
+              "foo\n0123", -1,
+              /* no EOL, the partial line stays in place while there's space after it */
+              "4567", -1,
+              "89AB", -1,
+              "CDEF\nbar\n", -1,
+              LTM_EOF));
+
+  assert_proto_server_fetch(proto, "foo", -1);
+  assert_proto_server_fetch(proto, "0123456789ABCDEF", -1);
+  assert_proto_server_fetch(proto, "bar", -1);
+  assert_proto_server_fetch_failure(proto, LPS_EOF, NULL);
+  log_proto_server_free(proto);
+}
+
 static void
 test_log_proto_text_server_multi_read_not_allowed(void)
 {
@@ -549,6 +570,7 @@ test_log_proto_text_server(void)
   PROTO_TESTCASE(test_log_proto_text_server_iso8859_2);
   PROTO_TESTCASE(test_log_proto_text_server_invalid_encoding);
   PROTO_TESTCASE(test_log_proto_text_server_multi_read);
+  PROTO_TESTCASE(test_log_proto_text_server_line_spanning_multiple_reads);
   PROTO_TESTCASE(test_log_proto_text_server_multi_read_not_allowed);
   PROTO_TESTCASE(test_log_proto_text_server_is_not_fetching_input_as_long_as_there_is_an_eol_in_buffer);
   PROTO_TESTCASE(test_log_proto_text_server_accumulation_terminated_if_input_is_closed, FALSE);
@@ -27,9 +27,34 @@
 #include "mainloop-call.h"
 #include "ack_tracker.h"
 #include "scratch-buffers.h"
+#include "stats/stats-cluster-single.h"
 
 #include <iv_event.h>
 
+/* histogram buckets of the per-wakeup stats, the last one is open ended */
+static const struct
+{
+  const gchar *name;
+  gint limit;
+} log_reader_fetched_buckets[] =
+{
+  { "wakeups_fetched_0", 0 },
+  { "wakeups_fetched_1", 1 },
+  { "wakeups_fetched_2_15", 15 },
+  { "wakeups_fetched_16_255", 255 },
+  { "wakeups_fetched_256_", G_MAXINT },
+}, log_reader_duration_buckets[] =
+{
+  { "wakeups_usec_0_9", 9 },
+  { "wakeups_usec_10_99", 99 },
+  { "wakeups_usec_100_999", 999 },
+  { "wakeups_usec_1000_9999", 9999 },
+  { "wakeups_usec_10000_", G_MAXINT },
+};
+
+#define LOG_READER_FETCHED_BUCKETS G_N_ELEMENTS(log_reader_fetched_buckets)
+#define LOG_READER_DURATION_BUCKETS G_N_ELEMENTS(log_reader_duration_buckets)
+
 struct _LogReader
 {
   LogSource super;
@@ -62,6 +87,13 @@ struct _LogReader
   PollEvents *pending_poll_events;
 
   struct iv_timer idle_timer;
+
+  /* the number of messages to fetch in the next wakeup, only changes
+   * with flags(adaptive-fetch-limit), between fetch_limit and the
+   * window size */
+  gint fetch_budget;
+  StatsCounterItem *fetched_histogram[LOG_READER_FETCHED_BUCKETS];
+  StatsCounterItem *duration_histogram[LOG_READER_DURATION_BUCKETS];
 };
 
 static gboolean log_reader_fetch_log(LogReader *self);
@@ -408,25 +440,73 @@ log_reader_handle_line(LogReader *self, const guchar *line, gint length, LogTran
   return log_source_free_to_send(&self->super);
 }
 
-/* returns: notify_code (NC_XXXX) or 0 for success */
 static gint
-log_reader_fetch_log(LogReader *self)
+log_reader_get_max_fetch_budget(LogReader *self)
+{
+  return MAX(self->options->fetch_limit, self->options->super.init_window_size);
+}
+
+/* the options (and with them fetch_limit and the window size) may have
+ * changed by a reload, a budget grown with the old ones is not kept */
+static void
+log_reader_reset_fetch_budget(LogReader *self)
+{
+  self->fetch_budget = self->options->fetch_limit;
+}
+
+/* grow the budget while a wakeup leaves messages behind (e.g. we have a
+ * backlog), shrink it back towards fetch_limit as the source catches up,
+ * so that an idle source does not hog the worker once traffic returns */
+static void
+log_reader_adapt_fetch_budget(LogReader *self, gint msg_count)
+{
+  if (!(self->options->flags & LR_ADAPTIVE_FETCH_LIMIT))
+    {
+      log_reader_reset_fetch_budget(self);
+      return;
+    }
+
+  if (msg_count == self->fetch_budget)
+    self->fetch_budget = MIN(self->fetch_budget * 2, log_reader_get_max_fetch_budget(self));
+  else if (msg_count < self->fetch_budget / 2)
+    self->fetch_budget = MAX(self->fetch_budget / 2, self->options->fetch_limit);
+}
+
+static void
+log_reader_update_wakeup_stats(LogReader *self, gint msg_count, struct timespec *start)
+{
+  gint i;
+
+  for (i = 0; i < LOG_READER_FETCHED_BUCKETS - 1 && msg_count > log_reader_fetched_buckets[i].limit; i++)
+    ;
+  stats_counter_inc(self->fetched_histogram[i]);
+
+  if (start->tv_sec == 0 && start->tv_nsec == 0)
+    return;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  glong usec = timespec_diff_nsec(&now, start) / 1000;
+
+  for (i = 0; i < LOG_READER_DURATION_BUCKETS - 1 && usec > log_reader_duration_buckets[i].limit; i++)
+    ;
+  stats_counter_inc(self->duration_histogram[i]);
+}
+
+static gint
+log_reader_fetch_messages(LogReader *self, gint *msg_count_out)
 {
   gint msg_count = 0;
   gboolean may_read = TRUE;
   LogTransportAuxData aux;
 
   log_transport_aux_data_init(&aux);
-  if (log_proto_server_handshake_in_progress(self->proto))
-    {
-      return log_reader_process_handshake(self);
-    }
 
   /* NOTE: this loop is here to decrease the load on the main loop, we try
    * to fetch a couple of messages in a single run (but only up to
-   * fetch_limit).
+   * fetch_budget).
    */
-  while (msg_count < self->options->fetch_limit && !main_loop_worker_job_quit())
+  while (msg_count < self->fetch_budget && !main_loop_worker_job_quit())
     {
       Bookmark *bookmark;
       const guchar *msg;
@@ -448,9 +528,11 @@ log_reader_fetch_log(LogReader *self)
         {
         case LPS_EOF:
           g_sockaddr_unref(aux.peer_addr);
+          *msg_count_out = msg_count;
           return NC_CLOSE;
         case LPS_ERROR:
           g_sockaddr_unref(aux.peer_addr);
+          *msg_count_out = msg_count;
           return NC_READ_ERROR;
         case LPS_SUCCESS:
           break;
@@ -481,11 +563,86 @@ log_reader_fetch_log(LogReader *self)
     }
   log_transport_aux_data_destroy(&aux);
 
-  if (msg_count == self->options->fetch_limit)
+  *msg_count_out = msg_count;
+  return 0;
+}
+
+/* returns: notify_code (NC_XXXX) or 0 for success */
+static gint
+log_reader_fetch_log(LogReader *self)
+{
+  struct timespec start = { 0 };
+  gint msg_count = 0;
+  gint notify_code;
+
+  if (log_proto_server_handshake_in_progress(self->proto))
+    {
+      return log_reader_process_handshake(self);
+    }
+
+  /* the clock is only read if the duration histogram is enabled by stats-level() */
+  if (self->duration_histogram[0])
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+  notify_code = log_reader_fetch_messages(self, &msg_count);
+
+  log_reader_update_wakeup_stats(self, msg_count, &start);
+  if (notify_code)
+    return notify_code;
+
+  if (msg_count == self->fetch_budget)
     self->immediate_check = TRUE;
+  log_reader_adapt_fetch_budget(self, msg_count);
   return 0;
 }
 
+static void
+log_reader_format_stats_key(LogReader *self, StatsClusterKey *sc_key, const gchar *name)
+{
+  stats_cluster_single_key_set_with_name(sc_key, self->super.options->stats_source | SCS_SOURCE,
+                                         self->super.stats_id, self->super.stats_instance, name);
+}
+
+static void
+log_reader_register_stats(LogReader *self)
+{
+  StatsClusterKey sc_key;
+  gint i;
+
+  stats_lock();
+  for (i = 0; i < LOG_READER_FETCHED_BUCKETS; i++)
+    {
+      log_reader_format_stats_key(self, &sc_key, log_reader_fetched_buckets[i].name);
+      stats_register_counter(STATS_LEVEL3, &sc_key, SC_TYPE_SINGLE_VALUE, &self->fetched_histogram[i]);
+    }
+  for (i = 0; i < LOG_READER_DURATION_BUCKETS; i++)
+    {
+      log_reader_format_stats_key(self, &sc_key, log_reader_duration_buckets[i].name);
+      stats_register_counter(STATS_LEVEL3, &sc_key, SC_TYPE_SINGLE_VALUE, &self->duration_histogram[i]);
+    }
+  stats_unlock();
+}
+
+static void
+log_reader_unregister_stats(LogReader *self)
+{
+  StatsClusterKey sc_key;
+  gint i;
+
+  stats_lock();
+  for (i = 0; i < LOG_READER_FETCHED_BUCKETS; i++)
+    {
+      log_reader_format_stats_key(self, &sc_key, log_reader_fetched_buckets[i].name);
+      stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->fetched_histogram[i]);
+    }
+  for (i = 0; i < LOG_READER_DURATION_BUCKETS; i++)
+    {
+      log_reader_format_stats_key(self, &sc_key, log_reader_duration_buckets[i].name);
+      stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->duration_histogram[i]);
+    }
+  stats_unlock();
+}
+
 static gboolean
 log_reader_init(LogPipe *s)
 {
@@ -497,6 +654,8 @@ log_reader_init(LogPipe *s)
   if (!log_proto_server_validate_options(self->proto))
     return FALSE;
 
+  log_reader_reset_fetch_budget(self);
+
   if (!self->options->parse_options.format_handler)
     {
       msg_error("Unknown format plugin specified",
@@ -504,6 +663,7 @@ log_reader_init(LogPipe *s)
       return FALSE;
     }
 
+  log_reader_register_stats(self);
   poll_events_set_callback(self->poll_events, log_reader_io_handle_in, self);
 
   log_reader_update_watches(self);
@@ -524,6 +684,7 @@ log_reader_deinit(LogPipe *s)
   iv_event_unregister(&self->last_msg_sent_event);
   log_reader_stop_watches(self);
   log_reader_stop_idle_timer(self);
+  log_reader_unregister_stats(self);
 
   if (!log_source_deinit(s))
     return FALSE;
@@ -757,6 +918,7 @@ CfgFlagHandler log_reader_flag_handlers[] =
   { "kernel",                     CFH_SET, offsetof(LogReaderOptions, flags),               LR_KERNEL },
   { "empty-lines",                CFH_SET, offsetof(LogReaderOptions, flags),               LR_EMPTY_LINES },
   { "threaded",                   CFH_SET, offsetof(LogReaderOptions, flags),               LR_THREADED },
+  { "adaptive-fetch-limit",       CFH_SET, offsetof(LogReaderOptions, flags),               LR_ADAPTIVE_FETCH_LIMIT },
   { NULL },
 };
 
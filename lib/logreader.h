@@ -34,6 +34,7 @@
 #define LR_KERNEL          0x0002
 #define LR_EMPTY_LINES     0x0004
 #define LR_THREADED        0x0040
+#define LR_ADAPTIVE_FETCH_LIMIT 0x0080
 
 /* options */
 
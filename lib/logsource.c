@@ -30,9 +30,40 @@
 #include "msg-stats.h"
 #include "logmsg/tags.h"
 #include "ack_tracker.h"
+#include "mainloop-worker.h"
+#include "tls-support.h"
 
 #include <string.h>
 
+/* upper limit on the window credits a thread holds back before returning them */
+#define LOG_SOURCE_ACK_BATCH_MAX 64
+
+/*
+ * Acks arrive in the destination threads, each of them adding to the
+ * window of the source, making the cache line of the window counter bounce
+ * between cores.  Worker threads accumulate the credits they return to the
+ * same source and add them in one go, either when the batch gets large
+ * enough or at the end of the current I/O job (via a batch callback).
+ *
+ * Anything related to suspending the source flushes the credits first, so
+ * the order of operations as seen by a single thread is unchanged.
+ */
+typedef struct _LogSourcePendingAcks
+{
+  LogSource *source;
+  guint32 window_size_increment;
+  gboolean batch_callback_registered;
+  WorkerBatchCallback batch_callback;
+} LogSourcePendingAcks;
+
+TLS_BLOCK_START
+{
+  LogSourcePendingAcks pending_acks;
+}
+TLS_BLOCK_END;
+
+#define pending_acks __tls_deref(pending_acks)
+
 gboolean accurate_nanosleep = FALSE;
 
 void
@@ -137,16 +168,87 @@ _flow_control_rate_adjust(LogSource *self)
 #endif
 }
 
+static void
+_flush_pending_acks(void)
+{
+  LogSource *source = pending_acks.source;
+
+  if (!source)
+    return;
+
+  pending_acks.source = NULL;
+  _flow_control_window_size_adjust(source, pending_acks.window_size_increment, FALSE);
+  pending_acks.window_size_increment = 0;
+  log_pipe_unref(&source->super);
+}
+
+static gpointer
+_flush_pending_acks_batch_callback(gpointer user_data)
+{
+  pending_acks.batch_callback_registered = FALSE;
+  _flush_pending_acks();
+  return NULL;
+}
+
+static inline void
+_flush_pending_acks_of_source(LogSource *self)
+{
+  if (pending_acks.source == self)
+    _flush_pending_acks();
+}
+
+static inline guint32
+_get_ack_batch_size(LogSource *self)
+{
+  /* small windows would stall if we held back a large part of them */
+  return CLAMP(self->options->init_window_size / 8, 1, LOG_SOURCE_ACK_BATCH_MAX);
+}
+
+static void
+_flow_control_window_size_adjust_batched(LogSource *self, guint32 window_size_increment)
+{
+  /* threads without an ID never invoke batch callbacks */
+  if (main_loop_worker_get_thread_id() < 0)
+    {
+      _flow_control_window_size_adjust(self, window_size_increment, FALSE);
+      return;
+    }
+
+  if (pending_acks.source != self)
+    {
+      _flush_pending_acks();
+      pending_acks.source = self;
+      log_pipe_ref(&self->super);
+    }
+  pending_acks.window_size_increment += window_size_increment;
+
+  if (pending_acks.window_size_increment >= _get_ack_batch_size(self))
+    {
+      _flush_pending_acks();
+      return;
+    }
+
+  if (!pending_acks.batch_callback_registered)
+    {
+      worker_batch_callback_init(&pending_acks.batch_callback);
+      pending_acks.batch_callback.func = _flush_pending_acks_batch_callback;
+      pending_acks.batch_callback.user_data = NULL;
+      main_loop_worker_register_batch_callback(&pending_acks.batch_callback);
+      pending_acks.batch_callback_registered = TRUE;
+    }
+}
+
 void
 log_source_flow_control_adjust(LogSource *self, guint32 window_size_increment)
 {
-  _flow_control_window_size_adjust(self, window_size_increment, FALSE);
+  _flow_control_window_size_adjust_batched(self, window_size_increment);
   _flow_control_rate_adjust(self);
 }
 
 void
 log_source_flow_control_adjust_when_suspended(LogSource *self, guint32 window_size_increment)
 {
+  _flush_pending_acks_of_source(self);
   _flow_control_window_size_adjust(self, window_size_increment, TRUE);
   _flow_control_rate_adjust(self);
 }
@@ -171,6 +273,7 @@ log_source_flow_control_suspend(LogSource *self)
             log_pipe_location_tag(&self->super),
             evt_tag_str("function", __FUNCTION__));
 
+  _flush_pending_acks_of_source(self);
   window_size_counter_suspend(&self->window_size);
 }
 
@@ -28,6 +28,38 @@
 #include "timeutils/timeutils.h"
 #include "timeutils/names.h"
 #include "str-format.h"
+#include "tls-support.h"
+
+#include <string.h>
+
+#define FORMATTED_STAMP_CACHE_SIZE 4
+
+/* Timestamps are formatted as a prefix (everything up to the seconds),
+ * followed by the fraction of the second and a suffix (the zone offset in
+ * the case of ISO timestamps).  Only the fraction changes between
+ * messages that arrive in the same second, so the prefix and the suffix
+ * are cached per thread, keyed by (seconds, zone offset, ts_format).
+ */
+typedef struct _FormattedStampCache
+{
+  time_t tv_sec;
+  glong zone_offset;
+  gint ts_format;
+  guint8 prefix_len;
+  guint8 suffix_len;
+  gchar prefix[32];
+  gchar suffix[8];
+} FormattedStampCache;
+
+TLS_BLOCK_START
+{
+  FormattedStampCache formatted_stamp_cache[FORMATTED_STAMP_CACHE_SIZE];
+  gint formatted_stamp_cache_next;
+}
+TLS_BLOCK_END;
+
+#define formatted_stamp_cache       __tls_deref(formatted_stamp_cache)
+#define formatted_stamp_cache_next  __tls_deref(formatted_stamp_cache_next)
 
 static void
 log_stamp_append_frac_digits(const LogStamp *stamp, GString *target, gint frac_digits)
@@ -50,32 +82,9 @@ log_stamp_append_frac_digits(const LogStamp *stamp, GString *target, gint frac_d
     }
 }
 
-/**
- * log_stamp_format:
- * @stamp: Timestamp to format
- * @target: Target storage for formatted timestamp
- * @ts_format: Specifies basic timestamp format (TS_FMT_BSD, TS_FMT_ISO)
- * @zone_offset: Specifies custom zone offset if @tz_convert == TZ_CNV_CUSTOM
- *
- * Emits the formatted version of @stamp into @target as specified by
- * @ts_format and @tz_convert.
- **/
-void
-log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format, glong zone_offset, gint frac_digits)
+static void
+_append_prefix(GString *target, const struct tm *tm, gint ts_format)
 {
-  glong target_zone_offset = 0;
-  struct tm *tm, tm_storage;
-  char buf[8];
-  time_t t;
-
-  if (zone_offset != -1)
-    target_zone_offset = zone_offset;
-  else
-    target_zone_offset = stamp->zone_offset;
-
-  t = stamp->tv_sec + target_zone_offset;
-  cached_gmtime(&t, &tm_storage);
-  tm = &tm_storage;
   switch (ts_format)
     {
     case TS_FMT_BSD:
@@ -88,7 +97,6 @@ log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format,
       format_uint32_padded(target, 2, '0', 10, tm->tm_min);
       g_string_append_c(target, ':');
       format_uint32_padded(target, 2, '0', 10, tm->tm_sec);
-      log_stamp_append_frac_digits(stamp, target, frac_digits);
       break;
     case TS_FMT_ISO:
       format_uint32_padded(target, 0, 0, 10, tm->tm_year + 1900);
@@ -102,10 +110,6 @@ log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format,
       format_uint32_padded(target, 2, '0', 10, tm->tm_min);
       g_string_append_c(target, ':');
       format_uint32_padded(target, 2, '0', 10, tm->tm_sec);
-
-      log_stamp_append_frac_digits(stamp, target, frac_digits);
-      format_zone_info(buf, sizeof(buf), target_zone_offset);
-      g_string_append(target, buf);
       break;
     case TS_FMT_FULL:
       format_uint32_padded(target, 0, 0, 10, tm->tm_year + 1900);
@@ -119,12 +123,6 @@ log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format,
       format_uint32_padded(target, 2, '0', 10, tm->tm_min);
       g_string_append_c(target, ':');
       format_uint32_padded(target, 2, '0', 10, tm->tm_sec);
-
-      log_stamp_append_frac_digits(stamp, target, frac_digits);
-      break;
-    case TS_FMT_UNIX:
-      format_uint32_padded(target, 0, 0, 10, (int) stamp->tv_sec);
-      log_stamp_append_frac_digits(stamp, target, frac_digits);
       break;
     default:
       g_assert_not_reached();
@@ -132,6 +130,88 @@ log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format,
     }
 }
 
+static FormattedStampCache *
+_lookup_formatted_stamp_cache(time_t tv_sec, glong zone_offset, gint ts_format)
+{
+  for (gint i = 0; i < FORMATTED_STAMP_CACHE_SIZE; i++)
+    {
+      FormattedStampCache *entry = &formatted_stamp_cache[i];
+
+      if (entry->tv_sec == tv_sec &&
+          entry->zone_offset == zone_offset &&
+          entry->ts_format == ts_format &&
+          entry->prefix_len > 0)
+        return entry;
+    }
+  return NULL;
+}
+
+static FormattedStampCache *
+_fill_formatted_stamp_cache(time_t tv_sec, glong zone_offset, gint ts_format)
+{
+  FormattedStampCache *entry = &formatted_stamp_cache[formatted_stamp_cache_next];
+  GString *prefix = g_string_sized_new(sizeof(entry->prefix));
+  struct tm tm;
+  time_t t;
+
+  formatted_stamp_cache_next = (formatted_stamp_cache_next + 1) % FORMATTED_STAMP_CACHE_SIZE;
+
+  t = tv_sec + zone_offset;
+  cached_gmtime(&t, &tm);
+  _append_prefix(prefix, &tm, ts_format);
+
+  entry->prefix_len = MIN(prefix->len, sizeof(entry->prefix));
+  memcpy(entry->prefix, prefix->str, entry->prefix_len);
+  g_string_free(prefix, TRUE);
+
+  entry->suffix_len = 0;
+  if (ts_format == TS_FMT_ISO)
+    entry->suffix_len = MIN(format_zone_info(entry->suffix, sizeof(entry->suffix), zone_offset),
+                            sizeof(entry->suffix) - 1);
+
+  entry->tv_sec = tv_sec;
+  entry->zone_offset = zone_offset;
+  entry->ts_format = ts_format;
+  return entry;
+}
+
+/**
+ * log_stamp_format:
+ * @stamp: Timestamp to format
+ * @target: Target storage for formatted timestamp
+ * @ts_format: Specifies basic timestamp format (TS_FMT_BSD, TS_FMT_ISO)
+ * @zone_offset: Specifies custom zone offset if @tz_convert == TZ_CNV_CUSTOM
+ *
+ * Emits the formatted version of @stamp into @target as specified by
+ * @ts_format and @tz_convert.
+ **/
+void
+log_stamp_append_format(const LogStamp *stamp, GString *target, gint ts_format, glong zone_offset, gint frac_digits)
+{
+  FormattedStampCache *entry;
+  glong target_zone_offset = 0;
+
+  if (zone_offset != -1)
+    target_zone_offset = zone_offset;
+  else
+    target_zone_offset = stamp->zone_offset;
+
+  if (ts_format == TS_FMT_UNIX)
+    {
+      format_uint32_padded(target, 0, 0, 10, (int) stamp->tv_sec);
+      log_stamp_append_frac_digits(stamp, target, frac_digits);
+      return;
+    }
+
+  entry = _lookup_formatted_stamp_cache(stamp->tv_sec, target_zone_offset, ts_format);
+  if (!entry)
+    entry = _fill_formatted_stamp_cache(stamp->tv_sec, target_zone_offset, ts_format);
+
+  g_string_append_len(target, entry->prefix, entry->prefix_len);
+  log_stamp_append_frac_digits(stamp, target, frac_digits);
+  g_string_append_len(target, entry->suffix, entry->suffix_len);
+}
+
 void
 log_stamp_format(LogStamp *stamp, GString *target, gint ts_format, glong zone_offset, gint frac_digits)
 {
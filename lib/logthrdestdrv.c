@@ -27,10 +27,20 @@
 #include "seqnum.h"
 #include "scratch-buffers.h"
 #include "timeutils/timeutils.h"
+#include "tls-support.h"
 
 #define MAX_RETRIES_ON_ERROR_DEFAULT 3
 #define MAX_RETRIES_BEFORE_SUSPEND_DEFAULT 3
 
+TLS_BLOCK_START
+{
+  /* whether this thread is running _perform_work() */
+  gboolean performing_work;
+}
+TLS_BLOCK_END;
+
+#define performing_work __tls_deref(performing_work)
+
 static void _init_stats_key(LogThreadedDestDriver *self, StatsClusterKey *sc_key);
 
 /* LogThreadedDestWorker */
@@ -51,6 +61,20 @@ log_threaded_dest_driver_set_batch_timeout(LogDriver *s, gint batch_timeout)
   self->batch_timeout = batch_timeout;
 }
 
+/*
+ * Sources batch the window credits returned by acks until the batch
+ * callbacks of the thread are invoked, which _perform_work() does when it
+ * finishes.  Drivers using LTR_EXPLICIT_ACK_MGMT may ack outside of it
+ * (e.g. from their own timers or when disconnecting), the credits are
+ * returned right away then, as an idle source may be waiting for them.
+ */
+static void
+_return_window_credits_outside_of_work(void)
+{
+  if (!performing_work && main_loop_worker_get_thread_id() >= 0)
+    main_loop_worker_invoke_batch_callbacks();
+}
+
 /* this should be used in combination with LTR_EXPLICIT_ACK_MGMT to actually confirm message delivery. */
 void
 log_threaded_dest_worker_ack_messages(LogThreadedDestWorker *self, gint batch_size)
@@ -59,6 +83,7 @@ log_threaded_dest_worker_ack_messages(LogThreadedDestWorker *self, gint batch_si
   stats_counter_add(self->owner->written_messages, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
+  _return_window_credits_outside_of_work();
 }
 
 void
@@ -68,6 +93,7 @@ log_threaded_dest_worker_drop_messages(LogThreadedDestWorker *self, gint batch_s
   stats_counter_add(self->owner->dropped_messages, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
+  _return_window_credits_outside_of_work();
 }
 
 void
@@ -485,6 +511,7 @@ _perform_work(gpointer data)
   LogThreadedDestWorker *self = (LogThreadedDestWorker *) data;
   gint timeout_msec = 0;
 
+  performing_work = TRUE;
   self->suspended = FALSE;
   main_loop_worker_run_gc();
   _stop_watches(self);
@@ -558,6 +585,10 @@ _perform_work(gpointer data)
        * outstanding parallel push callbacks automatically.
        */
     }
+
+  /* return the window credits of the messages acked above to the sources */
+  main_loop_worker_invoke_batch_callbacks();
+  performing_work = FALSE;
 }
 
 static void
@@ -700,6 +731,7 @@ _worker_thread(gpointer arg)
   LogThreadedResult result = log_threaded_dest_worker_flush(self);
   _process_result(self, result);
   log_queue_rewind_backlog_all(self->queue);
+  main_loop_worker_invoke_batch_callbacks();
 
   _disconnect(self);
 
@@ -32,6 +32,40 @@
  * CSVScannerOptions
  ************************************************************************/
 
+/* Precompiles the delimiters, so that the scanner can skip over runs of
+ * literal characters with strcspn() instead of checking every delimiter
+ * at every position.  stop_chars contains every character that may start
+ * a delimiter.  */
+static void
+_compile_delimiters(CSVScannerOptions *options)
+{
+  GString *stop_chars = g_string_new(options->delimiters);
+  GList *l;
+  gint i;
+
+  g_free(options->string_delimiter_matcher);
+  options->num_string_delimiters = g_list_length(options->string_delimiters);
+  options->string_delimiter_matcher = g_new0(CSVScannerStringDelimiter, options->num_string_delimiters);
+  options->exotic_delimiters = FALSE;
+
+  for (l = options->string_delimiters, i = 0; l; l = l->next, i++)
+    {
+      const gchar *delimiter = (const gchar *) l->data;
+
+      options->string_delimiter_matcher[i].str = delimiter;
+      options->string_delimiter_matcher[i].len = strlen(delimiter);
+
+      /* an empty string delimiter matches everywhere */
+      if (delimiter[0] == 0)
+        options->exotic_delimiters = TRUE;
+      else if (!strchr(stop_chars->str, delimiter[0]))
+        g_string_append_c(stop_chars, delimiter[0]);
+    }
+
+  g_free(options->stop_chars);
+  options->stop_chars = g_string_free(stop_chars, FALSE);
+}
+
 void
 csv_scanner_options_set_flags(CSVScannerOptions *options, guint32 flags)
 {
@@ -56,6 +90,7 @@ csv_scanner_options_set_delimiters(CSVScannerOptions *options, const gchar *deli
 {
   g_free(options->delimiters);
   options->delimiters = g_strdup(delimiters);
+  _compile_delimiters(options);
 }
 
 void
@@ -63,6 +98,7 @@ csv_scanner_options_set_string_delimiters(CSVScannerOptions *options, GList *str
 {
   string_list_free(options->string_delimiters);
   options->string_delimiters = string_delimiters;
+  _compile_delimiters(options);
 }
 
 void
@@ -130,6 +166,8 @@ csv_scanner_options_clean(CSVScannerOptions *options)
   g_free(options->delimiters);
   string_list_free(options->string_delimiters);
   string_list_free(options->columns);
+  g_free(options->stop_chars);
+  g_free(options->string_delimiter_matcher);
 }
 
 /************************************************************************
@@ -202,19 +240,20 @@ _parse_character_with_quotation(CSVScanner *self)
   self->src++;
 }
 
-/* searches for str in list and returns the first occurrence, otherwise NULL */
-static const gboolean
-_match_string_delimiters_at_current_position(const char *input, GList *string_delimiters, int *result_length)
+/* returns the first string delimiter in configuration order that matches input */
+static gboolean
+_match_string_delimiters_at_current_position(const char *input, CSVScannerOptions *options, gsize *result_length)
 {
-  GList *l;
+  gint i;
 
-  for (l = string_delimiters; l; l = l->next)
+  for (i = 0; i < options->num_string_delimiters; i++)
     {
-      gint len = strlen(l->data);
+      CSVScannerStringDelimiter *delimiter = &options->string_delimiter_matcher[i];
 
-      if (strncmp(input, l->data, len) == 0)
+      if ((delimiter->len == 0 || input[0] == delimiter->str[0]) &&
+          strncmp(input, delimiter->str, delimiter->len) == 0)
         {
-          *result_length = len;
+          *result_length = delimiter->len;
           return TRUE;
         }
     }
@@ -224,14 +263,12 @@ _match_string_delimiters_at_current_position(const char *input, GList *string_de
 static gboolean
 _parse_string_delimiters_at_current_position(CSVScanner *self)
 {
-  gint delim_len;
+  gsize delim_len;
 
-  if (!self->options->string_delimiters)
+  if (!self->options->num_string_delimiters)
     return FALSE;
 
-  if (_match_string_delimiters_at_current_position(self->src,
-                                                   self->options->string_delimiters,
-                                                   &delim_len))
+  if (_match_string_delimiters_at_current_position(self->src, self->options, &delim_len))
     {
       self->src += delim_len;
       return TRUE;
@@ -289,6 +326,57 @@ _parse_value_with_whitespace_and_delimiter(CSVScanner *self)
     }
 }
 
+/* copies the run of characters that cannot end the quotation */
+static void
+_scan_quoted_run(CSVScanner *self)
+{
+  gchar stop_chars[3] = { self->current_quote, 0, 0 };
+  gsize run;
+
+  if (self->options->dialect == CSV_SCANNER_ESCAPE_BACKSLASH)
+    stop_chars[1] = '\\';
+
+  run = strcspn(self->src, stop_chars);
+  g_string_append_len(self->current_value, self->src, run);
+  self->src += run;
+
+  if (*self->src)
+    _parse_character_with_quotation(self);
+}
+
+/* copies the run of characters that cannot start a delimiter, returns
+ * TRUE if a delimiter terminated the value */
+static gboolean
+_scan_unquoted_run(CSVScanner *self)
+{
+  gsize run = strcspn(self->src, self->options->stop_chars);
+
+  g_string_append_len(self->current_value, self->src, run);
+  self->src += run;
+
+  if (*self->src == 0)
+    return FALSE;
+
+  if (_parse_delimiter(self))
+    return TRUE;
+
+  /* the first character of a string delimiter that did not match */
+  _parse_unquoted_literal_character(self);
+  return FALSE;
+}
+
+static void
+_scan_value_with_whitespace_and_delimiter(CSVScanner *self)
+{
+  while (*self->src)
+    {
+      if (self->current_quote)
+        _scan_quoted_run(self);
+      else if (_scan_unquoted_run(self))
+        break;
+    }
+}
+
 static gint
 _get_value_length_without_right_whitespace(CSVScanner *self)
 {
@@ -381,7 +469,10 @@ csv_scanner_scan_next(CSVScanner *self)
     {
       _parse_opening_quote_character(self);
       _parse_left_whitespace(self);
-      _parse_value_with_whitespace_and_delimiter(self);
+      if (self->options->exotic_delimiters || !self->options->stop_chars)
+        _parse_value_with_whitespace_and_delimiter(self);
+      else
+        _scan_value_with_whitespace_and_delimiter(self);
       _translate_value(self);
       return TRUE;
     }
@@ -38,6 +38,12 @@ typedef enum
 #define CSV_SCANNER_STRIP_WHITESPACE   0x0001
 #define CSV_SCANNER_GREEDY             0x0002
 
+typedef struct _CSVScannerStringDelimiter
+{
+  const gchar *str;
+  gsize len;
+} CSVScannerStringDelimiter;
+
 typedef struct _CSVScannerOptions
 {
   GList *columns;
@@ -48,6 +54,12 @@ typedef struct _CSVScannerOptions
   GList *string_delimiters;
   CSVScannerDialect dialect;
   guint32 flags;
+
+  /* derived from delimiters and string_delimiters by the setters */
+  gchar *stop_chars;
+  CSVScannerStringDelimiter *string_delimiter_matcher;
+  gint num_string_delimiters;
+  gboolean exotic_delimiters;
 } CSVScannerOptions;
 
 void csv_scanner_options_clean(CSVScannerOptions *options);
@@ -190,6 +190,32 @@ Test(csv_scanner, greedy_column)
   csv_scanner_deinit(&scanner);
 }
 
+Test(csv_scanner, string_delimiters_and_quoted_runs)
+{
+  const gchar *columns[] = { "foo", "bar", "baz", "qux", NULL };
+  const gchar *string_delimiters[] = { "::", NULL };
+
+  _default_options(columns);
+  csv_scanner_options_set_string_delimiters(&options, string_array_to_list(string_delimiters));
+  csv_scanner_init(&scanner, &options, "a:b::\"c,\"\"d\"\"\",e,'f::g'h");
+
+  cr_expect(_scan_next());
+  cr_expect(_column_nv_equals("foo", "a:b"));
+
+  cr_expect(_scan_next());
+  cr_expect(_column_nv_equals("bar", "c,\"d\""));
+
+  cr_expect(_scan_next());
+  cr_expect(_column_nv_equals("baz", "e"));
+
+  cr_expect(_scan_next());
+  cr_expect(_column_nv_equals("qux", "f::gh"));
+
+  cr_expect(!_scan_next());
+  cr_expect(_scan_complete());
+  csv_scanner_deinit(&scanner);
+}
+
 static void
 setup(void)
 {
@@ -118,6 +118,25 @@ _should_stop(KVScanner *self)
   return *input == self->stop_char;
 }
 
+static gboolean
+_extract_key_found_by_previous_value(KVScanner *self)
+{
+  const gchar *input = &self->input[self->input_pos];
+
+  if (self->next_key_start != input)
+    return FALSE;
+
+  self->next_key_start = NULL;
+
+  /* the key must be delimited by the first separator */
+  if (memchr(input, self->value_separator, self->next_key_separator - input))
+    return FALSE;
+
+  g_string_assign_len(self->key, input, self->next_key_end - input);
+  self->input_pos = self->next_key_separator - self->input + 1;
+  return TRUE;
+}
+
 static gboolean
 _extract_key(KVScanner *self)
 {
@@ -125,6 +144,9 @@ _extract_key(KVScanner *self)
   const gchar *start_of_key, *end_of_key;
   const gchar *separator;
 
+  if (_extract_key_found_by_previous_value(self))
+    return TRUE;
+
   separator = _locate_separator(self, input);
   while (separator)
     {
@@ -153,13 +175,22 @@ static gboolean
 _key_follows(KVScanner *self, const gchar *cur)
 {
   const gchar *key = cur;
+  const gchar *end_of_key;
 
   while (self->is_valid_key_character(*key))
     key++;
+  end_of_key = key;
 
   while (*key == ' ')
     key++;
-  return (key != cur) && (*key == self->value_separator);
+  if ((end_of_key != cur) && (*key == self->value_separator))
+    {
+      self->next_key_start = cur;
+      self->next_key_end = end_of_key;
+      self->next_key_separator = key;
+      return TRUE;
+    }
+  return FALSE;
 }
 
 static inline void
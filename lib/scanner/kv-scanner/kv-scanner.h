@@ -47,6 +47,12 @@ struct _KVScanner
   gsize pair_separator_len;
   gchar stop_char;
 
+  /* the key that ended the previous value, as found by the delimiter
+   * matcher, so that it does not have to be located again */
+  const gchar *next_key_start;
+  const gchar *next_key_end;
+  const gchar *next_key_separator;
+
   KVTransformValueFunc transform_value;
   KVExtractAnnotationFunc extract_annotation;
   KVIsValidKeyCharFunc is_valid_key_character;
@@ -60,6 +66,7 @@ kv_scanner_input(KVScanner *self, const gchar *input)
 {
   self->input = input;
   self->input_pos = 0;
+  self->next_key_start = NULL;
   if (self->stray_words)
     g_string_truncate(self->stray_words, 0);
 }
@@ -750,6 +750,15 @@ Test(kv_scanner, space_is_only_a_delimiter_if_a_key_follows)
 }
 
 
+Test(kv_scanner, long_values_are_decoded_in_runs)
+{
+  _EXPECT_KV_PAIRS("k1=\"a \\\"quoted\\\" value\" k2=plain unquoted value k3='x\\ty' k4=v",
+  {"k1", "a \"quoted\" value"},
+  {"k2", "plain unquoted value"},
+  {"k3", "x\ty"},
+  {"k4", "v"});
+}
+
 Test(kv_scanner, spaces_are_trimmed_from_key_names)
 {
   _EXPECT_KV_PAIRS(" foo =bar ggg baz=ez",
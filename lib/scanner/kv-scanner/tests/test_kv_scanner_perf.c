@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "kv-scanner.h"
+#include "apphook.h"
+#include "scratch-buffers.h"
+#include "timeutils/timeutils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void
+iterate_pattern(const gchar *input)
+{
+  KVScanner scanner;
+  GTimeVal start, end;
+  gint i, pairs = 0;
+
+  kv_scanner_init(&scanner, '=', NULL, FALSE);
+  g_get_current_time(&start);
+  for (i = 0; i < 100000; i++)
+    {
+      kv_scanner_input(&scanner, input);
+      while (kv_scanner_scan_next(&scanner))
+        pairs++;
+    }
+  g_get_current_time(&end);
+  kv_scanner_deinit(&scanner);
+  scratch_buffers_explicit_gc();
+
+  printf("      %-90.*s speed: %12.3f msg/sec, %d pairs/msg\n", (int) MIN(strlen(input), 90), input,
+         i * 1e6 / g_time_val_diff(&end, &start), pairs / i);
+}
+
+static void
+test_kv_scanner_performance(void)
+{
+  iterate_pattern("foo=bar");
+
+  iterate_pattern("devname=FG100D date=2018-04-12 time=12:45:03 devid=FG100D3G16000000 logid=0000000013 "
+                  "type=traffic subtype=forward level=notice vd=root srcip=10.10.10.2 srcport=54190 "
+                  "srcintf=\"port1\" dstip=198.51.100.7 dstport=443 dstintf=\"wan1\" poluuid=c2d6e1d2 "
+                  "sessionid=2046382 proto=6 action=close policyid=1 policytype=policy dstcountry=\"United States\" "
+                  "srccountry=\"Reserved\" trandisp=snat transip=203.0.113.1 transport=54190 service=\"HTTPS\" "
+                  "duration=12 sentbyte=2290 rcvdbyte=6547 sentpkt=15 rcvdpkt=13 appcat=\"unscanned\"");
+
+  iterate_pattern("type=SYSCALL msg=audit(1440927434.124:40347): arch=c000003e syscall=59 success=yes exit=0 "
+                  "a0=7f7d8e1b8f10 a1=7f7d8e1b9090 a2=7f7d8e1b90a0 a3=0 items=2 ppid=3652 pid=3659 "
+                  "auid=4294967295 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=(none) ses=4294967295 "
+                  "comm=\"dhclient-script\" exe=\"/bin/bash\" key=(null)");
+
+  iterate_pattern("msg=\"a value with many words in it, that is long enough to matter\" user=foo "
+                  "reason=unquoted value with several words result=denied");
+}
+
+int
+main(int argc G_GNUC_UNUSED, char *argv[] G_GNUC_UNUSED)
+{
+  app_startup();
+  test_kv_scanner_performance();
+  app_shutdown();
+  return 0;
+}
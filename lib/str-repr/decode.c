@@ -120,6 +120,41 @@ _match_and_skip_delimiter(StrReprDecodeState *state)
 }
 
 
+/* Characters that are not in delimiter_chars cannot terminate an unquoted
+ * value, so they are copied as a single run.  state->cur is left at the
+ * last character of the run, as the main loop advances it. */
+static void
+_append_unquoted_run(StrReprDecodeState *state)
+{
+  const StrReprDecodeOptions *options = state->options;
+  const gchar *start = state->cur + 1;
+  const gchar *run = start;
+
+  if (!options->delimiter_chars[0])
+    return;
+
+  while (*run && *run != options->delimiter_chars[0] && *run != options->delimiter_chars[1]
+         && *run != options->delimiter_chars[2])
+    run++;
+
+  g_string_append_len(state->value, start, run - start);
+  state->cur = run - 1;
+}
+
+/* same as _append_unquoted_run(), within quotes */
+static void
+_append_quoted_run(StrReprDecodeState *state)
+{
+  const gchar *start = state->cur + 1;
+  const gchar *run = start;
+
+  while (*run && *run != state->quote_char && *run != '\\')
+    run++;
+
+  g_string_append_len(state->value, start, run - start);
+  state->cur = run - 1;
+}
+
 static gint
 _process_initial_character(StrReprDecodeState *state)
 {
@@ -135,6 +170,7 @@ _process_initial_character(StrReprDecodeState *state)
   else
     {
       g_string_append_c(state->value, *state->cur);
+      _append_unquoted_run(state);
       return KV_UNQUOTED_CHARACTERS;
     }
 }
@@ -148,6 +184,7 @@ _process_quoted_string_characters(StrReprDecodeState *state)
     return KV_QUOTE_BACKSLASH;
 
   g_string_append_c(state->value, *state->cur);
+  _append_quoted_run(state);
   return KV_QUOTE_STRING;
 }
 
@@ -180,6 +217,7 @@ _process_unquoted_characters(StrReprDecodeState *state)
   if (_match_and_skip_delimiter(state))
     return KV_FINISH_SUCCESS;
   g_string_append_c(state->value, *state->cur);
+  _append_unquoted_run(state);
   return KV_UNQUOTED_CHARACTERS;
 }
 
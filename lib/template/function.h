@@ -77,6 +77,11 @@ struct _LogTemplateFunction
 
   /* generic argument that can be used to pass information from registration time */
   gpointer arg;
+
+  /* optional, returns TRUE if the function would produce the same output
+   * for any message with the arguments in state, in which case it is
+   * evaluated once, when the template is compiled */
+  gboolean (*is_constant)(LogTemplateFunction *self, gpointer state);
 };
 
 #define TEMPLATE_FUNCTION_PROTOTYPE(prefix) \
@@ -102,6 +107,22 @@ struct _LogTemplateFunction
     return &func;                                                       \
   }
 
+/* same as TEMPLATE_FUNCTION() but for functions that can be constant folded */
+#define TEMPLATE_FUNCTION_FOLDABLE(state_struct, prefix, _prepare, _eval, _call, _free_state, _is_constant, _arg) \
+  TEMPLATE_FUNCTION_PROTOTYPE(prefix)           \
+  {                                                                     \
+    static LogTemplateFunction func = {                                 \
+      .size_of_state = sizeof(state_struct),                            \
+      .prepare = _prepare,                                              \
+      .eval = _eval,                                                    \
+      .call = _call,                                                    \
+      .free_state = _free_state,                                        \
+      .arg = _arg,                                                      \
+      .is_constant = _is_constant,                                      \
+    };                                                                  \
+    return &func;                                                       \
+  }
+
 #define TEMPLATE_FUNCTION_PLUGIN(x, tf_name) \
   {                                     \
     .type = LL_CONTEXT_TEMPLATE_FUNC,   \
@@ -54,6 +54,18 @@ typedef struct _LogTemplateElem
   };
 } LogTemplateElem;
 
+/* One instruction of the linked (executable) form of a template.  Literal
+ * text preceding an element is merged into a single run, elements that
+ * produce constant output are folded into that literal, so a literal-only
+ * instruction has elem == NULL.  Text is owned by LogTemplate->program_text,
+ * elements by LogTemplate->compiled_template. */
+typedef struct _LogTemplateInstr
+{
+  const gchar *text;
+  gsize text_len;
+  LogTemplateElem *elem;
+} LogTemplateInstr;
+
 void log_template_elem_free_list(GList *el);
 
 
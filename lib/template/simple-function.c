@@ -89,6 +89,20 @@ tf_simple_func_call(LogTemplateFunction *self, gpointer s, const LogTemplateInvo
   simple_func(args->messages[args->num_messages-1], state->argc, (GString **) args->argv, result);
 }
 
+gboolean
+tf_simple_func_is_constant(LogTemplateFunction *self, gpointer s)
+{
+  TFSimpleFuncState *state = (TFSimpleFuncState *) s;
+  gint i;
+
+  for (i = 0; i < state->argc; i++)
+    {
+      if (!log_template_is_literal_string(state->argv_templates[i]))
+        return FALSE;
+    }
+  return TRUE;
+}
+
 void
 tf_simple_func_free_state(gpointer s)
 {
@@ -42,7 +42,11 @@ gboolean tf_simple_func_prepare(LogTemplateFunction *self, gpointer state, LogTe
 void tf_simple_func_eval(LogTemplateFunction *self, gpointer state, LogTemplateInvokeArgs *args);
 void tf_simple_func_call(LogTemplateFunction *self, gpointer state, const LogTemplateInvokeArgs *args, GString *result);
 void tf_simple_func_free_state(gpointer state);
+gboolean tf_simple_func_is_constant(LogTemplateFunction *self, gpointer state);
 
 #define TEMPLATE_FUNCTION_SIMPLE(x) TEMPLATE_FUNCTION(TFSimpleFuncState, x, tf_simple_func_prepare, tf_simple_func_eval, tf_simple_func_call, tf_simple_func_free_state, x)
 
+/* for simple functions whose output only depends on their arguments */
+#define TEMPLATE_FUNCTION_SIMPLE_PURE(x) TEMPLATE_FUNCTION_FOLDABLE(TFSimpleFuncState, x, tf_simple_func_prepare, tf_simple_func_eval, tf_simple_func_call, tf_simple_func_free_state, tf_simple_func_is_constant, x)
+
 #endif
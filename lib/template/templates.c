@@ -27,14 +27,134 @@
 #include "template/macros.h"
 #include "template/escaping.h"
 #include "cfg.h"
+#include "scratch-buffers.h"
 
 static void
 log_template_reset_compiled(LogTemplate *self)
 {
+  g_free(self->program);
+  self->program = NULL;
+  self->program_len = 0;
+  g_free(self->program_text);
+  self->program_text = NULL;
+  self->trivial = FALSE;
+
   log_template_elem_free_list(self->compiled_template);
   self->compiled_template = NULL;
 }
 
+static gboolean
+_elem_is_literal(LogTemplateElem *e)
+{
+  return e->type == LTE_MACRO && e->macro == M_NONE;
+}
+
+/* a function call with a msg_ref produces no output if the context has
+ * fewer messages than that, so it depends on the context after all */
+static gboolean
+_elem_is_constant_func(LogTemplate *self, LogTemplateElem *e)
+{
+  return self->cfg &&
+         e->type == LTE_FUNC &&
+         e->msg_ref == 0 &&
+         e->func.ops->is_constant &&
+         e->func.ops->is_constant(e->func.ops, e->func.state);
+}
+
+/* evaluate a function call that produces the same output for every
+ * message, once, with an empty message */
+static void
+_fold_constant_func(LogTemplate *self, LogTemplateElem *e, GString *result)
+{
+  ScratchBuffersMarker mark;
+  LogMessage *msg = log_msg_new_empty();
+  LogTemplateInvokeArgs args =
+  {
+    &msg,
+    1,
+    &self->cfg->template_options,
+    LTZ_LOCAL,
+    0,
+    NULL
+  };
+
+  scratch_buffers_mark(&mark);
+  if (e->func.ops->eval)
+    e->func.ops->eval(e->func.ops, e->func.state, &args);
+  e->func.ops->call(e->func.ops, e->func.state, &args, result);
+  scratch_buffers_reclaim_marked(mark);
+  log_msg_unref(msg);
+}
+
+static gboolean
+_program_is_trivial(LogTemplate *self)
+{
+  if (self->program_len != 1)
+    return FALSE;
+
+  LogTemplateInstr *instr = &self->program[0];
+  return instr->text_len == 0 &&
+         instr->elem &&
+         instr->elem->type == LTE_VALUE &&
+         instr->elem->msg_ref == 0 &&
+         !instr->elem->default_value;
+}
+
+/* Translate the GList based compiled_template into a contiguous array of
+ * instructions: literal text is merged into runs, function calls with
+ * literal arguments are folded into the literal text.  Text of
+ * instructions is first recorded as offsets into program_text, as that
+ * may be reallocated while it is being built.  */
+static void
+log_template_link(LogTemplate *self)
+{
+  GString *text = g_string_sized_new(32);
+  gsize *text_offsets = g_new(gsize, g_list_length(self->compiled_template) + 1);
+  gsize run_start = 0;
+  GList *p;
+
+  self->program = g_new0(LogTemplateInstr, g_list_length(self->compiled_template) + 1);
+  self->program_len = 0;
+
+  for (p = self->compiled_template; p; p = g_list_next(p))
+    {
+      LogTemplateElem *e = (LogTemplateElem *) p->data;
+
+      if (e->text)
+        g_string_append_len(text, e->text, e->text_len);
+
+      if (_elem_is_literal(e))
+        continue;
+
+      if (_elem_is_constant_func(self, e))
+        {
+          _fold_constant_func(self, e, text);
+          continue;
+        }
+
+      LogTemplateInstr *instr = &self->program[self->program_len];
+      text_offsets[self->program_len] = run_start;
+      instr->text_len = text->len - run_start;
+      instr->elem = e;
+      self->program_len++;
+      run_start = text->len;
+    }
+
+  if (text->len > run_start)
+    {
+      text_offsets[self->program_len] = run_start;
+      self->program[self->program_len].text_len = text->len - run_start;
+      self->program_len++;
+    }
+
+  self->program_text = g_string_free(text, FALSE);
+  for (gint i = 0; i < self->program_len; i++)
+    self->program[i].text = self->program_text + text_offsets[i];
+  g_free(text_offsets);
+
+  self->trivial = _program_is_trivial(self);
+}
+
 gboolean
 log_template_compile(LogTemplate *self, const gchar *template, GError **error)
 {
@@ -51,6 +171,10 @@ log_template_compile(LogTemplate *self, const gchar *template, GError **error)
   log_template_compiler_init(&compiler, self);
   result = log_template_compiler_compile(&compiler, &self->compiled_template, error);
   log_template_compiler_clear(&compiler);
+
+  /* NOTE: a failed compilation also produces a list (containing an error
+   * message), so that is linked too */
+  log_template_link(self);
   return result;
 }
 
@@ -69,97 +193,148 @@ log_template_set_type_hint(LogTemplate *self, const gchar *type_hint, GError **e
 }
 
 
+gboolean
+log_template_is_literal_string(const LogTemplate *self)
+{
+  return self->program_len == 0 || (self->program_len == 1 && !self->program[0].elem);
+}
+
+const gchar *
+log_template_get_literal_value(const LogTemplate *self, gssize *value_len)
+{
+  g_assert(log_template_is_literal_string(self));
+
+  if (self->program_len == 0)
+    {
+      if (value_len)
+        *value_len = 0;
+      return "";
+    }
+
+  if (value_len)
+    *value_len = self->program[0].text_len;
+  return self->program[0].text;
+}
+
+/* a trivial template is a single value reference, like "$HOST" or
+ * "${.json.foo}", its value can be returned without copying it. */
+gboolean
+log_template_is_trivial(const LogTemplate *self)
+{
+  return self->trivial;
+}
+
+const gchar *
+log_template_get_trivial_value(const LogTemplate *self, LogMessage *msg, gssize *value_len)
+{
+  g_assert(self->trivial);
+
+  return log_msg_get_value(msg, self->program[0].elem->value_handle, value_len);
+}
+
+static void
+_append_elem(LogTemplate *self, LogTemplateElem *e, LogMessage **messages, gint num_messages,
+             const LogTemplateOptions *opts, gint tz, gint32 seq_num, const gchar *context_id, GString *result)
+{
+  gint msg_ndx;
+
+  /* NOTE: msg_ref is 1 larger than the index specified by the user in
+   * order to make it distinguishable from the zero value.  Therefore
+   * the '>' instead of '>='
+   *
+   * msg_ref == 0 means that the user didn't specify msg_ref
+   * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
+  if (e->msg_ref > num_messages)
+    return;
+  msg_ndx = num_messages - e->msg_ref;
+
+  /* value and macro can't understand a context, assume that no msg_ref means @0 */
+  if (e->msg_ref == 0)
+    msg_ndx--;
+
+  switch (e->type)
+    {
+    case LTE_VALUE:
+    {
+      const gchar *value = NULL;
+      gssize value_len = -1;
+
+      value = log_msg_get_value(messages[msg_ndx], e->value_handle, &value_len);
+      if (value && value[0])
+        result_append(result, value, value_len, self->escape);
+      else if (e->default_value)
+        result_append(result, e->default_value, -1, self->escape);
+      break;
+    }
+    case LTE_MACRO:
+    {
+      gint len = result->len;
+
+      if (e->macro)
+        {
+          log_macro_expand(result, e->macro, self->escape, opts, tz, seq_num, context_id,
+                           messages[msg_ndx]);
+          if (len == result->len && e->default_value)
+            g_string_append(result, e->default_value);
+        }
+      break;
+    }
+    case LTE_FUNC:
+    {
+      LogTemplateInvokeArgs args =
+      {
+        e->msg_ref ? &messages[msg_ndx] : messages,
+        e->msg_ref ? 1 : num_messages,
+        opts,
+        tz,
+        seq_num,
+        context_id
+      };
+
+      /* if a function call is called with an msg_ref, we only
+       * pass that given logmsg to argument resolution, otherwise
+       * we pass the whole set so the arguments can individually
+       * specify which message they want to resolve from
+       */
+      if (e->func.ops->eval)
+        e->func.ops->eval(e->func.ops, e->func.state, &args);
+      e->func.ops->call(e->func.ops, e->func.state, &args, result);
+      break;
+    }
+    default:
+      g_assert_not_reached();
+      break;
+    }
+}
+
 void
 log_template_append_format_with_context(LogTemplate *self, LogMessage **messages, gint num_messages,
                                         const LogTemplateOptions *opts, gint tz, gint32 seq_num, const gchar *context_id, GString *result)
 {
-  GList *p;
-  LogTemplateElem *e;
+  gint i;
 
   if (!opts)
     opts = &self->cfg->template_options;
 
-  for (p = self->compiled_template; p; p = g_list_next(p))
+  if (self->trivial)
     {
-      gint msg_ndx;
+      const gchar *value;
+      gssize value_len = -1;
 
-      e = (LogTemplateElem *) p->data;
-      if (e->text)
-        {
-          g_string_append_len(result, e->text, e->text_len);
-        }
+      value = log_msg_get_value(messages[num_messages - 1], self->program[0].elem->value_handle, &value_len);
+      result_append(result, value, value_len, self->escape);
+      return;
+    }
 
-      /* NOTE: msg_ref is 1 larger than the index specified by the user in
-       * order to make it distinguishable from the zero value.  Therefore
-       * the '>' instead of '>='
-       *
-       * msg_ref == 0 means that the user didn't specify msg_ref
-       * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
-      if (e->msg_ref > num_messages)
-        continue;
-      msg_ndx = num_messages - e->msg_ref;
+  for (i = 0; i < self->program_len; i++)
+    {
+      LogTemplateInstr *instr = &self->program[i];
 
-      /* value and macro can't understand a context, assume that no msg_ref means @0 */
-      if (e->msg_ref == 0)
-        msg_ndx--;
+      if (instr->text_len)
+        g_string_append_len(result, instr->text, instr->text_len);
 
-      switch (e->type)
-        {
-        case LTE_VALUE:
-        {
-          const gchar *value = NULL;
-          gssize value_len = -1;
-
-          value = log_msg_get_value(messages[msg_ndx], e->value_handle, &value_len);
-          if (value && value[0])
-            result_append(result, value, value_len, self->escape);
-          else if (e->default_value)
-            result_append(result, e->default_value, -1, self->escape);
-          break;
-        }
-        case LTE_MACRO:
-        {
-          gint len = result->len;
-
-          if (e->macro)
-            {
-              log_macro_expand(result, e->macro, self->escape, opts ? opts : &self->cfg->template_options, tz, seq_num, context_id,
-                               messages[msg_ndx]);
-              if (len == result->len && e->default_value)
-                g_string_append(result, e->default_value);
-            }
-          break;
-        }
-        case LTE_FUNC:
-        {
-          if (1)
-            {
-              LogTemplateInvokeArgs args =
-              {
-                e->msg_ref ? &messages[msg_ndx] : messages,
-                e->msg_ref ? 1 : num_messages,
-                opts,
-                tz,
-                seq_num,
-                context_id
-              };
-
-
-              /* if a function call is called with an msg_ref, we only
-               * pass that given logmsg to argument resolution, otherwise
-               * we pass the whole set so the arguments can individually
-               * specify which message they want to resolve from
-               */
-              if (e->func.ops->eval)
-                e->func.ops->eval(e->func.ops, e->func.state, &args);
-              e->func.ops->call(e->func.ops, e->func.state, &args, result);
-            }
-          break;
-        }
-        default:
-          g_assert_not_reached();
-          break;
-        }
+      if (instr->elem)
+        _append_elem(self, instr->elem, messages, num_messages, opts, tz, seq_num, context_id, result);
     }
 }
 
@@ -60,6 +60,11 @@ typedef struct _LogTemplate
   gchar *name;
   gchar *template;
   GList *compiled_template;
+  /* contiguous, optimized form of compiled_template, this is what gets executed */
+  struct _LogTemplateInstr *program;
+  gint program_len;
+  gchar *program_text;
+  gboolean trivial;
   gboolean escape;
   gboolean def_inline;
   GlobalConfig *cfg;
@@ -101,6 +106,11 @@ void log_template_format_with_context(LogTemplate *self, LogMessage **messages,
                                       const LogTemplateOptions *opts, gint tz, gint32 seq_num, const gchar *context_id, GString *result);
 void log_template_set_name(LogTemplate *self, const gchar *name);
 
+gboolean log_template_is_literal_string(const LogTemplate *self);
+const gchar *log_template_get_literal_value(const LogTemplate *self, gssize *value_len);
+gboolean log_template_is_trivial(const LogTemplate *self);
+const gchar *log_template_get_trivial_value(const LogTemplate *self, LogMessage *msg, gssize *value_len);
+
 LogTemplate *log_template_new(GlobalConfig *cfg, const gchar *name);
 LogTemplate *log_template_ref(LogTemplate *s);
 void log_template_unref(LogTemplate *s);
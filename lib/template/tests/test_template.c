@@ -326,3 +326,60 @@ Test(template, test_template_function_args)
                          "33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 "
                          "49 50 51 52 53 54 55 56 57 58 59 60 61 62 63 64");
 }
+
+Test(template, test_literal_and_trivial_templates)
+{
+  LogTemplate *template;
+  gssize value_len;
+
+  template = compile_template("literal text", FALSE);
+  cr_assert(log_template_is_literal_string(template));
+  cr_assert_not(log_template_is_trivial(template));
+  cr_assert_str_eq(log_template_get_literal_value(template, &value_len), "literal text");
+  cr_assert_eq(value_len, strlen("literal text"));
+  log_template_unref(template);
+
+  template = compile_template("${APP.VALUE}", FALSE);
+  cr_assert_not(log_template_is_literal_string(template));
+  cr_assert(log_template_is_trivial(template));
+  log_template_unref(template);
+
+  template = compile_template("${APP.VALUE:-ures}", FALSE);
+  cr_assert_not(log_template_is_trivial(template));
+  log_template_unref(template);
+
+  template = compile_template("${APP.VALUE}@1", FALSE);
+  cr_assert_not(log_template_is_trivial(template));
+  log_template_unref(template);
+
+  assert_template_format("${APP.VALUE}", "value");
+  assert_template_format_with_escaping("${APP.QVALUE}", TRUE, "\\\"value\\\"");
+}
+
+Test(template, test_constant_folding)
+{
+  LogTemplate *template;
+
+  template = compile_template("foo $(echo bar) $(uppercase baz)", FALSE);
+  cr_assert(log_template_is_literal_string(template));
+  cr_assert_str_eq(log_template_get_literal_value(template, NULL), "foo bar BAZ");
+  log_template_unref(template);
+
+  template = compile_template("$(echo $(echo foo) bar)", FALSE);
+  cr_assert(log_template_is_literal_string(template));
+  cr_assert_str_eq(log_template_get_literal_value(template, NULL), "foo bar");
+  log_template_unref(template);
+
+  template = compile_template("$(echo $HOST bar)", FALSE);
+  cr_assert_not(log_template_is_literal_string(template));
+  log_template_unref(template);
+
+  template = compile_template("$(echo foo)@1", FALSE);
+  cr_assert_not(log_template_is_literal_string(template));
+  log_template_unref(template);
+
+  assert_template_format("foo $(echo bar) $HOST $(uppercase baz)", "foo bar bzorp BAZ");
+  assert_template_format("$(length $(echo foobar))$HOST", "6bzorp");
+  assert_template_format_with_context("$(echo foo)@1 bar", "foo bar");
+  assert_template_format_with_context("$(echo foo)@3 bar", " bar");
+}
@@ -42,7 +42,6 @@
   do                                                              \
     {                                                             \
       testcase_begin("%s(%s)", func, args);                       \
-      dns_caching_thread_init();          \
       host_resolve_options_defaults(&host_resolve_options);   \
       host_resolve_options_init(&host_resolve_options, &configuration->host_resolve_options);  \
       hostname_reinit(NULL);            \
@@ -53,7 +52,6 @@
   do                                                            \
     {                                                           \
       host_resolve_options_destroy(&host_resolve_options);  \
-      dns_caching_thread_deinit();        \
       testcase_end();                                           \
     }                                                           \
   while (0)
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "logreader.c"
+#include "apphook.h"
+#include "cfg.h"
+
+#define FETCH_LIMIT 10
+#define WINDOW_SIZE 100
+
+static LogReaderOptions reader_options;
+
+static LogReader *
+_create_reader(guint32 flags)
+{
+  LogReader *self = log_reader_new(configuration);
+
+  reader_options.flags = flags;
+  /* log_reader_set_options() would need a LogProtoServer */
+  self->options = &reader_options;
+  log_reader_reset_fetch_budget(self);
+  return self;
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  log_reader_options_defaults(&reader_options);
+  reader_options.fetch_limit = FETCH_LIMIT;
+  reader_options.super.init_window_size = WINDOW_SIZE;
+}
+
+static void
+teardown(void)
+{
+  log_reader_options_destroy(&reader_options);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(logreader, .init = setup, .fini = teardown);
+
+Test(logreader, test_fetch_budget_is_fixed_without_adaptive_fetch_limit)
+{
+  LogReader *reader = _create_reader(0);
+
+  cr_assert_eq(reader->fetch_budget, FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, FETCH_LIMIT);
+
+  log_pipe_unref(&reader->super.super);
+}
+
+Test(logreader, test_fetch_budget_grows_up_to_the_window_size_while_exhausted)
+{
+  LogReader *reader = _create_reader(LR_ADAPTIVE_FETCH_LIMIT);
+
+  log_reader_adapt_fetch_budget(reader, FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, 2 * FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 2 * FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, 4 * FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 4 * FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, 8 * FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 8 * FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, WINDOW_SIZE);
+  log_reader_adapt_fetch_budget(reader, WINDOW_SIZE);
+  cr_assert_eq(reader->fetch_budget, WINDOW_SIZE);
+
+  log_pipe_unref(&reader->super.super);
+}
+
+Test(logreader, test_fetch_budget_shrinks_back_to_fetch_limit_once_caught_up)
+{
+  LogReader *reader = _create_reader(LR_ADAPTIVE_FETCH_LIMIT);
+
+  reader->fetch_budget = 8 * FETCH_LIMIT;
+
+  /* using at least half of the budget keeps it */
+  log_reader_adapt_fetch_budget(reader, 4 * FETCH_LIMIT);
+  cr_assert_eq(reader->fetch_budget, 8 * FETCH_LIMIT);
+
+  log_reader_adapt_fetch_budget(reader, 1);
+  cr_assert_eq(reader->fetch_budget, 4 * FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 0);
+  cr_assert_eq(reader->fetch_budget, 2 * FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 0);
+  cr_assert_eq(reader->fetch_budget, FETCH_LIMIT);
+  log_reader_adapt_fetch_budget(reader, 0);
+  cr_assert_eq(reader->fetch_budget, FETCH_LIMIT);
+
+  log_pipe_unref(&reader->super.super);
+}
+
+Test(logreader, test_fetch_budget_is_reset_when_the_options_change)
+{
+  LogReader *reader = _create_reader(LR_ADAPTIVE_FETCH_LIMIT);
+
+  reader->fetch_budget = WINDOW_SIZE;
+
+  /* as if a reload lowered both limits */
+  reader_options.fetch_limit = 5;
+  reader_options.super.init_window_size = 20;
+  log_reader_reset_fetch_budget(reader);
+  cr_assert_eq(reader->fetch_budget, 5);
+
+  log_reader_adapt_fetch_budget(reader, 5);
+  log_reader_adapt_fetch_budget(reader, 10);
+  log_reader_adapt_fetch_budget(reader, 20);
+  cr_assert_eq(reader->fetch_budget, 20);
+
+  log_pipe_unref(&reader->super.super);
+}
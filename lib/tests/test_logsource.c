@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "logsource.h"
+#include "mainloop-worker.h"
+#include "apphook.h"
+#include "cfg.h"
+
+/* the ack batch is 1/8 of the window */
+#define INIT_WINDOW_SIZE 80
+#define ACK_BATCH_SIZE (INIT_WINDOW_SIZE / 8)
+#define CONSUMED 40
+
+static LogSourceOptions source_options;
+
+static LogSource *
+_create_source(void)
+{
+  LogSource *source = g_new0(LogSource, 1);
+
+  log_source_init_instance(source, configuration);
+  log_source_set_options(source, &source_options, "test_logsource", NULL, FALSE, FALSE, NULL);
+
+  /* messages were posted, their acks are due */
+  window_size_counter_sub(&source->window_size, CONSUMED, NULL);
+  return source;
+}
+
+static gsize
+_window_size(LogSource *source)
+{
+  return window_size_counter_get(&source->window_size, NULL);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  log_source_options_defaults(&source_options);
+  source_options.init_window_size = INIT_WINDOW_SIZE;
+  log_source_options_init(&source_options, configuration, "test_logsource");
+}
+
+static void
+teardown(void)
+{
+  log_source_options_destroy(&source_options);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(logsource, .init = setup, .fini = teardown);
+
+Test(logsource, test_acks_are_returned_to_the_window_at_the_end_of_the_batch)
+{
+  LogSource *source = _create_source();
+
+  main_loop_worker_thread_start(NULL);
+
+  log_source_flow_control_adjust(source, 1);
+  log_source_flow_control_adjust(source, 1);
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED);
+
+  main_loop_worker_invoke_batch_callbacks();
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + 2);
+
+  main_loop_worker_thread_stop();
+  log_pipe_unref(&source->super);
+}
+
+Test(logsource, test_acks_are_returned_to_the_window_once_the_batch_is_full)
+{
+  LogSource *source = _create_source();
+  gint i;
+
+  main_loop_worker_thread_start(NULL);
+
+  for (i = 0; i < ACK_BATCH_SIZE - 1; i++)
+    log_source_flow_control_adjust(source, 1);
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED);
+
+  log_source_flow_control_adjust(source, 1);
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + ACK_BATCH_SIZE);
+
+  main_loop_worker_invoke_batch_callbacks();
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + ACK_BATCH_SIZE);
+
+  main_loop_worker_thread_stop();
+  log_pipe_unref(&source->super);
+}
+
+Test(logsource, test_acks_of_another_source_return_the_pending_ones)
+{
+  LogSource *source = _create_source();
+  LogSource *other_source = _create_source();
+
+  main_loop_worker_thread_start(NULL);
+
+  log_source_flow_control_adjust(source, 1);
+  log_source_flow_control_adjust(other_source, 1);
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + 1);
+  cr_assert_eq(_window_size(other_source), INIT_WINDOW_SIZE - CONSUMED);
+
+  main_loop_worker_invoke_batch_callbacks();
+  cr_assert_eq(_window_size(other_source), INIT_WINDOW_SIZE - CONSUMED + 1);
+
+  main_loop_worker_thread_stop();
+  log_pipe_unref(&source->super);
+  log_pipe_unref(&other_source->super);
+}
+
+Test(logsource, test_suspending_the_source_returns_the_pending_acks_first)
+{
+  LogSource *source = _create_source();
+  gboolean suspended;
+
+  main_loop_worker_thread_start(NULL);
+
+  log_source_flow_control_adjust(source, 1);
+  log_source_flow_control_suspend(source);
+
+  cr_assert_eq(window_size_counter_get(&source->window_size, &suspended), INIT_WINDOW_SIZE - CONSUMED + 1);
+  cr_assert(suspended);
+
+  main_loop_worker_invoke_batch_callbacks();
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + 1);
+
+  main_loop_worker_thread_stop();
+  log_pipe_unref(&source->super);
+}
+
+Test(logsource, test_acks_are_returned_right_away_by_threads_without_worker_id)
+{
+  LogSource *source = _create_source();
+
+  log_source_flow_control_adjust(source, 1);
+  cr_assert_eq(_window_size(source), INIT_WINDOW_SIZE - CONSUMED + 1);
+
+  log_pipe_unref(&source->super);
+}
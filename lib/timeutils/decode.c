@@ -25,6 +25,7 @@
 #include "str-format.h"
 #include "timeutils/timeutils.h"
 #include "timeutils/cache.h"
+#include "tls-support.h"
 
 #include <ctype.h>
 #include <string.h>
@@ -132,10 +133,84 @@ scan_month_abbrev(const gchar **buf, gint *left, gint *mon)
 }
 
 
+static inline gboolean
+_is_digit(gchar c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static inline gint
+_decode_2digits(const gchar *p)
+{
+  return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+/* Fast path for the fixed layout "YYYY-MM-DDTHH:MM:SS", that is what
+ * practically every sender uses.  Anything else (e.g. spaces in place of
+ * leading zeros) is left to the generic scan_int() based code. */
+static gboolean
+_scan_fixed_iso_timestamp(const gchar **buf, gint *left, struct tm *tm)
+{
+  const gchar *p = *buf;
+
+  if (*left < 19 ||
+      !_is_digit(p[0]) || !_is_digit(p[1]) || !_is_digit(p[2]) || !_is_digit(p[3]) || p[4] != '-' ||
+      !_is_digit(p[5]) || !_is_digit(p[6]) || p[7] != '-' ||
+      !_is_digit(p[8]) || !_is_digit(p[9]) || p[10] != 'T' ||
+      !_is_digit(p[11]) || !_is_digit(p[12]) || p[13] != ':' ||
+      !_is_digit(p[14]) || !_is_digit(p[15]) || p[16] != ':' ||
+      !_is_digit(p[17]) || !_is_digit(p[18]))
+    return FALSE;
+
+  tm->tm_year = _decode_2digits(p) * 100 + _decode_2digits(p + 2) - 1900;
+  tm->tm_mon = _decode_2digits(p + 5) - 1;
+  tm->tm_mday = _decode_2digits(p + 8);
+  tm->tm_hour = _decode_2digits(p + 11);
+  tm->tm_min = _decode_2digits(p + 14);
+  tm->tm_sec = _decode_2digits(p + 17);
+
+  *buf += 19;
+  *left -= 19;
+  return TRUE;
+}
+
+/* Same for "MMM DD HH:MM:SS", the day may be padded with a space. */
+static gboolean
+_scan_fixed_bsd_timestamp(const gchar **buf, gint *left, struct tm *tm)
+{
+  const gchar *p = *buf;
+  gint l = *left;
+  gint mon;
+
+  if (l < 15 ||
+      p[3] != ' ' ||
+      !(_is_digit(p[4]) || p[4] == ' ') || !_is_digit(p[5]) || p[6] != ' ' ||
+      !_is_digit(p[7]) || !_is_digit(p[8]) || p[9] != ':' ||
+      !_is_digit(p[10]) || !_is_digit(p[11]) || p[12] != ':' ||
+      !_is_digit(p[13]) || !_is_digit(p[14]))
+    return FALSE;
+
+  if (!scan_month_abbrev(&p, &l, &mon))
+    return FALSE;
+
+  tm->tm_mon = mon;
+  tm->tm_mday = p[1] == ' ' ? p[2] - '0' : _decode_2digits(p + 1);
+  tm->tm_hour = _decode_2digits(p + 4);
+  tm->tm_min = _decode_2digits(p + 7);
+  tm->tm_sec = _decode_2digits(p + 10);
+
+  *buf += 15;
+  *left -= 15;
+  return TRUE;
+}
+
 /* this function parses the date/time portion of an ISODATE */
 gboolean
 scan_iso_timestamp(const gchar **buf, gint *left, struct tm *tm)
 {
+  if (_scan_fixed_iso_timestamp(buf, left, tm))
+    return TRUE;
+
   /* YYYY-MM-DDTHH:MM:SS */
   if (!scan_int(buf, left, 4, &tm->tm_year) ||
       !scan_expect_char(buf, left, '-') ||
@@ -199,6 +274,9 @@ gboolean
 scan_bsd_timestamp(const gchar **buf, gint *left, struct tm *tm)
 {
   /* RFC 3164 timestamp, expected format: MMM DD HH:MM:SS ... */
+  if (_scan_fixed_bsd_timestamp(buf, left, tm))
+    return TRUE;
+
   if (!scan_month_abbrev(buf, left, &tm->tm_mon) ||
       !scan_expect_char(buf, left, ' ') ||
       !scan_int(buf, left, 2, &tm->tm_mday) ||
@@ -475,6 +553,147 @@ __parse_bsd_timestamp(const guchar **data, gint *length, const GTimeVal *now, st
   return TRUE;
 }
 
+/*******************************************************************************
+ * Cache of converted timestamps
+ *******************************************************************************/
+
+/* Consecutive messages almost always carry the same second, so the
+ * result of the conversion (cached_localtime(), mktime() and zone offset
+ * lookups) is memoized per thread for the last few distinct second
+ * prefixes ("YYYY-MM-DDTHH:MM:SS" or "MMM DD HH:MM:SS").  The fractions
+ * and the zone are decoded for every message, the zone being part of the
+ * key.  The year of BSD timestamps is deduced from the current time, so
+ * entries are only reused within the same minute.  */
+
+#define PARSED_STAMP_CACHE_SIZE 4
+#define PARSED_STAMP_MAX_PREFIX 19
+
+typedef struct _ParsedStampCacheEntry
+{
+  gchar prefix[PARSED_STAMP_MAX_PREFIX];
+  gint prefix_len;
+  gint32 zone_offset_in;
+  glong recv_timezone_ofs;
+  time_t now_minute;
+  time_t tv_sec;
+  glong zone_offset;
+} ParsedStampCacheEntry;
+
+TLS_BLOCK_START
+{
+  ParsedStampCacheEntry parsed_stamp_cache[PARSED_STAMP_CACHE_SIZE];
+  guint parsed_stamp_cache_next;
+}
+TLS_BLOCK_END;
+
+#define parsed_stamp_cache      __tls_deref(parsed_stamp_cache)
+#define parsed_stamp_cache_next __tls_deref(parsed_stamp_cache_next)
+
+static ParsedStampCacheEntry *
+__lookup_parsed_stamp(const guchar *prefix, gint prefix_len, gint32 zone_offset_in, glong recv_timezone_ofs,
+                      time_t now)
+{
+  gint i;
+
+  for (i = 0; i < PARSED_STAMP_CACHE_SIZE; i++)
+    {
+      ParsedStampCacheEntry *entry = &parsed_stamp_cache[i];
+
+      if (entry->prefix_len == prefix_len &&
+          entry->zone_offset_in == zone_offset_in &&
+          entry->recv_timezone_ofs == recv_timezone_ofs &&
+          entry->now_minute == now / 60 &&
+          memcmp(entry->prefix, prefix, prefix_len) == 0)
+        return entry;
+    }
+  return NULL;
+}
+
+static void
+__store_parsed_stamp(const guchar *prefix, gint prefix_len, gint32 zone_offset_in, glong recv_timezone_ofs,
+                     time_t now, const LogStamp *stamp)
+{
+  ParsedStampCacheEntry *entry;
+
+  if (prefix_len == 0)
+    return;
+
+  entry = &parsed_stamp_cache[parsed_stamp_cache_next];
+  parsed_stamp_cache_next = (parsed_stamp_cache_next + 1) % PARSED_STAMP_CACHE_SIZE;
+
+  memcpy(entry->prefix, prefix, prefix_len);
+  entry->prefix_len = prefix_len;
+  entry->zone_offset_in = zone_offset_in;
+  entry->recv_timezone_ofs = recv_timezone_ofs;
+  entry->now_minute = now / 60;
+  entry->tv_sec = stamp->tv_sec;
+  entry->zone_offset = stamp->zone_offset;
+}
+
+/* returns the length of the second prefix that identifies a cacheable
+ * timestamp, 0 if the timestamp is in a format that is not cached */
+static gint
+__get_cacheable_prefix_len(const guchar *src, gint left, gboolean allow_bsd, gboolean *iso)
+{
+  *iso = __is_iso_stamp((const gchar *) src, left);
+  if (*iso)
+    return 19;
+
+  if (allow_bsd &&
+      __is_bsd_rfc_3164(src, left) && !__is_bsd_linksys(src, left) && !__is_bsd_pix_or_asa(src, left))
+    return 15;
+  return 0;
+}
+
+static gboolean
+__scan_cached_timestamp(const guchar **data, gint *length, gboolean allow_bsd, LogStamp *stamp, time_t now,
+                        glong recv_timezone_ofs)
+{
+  const guchar *src = *data;
+  gint left = *length;
+  gboolean iso;
+  gint prefix_len = __get_cacheable_prefix_len(src, left, allow_bsd, &iso);
+  gint32 zone_offset_in = stamp->zone_offset;
+  ParsedStampCacheEntry *entry;
+  guint32 usec;
+
+  if (prefix_len == 0)
+    return FALSE;
+
+  src += prefix_len;
+  left -= prefix_len;
+  usec = __parse_usec(&src, &left);
+
+  if (iso)
+    {
+      if (left > 0 && *src == 'Z')
+        {
+          zone_offset_in = 0;
+          src++;
+          left--;
+        }
+      else if (__has_iso_timezone(src, left))
+        {
+          zone_offset_in = __parse_iso_timezone(&src, &left);
+        }
+      else
+        {
+          zone_offset_in = -1;
+        }
+    }
+
+  entry = __lookup_parsed_stamp(*data, prefix_len, zone_offset_in, recv_timezone_ofs, now);
+  if (!entry)
+    return FALSE;
+
+  stamp->tv_sec = entry->tv_sec;
+  stamp->tv_usec = usec;
+  stamp->zone_offset = entry->zone_offset;
+  *data = src;
+  *length = left;
+  return TRUE;
+}
+
 gboolean
 scan_rfc3164_timestamp(const guchar **data, gint *length,
                        LogStamp *stamp,
@@ -484,22 +703,35 @@ scan_rfc3164_timestamp(const guchar **data, gint *length,
   const guchar *src = *data;
   gint left = *length;
   struct tm tm;
+  gboolean iso;
+  gint32 zone_offset_in;
 
   cached_g_current_time(&now);
 
-  /* If the next chars look like a date, then read them as a date. */
-  if (__is_iso_stamp((const gchar *)src, left))
+  if (ignore_result || !__scan_cached_timestamp(&src, &left, TRUE, stamp, now.tv_sec, recv_timezone_ofs))
     {
-      if (!__parse_iso_stamp(&now, stamp, &tm, &src, &left))
-        return FALSE;
-    }
-  else
-    {
-      glong usec = 0;
-      if (!__parse_bsd_timestamp(&src, &left, &now, &tm, &usec))
-        return FALSE;
+      /* If the next chars look like a date, then read them as a date. */
+      if (__is_iso_stamp((const gchar *)src, left))
+        {
+          if (!__parse_iso_stamp(&now, stamp, &tm, &src, &left))
+            return FALSE;
+        }
+      else
+        {
+          glong usec = 0;
+          if (!__parse_bsd_timestamp(&src, &left, &now, &tm, &usec))
+            return FALSE;
+
+          stamp->tv_usec = usec;
+        }
 
-      stamp->tv_usec = usec;
+      if (!ignore_result)
+        {
+          zone_offset_in = stamp->zone_offset;
+          __fixup_hour_in_struct_tm_within_transition_periods(stamp, &tm, recv_timezone_ofs);
+          __store_parsed_stamp(*data, __get_cacheable_prefix_len(*data, *length, TRUE, &iso),
+                               zone_offset_in, recv_timezone_ofs, now.tv_sec, stamp);
+        }
     }
 
   /* we might have a closing colon at the end of the timestamp, "Cisco" I am
@@ -512,9 +744,6 @@ scan_rfc3164_timestamp(const guchar **data, gint *length,
       --left;
     }
 
-  if (!ignore_result)
-    __fixup_hour_in_struct_tm_within_transition_periods(stamp, &tm, recv_timezone_ofs);
-
   *data = src;
   *length = left;
   return TRUE;
@@ -529,6 +758,8 @@ scan_rfc5424_timestamp(const guchar **data, gint *length,
   const guchar *src = *data;
   gint left = *length;
   struct tm tm;
+  gboolean iso;
+  gint32 zone_offset_in;
 
   cached_g_current_time(&now);
 
@@ -540,10 +771,19 @@ scan_rfc5424_timestamp(const guchar **data, gint *length,
       src++;
       left--;
     }
+  else if (!ignore_result && __scan_cached_timestamp(&src, &left, FALSE, stamp, now.tv_sec, recv_timezone_ofs))
+    {
+      ;
+    }
   else if (__parse_iso_stamp(&now, stamp, &tm, &src, &left))
     {
       if (!ignore_result)
-        __fixup_hour_in_struct_tm_within_transition_periods(stamp, &tm, recv_timezone_ofs);
+        {
+          zone_offset_in = stamp->zone_offset;
+          __fixup_hour_in_struct_tm_within_transition_periods(stamp, &tm, recv_timezone_ofs);
+          __store_parsed_stamp(*data, __get_cacheable_prefix_len(*data, *length, FALSE, &iso),
+                               zone_offset_in, recv_timezone_ofs, now.tv_sec, stamp);
+        }
     }
   else
     return FALSE;
@@ -295,6 +295,24 @@ Test(parse_timestamp, rfc5424_timestamps)
   _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27Z", "2017-06-14T23:57:27.000+00:00");
 }
 
+Test(parse_timestamp, repeated_timestamps_keep_their_own_fractions_and_timezones)
+{
+  /* the second and later timestamps hit the per-thread cache of the date part */
+  _expect_rfc3164_timestamp_eq("Dec 13 09:10:12.987", "2017-12-13T09:10:12.987+01:00");
+  _expect_rfc3164_timestamp_eq("Dec 13 09:10:12.123", "2017-12-13T09:10:12.123+01:00");
+  _expect_rfc3164_timestamp_eq("Dec 13 09:10:12", "2017-12-13T09:10:12.000+01:00");
+
+  _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27.100+02:00", "2017-06-14T23:57:27.100+02:00");
+  _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27.200+02:00", "2017-06-14T23:57:27.200+02:00");
+  _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27-05:00", "2017-06-14T23:57:27.000-05:00");
+  _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27Z", "2017-06-14T23:57:27.000+00:00");
+
+  /* an ISO timestamp is not a valid RFC5424 one just because it was seen
+   * by the RFC3164 parser before */
+  _expect_rfc3164_timestamp_eq("2017-06-14T23:57:27+02:00", "2017-06-14T23:57:27.000+02:00");
+  _expect_rfc5424_timestamp_eq("2017-06-14T23:57:27+02:00", "2017-06-14T23:57:27.000+02:00");
+}
+
 
 void
 setup(void)
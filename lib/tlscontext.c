@@ -26,6 +26,8 @@
 #include "messages.h"
 #include "compat/openssl_support.h"
 #include "secret-storage/secret-storage.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
 
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -56,6 +58,16 @@ struct _TLSContext
   GList *trusted_dn_list;
   gint ssl_options;
   gchar *location;
+
+  gint session_cache_size;
+  gint session_timeout;
+  gboolean session_tickets;
+  gboolean ktls;
+  /* client mode: the last session received from the server, offered on reconnect */
+  GStaticMutex client_session_lock;
+  SSL_SESSION *client_session;
+  StatsCounterItem *full_handshakes;
+  StatsCounterItem *resumed_handshakes;
 };
 
 typedef enum
@@ -291,10 +303,26 @@ tls_session_set_verifier(TLSSession *self, TLSVerifier *verifier)
   self->verifier = verifier ? tls_verifier_ref(verifier) : NULL;
 }
 
+static void
+tls_session_count_handshake(TLSSession *self, const SSL *ssl)
+{
+  if (self->handshake_counted)
+    return;
+
+  self->handshake_counted = TRUE;
+  if (SSL_session_reused((SSL *) ssl))
+    stats_counter_inc(self->ctx->resumed_handshakes);
+  else
+    stats_counter_inc(self->ctx->full_handshakes);
+}
+
 void
 tls_session_info_callback(const SSL *ssl, int where, int ret)
 {
   TLSSession *self = (TLSSession *)SSL_get_app_data(ssl);
+
+  if (where & SSL_CB_HANDSHAKE_DONE)
+    tls_session_count_handshake(self, ssl);
   if( !self->peer_info.found && where == (SSL_ST_ACCEPT|SSL_CB_LOOP) )
     {
       X509 *cert = SSL_get_peer_certificate(ssl);
@@ -665,6 +693,114 @@ tls_context_load_key_and_cert(TLSContext *self)
   return TLS_CONTEXT_OK;
 }
 
+/* NOTE: called by OpenSSL in client mode whenever the server hands out a new session */
+static int
+tls_context_new_client_session_cb(SSL *ssl, SSL_SESSION *session)
+{
+  TLSSession *tls_session = (TLSSession *) SSL_get_app_data(ssl);
+  TLSContext *self = tls_session->ctx;
+
+  g_static_mutex_lock(&self->client_session_lock);
+  if (self->client_session)
+    SSL_SESSION_free(self->client_session);
+  self->client_session = session;
+  g_static_mutex_unlock(&self->client_session_lock);
+
+  /* we keep the reference */
+  return 1;
+}
+
+static void
+tls_context_setup_session_cache(TLSContext *self)
+{
+  if (self->mode == TM_CLIENT)
+    {
+      /* the internal store is keyed by session id, which is only useful for servers */
+      if (self->session_cache_size != 0)
+        {
+          SSL_CTX_set_session_cache_mode(self->ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+          SSL_CTX_sess_set_new_cb(self->ssl_ctx, tls_context_new_client_session_cb);
+        }
+    }
+  else
+    {
+      if (self->session_cache_size == 0)
+        SSL_CTX_set_session_cache_mode(self->ssl_ctx, SSL_SESS_CACHE_OFF);
+      else if (self->session_cache_size > 0)
+        SSL_CTX_sess_set_cache_size(self->ssl_ctx, self->session_cache_size);
+    }
+
+  if (self->session_timeout > 0)
+    SSL_CTX_set_timeout(self->ssl_ctx, self->session_timeout);
+
+  if (!self->session_tickets)
+    SSL_CTX_set_options(self->ssl_ctx, SSL_OP_NO_TICKET);
+}
+
+static void
+tls_context_setup_ktls(TLSContext *self)
+{
+  if (!self->ktls)
+    return;
+
+#ifdef SSL_OP_ENABLE_KTLS
+  SSL_CTX_set_options(self->ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+  msg_warning("WARNING: ktls() is not supported by the OpenSSL library syslog-ng was compiled against, "
+              "falling back to user space encryption",
+              tls_context_format_location_tag(self));
+#endif
+}
+
+static void
+tls_context_format_stats_key(TLSContext *self, StatsClusterKey *sc_key, const gchar *name)
+{
+  stats_cluster_single_key_set_with_name(sc_key, SCS_GLOBAL, self->mode == TM_CLIENT ? "tls_client" : "tls_server",
+                                         self->location, name);
+}
+
+static void
+tls_context_register_counters(TLSContext *self)
+{
+  StatsClusterKey sc_key;
+
+  if (self->full_handshakes)
+    return;
+
+  stats_lock();
+  tls_context_format_stats_key(self, &sc_key, "full_handshakes");
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->full_handshakes);
+  tls_context_format_stats_key(self, &sc_key, "resumed_handshakes");
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->resumed_handshakes);
+  stats_unlock();
+}
+
+static void
+tls_context_unregister_counters(TLSContext *self)
+{
+  StatsClusterKey sc_key;
+
+  if (!self->full_handshakes)
+    return;
+
+  stats_lock();
+  tls_context_format_stats_key(self, &sc_key, "full_handshakes");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->full_handshakes);
+  tls_context_format_stats_key(self, &sc_key, "resumed_handshakes");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->resumed_handshakes);
+  stats_unlock();
+}
+
+gboolean
+tls_session_is_ktls_send_active(TLSSession *self)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+  return BIO_get_ktls_send(SSL_get_wbio(self->ssl)) > 0;
+#else
+  return FALSE;
+#endif
+}
+
 TLSContextSetupResult
 tls_context_setup_context(TLSContext *self)
 {
@@ -720,6 +856,10 @@ tls_context_setup_context(TLSContext *self)
         goto error;
     }
 
+  tls_context_setup_session_cache(self);
+  tls_context_setup_ktls(self);
+  tls_context_register_counters(self);
+
   return TLS_CONTEXT_SETUP_OK;
 
 error:
@@ -744,7 +884,15 @@ tls_context_setup_session(TLSContext *self)
   SSL *ssl = SSL_new(self->ssl_ctx);
 
   if (self->mode == TM_CLIENT)
-    SSL_set_connect_state(ssl);
+    {
+      SSL_set_connect_state(ssl);
+
+      /* try to resume the previous session, falls back to a full handshake if the server has forgotten it */
+      g_static_mutex_lock(&self->client_session_lock);
+      if (self->client_session)
+        SSL_set_session(ssl, self->client_session);
+      g_static_mutex_unlock(&self->client_session_lock);
+    }
   else
     SSL_set_accept_state(ssl);
 
@@ -764,6 +912,10 @@ tls_context_new(TLSMode mode, const gchar *location)
   self->verify_mode = TVM_REQUIRED | TVM_TRUSTED;
   self->ssl_options = TSO_NOSSLv2;
   self->location = g_strdup(location ? : "n/a");
+  self->session_cache_size = -1;
+  self->session_timeout = -1;
+  self->session_tickets = TRUE;
+  g_static_mutex_init(&self->client_session_lock);
 
   if (self->mode == TM_CLIENT)
     self->ssl_ctx = SSL_CTX_new(SSLv23_client_method());
@@ -779,6 +931,10 @@ tls_context_new(TLSMode mode, const gchar *location)
 static void
 _tls_context_free(TLSContext *self)
 {
+  tls_context_unregister_counters(self);
+  if (self->client_session)
+    SSL_SESSION_free(self->client_session);
+  g_static_mutex_free(&self->client_session_lock);
   g_free(self->location);
   SSL_CTX_free(self->ssl_ctx);
   g_list_foreach(self->trusted_fingerprint_list, (GFunc) g_free, NULL);
@@ -992,6 +1148,30 @@ tls_context_set_ecdh_curve_list(TLSContext *self, const gchar *ecdh_curve_list)
   self->ecdh_curve_list = g_strdup(ecdh_curve_list);
 }
 
+void
+tls_context_set_session_cache_size(TLSContext *self, gint session_cache_size)
+{
+  self->session_cache_size = session_cache_size;
+}
+
+void
+tls_context_set_session_timeout(TLSContext *self, gint session_timeout)
+{
+  self->session_timeout = session_timeout;
+}
+
+void
+tls_context_set_session_tickets(TLSContext *self, gboolean session_tickets)
+{
+  self->session_tickets = session_tickets;
+}
+
+void
+tls_context_set_ktls(TLSContext *self, gboolean ktls)
+{
+  self->ktls = ktls;
+}
+
 void
 tls_context_set_dhparam_file(TLSContext *self, const gchar *dhparam_file)
 {
@@ -89,12 +89,14 @@ typedef struct _TLSSession
     gchar ou[X509_MAX_OU_LEN];
     gchar cn[X509_MAX_CN_LEN];
   } peer_info;
+  gboolean handshake_counted;
 } TLSSession;
 
 #define TMI_ALLOW_COMPRESS 0x1
 
 void tls_session_set_verifier(TLSSession *self, TLSVerifier *verifier);
 void tls_session_free(TLSSession *self);
+gboolean tls_session_is_ktls_send_active(TLSSession *self);
 
 TLSContextSetupResult tls_context_setup_context(TLSContext *self);
 TLSSession *tls_context_setup_session(TLSContext *self);
@@ -123,6 +125,10 @@ void tls_context_set_crl_dir(TLSContext *self, const gchar *crl_dir);
 void tls_context_set_cipher_suite(TLSContext *self, const gchar *cipher_suite);
 void tls_context_set_ecdh_curve_list(TLSContext *self, const gchar *ecdh_curve_list);
 void tls_context_set_dhparam_file(TLSContext *self, const gchar *dhparam_file);
+void tls_context_set_session_cache_size(TLSContext *self, gint session_cache_size);
+void tls_context_set_session_timeout(TLSContext *self, gint session_timeout);
+void tls_context_set_session_tickets(TLSContext *self, gboolean session_tickets);
+void tls_context_set_ktls(TLSContext *self, gboolean ktls);
 const gchar *tls_context_get_key_file(TLSContext *self);
 EVTTAG *tls_context_format_tls_error_tag(TLSContext *self);
 EVTTAG *tls_context_format_location_tag(TLSContext *self);
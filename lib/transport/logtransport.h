@@ -37,6 +37,10 @@ struct _LogTransport
   const gchar *name;
   gssize (*read)(LogTransport *self, gpointer buf, gsize count, LogTransportAuxData *aux);
   gssize (*write)(LogTransport *self, const gpointer buf, gsize count);
+  /* optional, performs session setup (e.g. TLS handshake) ahead of the
+   * first read, returns FALSE with errno set to EAGAIN if it needs to
+   * wait for the I/O direction in cond */
+  gboolean (*handshake)(LogTransport *self);
   void (*free_fn)(LogTransport *self);
 };
 
@@ -52,6 +56,14 @@ log_transport_read(LogTransport *self, gpointer buf, gsize count, LogTransportAu
   return self->read(self, buf, count, aux);
 }
 
+static inline gboolean
+log_transport_handshake(LogTransport *self)
+{
+  if (!self->handshake)
+    return TRUE;
+  return self->handshake(self);
+}
+
 void log_transport_init_instance(LogTransport *s, gint fd);
 void log_transport_free_method(LogTransport *s);
 void log_transport_free(LogTransport *s);
@@ -122,6 +122,16 @@ _multitransport_read(LogTransport *s, gpointer buf, gsize count, LogTransportAux
   return r;
 }
 
+static gboolean
+_multitransport_handshake(LogTransport *s)
+{
+  MultiTransport *self = (MultiTransport *)s;
+  gboolean r = log_transport_handshake(self->active_transport);
+  self->super.cond = self->active_transport->cond;
+
+  return r;
+}
+
 static void
 _multitransport_free(LogTransport *s)
 {
@@ -142,6 +152,7 @@ multitransport_new(TransportFactory *default_transport_factory, gint fd)
   log_transport_init_instance(&self->super, fd);
   self->super.read = _multitransport_read;
   self->super.write = _multitransport_write;
+  self->super.handshake = _multitransport_handshake;
   self->super.free_fn = _multitransport_free;
   self->active_transport = transport_factory_construct_transport(default_transport_factory, fd);
   self->active_transport_factory = default_transport_factory;
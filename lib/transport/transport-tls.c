@@ -28,13 +28,47 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <errno.h>
+#include <unistd.h>
 
 typedef struct _LogTransportTLS
 {
   LogTransport super;
   TLSSession *tls_session;
+  /* the kernel encrypts outgoing records, write() to the socket directly */
+  gboolean ktls_send;
+  gboolean ktls_probed;
+  /* SSL_write() must be retried with the same buffer after WANT_READ/WANT_WRITE */
+  gboolean write_retry_pending;
 } LogTransportTLS;
 
+static void
+log_transport_tls_probe_ktls(LogTransportTLS *self)
+{
+  if (self->ktls_probed || !SSL_is_init_finished(self->tls_session->ssl))
+    return;
+
+  self->ktls_probed = TRUE;
+  self->ktls_send = tls_session_is_ktls_send_active(self->tls_session);
+  msg_debug(self->ktls_send ? "TLS session offloaded to kTLS" : "TLS session not offloaded to kTLS",
+            evt_tag_int("fd", self->super.fd),
+            tls_context_format_location_tag(self->tls_session->ctx));
+}
+
+static gssize
+log_transport_tls_write_ktls(LogTransportTLS *self, const gpointer buf, gsize buflen)
+{
+  gssize rc;
+
+  do
+    {
+      rc = write(self->super.fd, buf, buflen);
+    }
+  while (rc == -1 && errno == EINTR);
+
+  self->super.cond = (rc < 0 && errno == EAGAIN) ? G_IO_OUT : 0;
+  return rc;
+}
+
 static gssize
 log_transport_tls_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
 {
@@ -111,8 +145,16 @@ log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen
 
   self->super.cond = G_IO_OUT;
 
+  if (!self->write_retry_pending)
+    {
+      log_transport_tls_probe_ktls(self);
+      if (self->ktls_send)
+        return log_transport_tls_write_ktls(self, buf, buflen);
+    }
+
   rc = SSL_write(self->tls_session->ssl, buf, buflen);
 
+  self->write_retry_pending = FALSE;
   if (rc < 0)
     {
       ssl_error = SSL_get_error(self->tls_session->ssl, rc);
@@ -122,9 +164,11 @@ log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen
           /* although we are writing this fd, libssl wants to read. This
            * happens during renegotiation for example */
           self->super.cond = G_IO_IN;
+          self->write_retry_pending = TRUE;
           errno = EAGAIN;
           break;
         case SSL_ERROR_WANT_WRITE:
+          self->write_retry_pending = TRUE;
           errno = EAGAIN;
           break;
         case SSL_ERROR_SYSCALL:
@@ -152,6 +196,49 @@ tls_error:
   return -1;
 }
 
+static gboolean
+log_transport_tls_handshake_method(LogTransport *s)
+{
+  LogTransportTLS *self = (LogTransportTLS *) s;
+  gint ssl_error;
+  gint rc;
+
+  self->super.cond = G_IO_IN;
+
+  errno = 0;
+  rc = SSL_do_handshake(self->tls_session->ssl);
+  if (rc == 1)
+    {
+      self->super.cond = 0;
+      log_transport_tls_probe_ktls(self);
+      return TRUE;
+    }
+
+  ssl_error = SSL_get_error(self->tls_session->ssl, rc);
+  switch (ssl_error)
+    {
+    case SSL_ERROR_WANT_READ:
+      errno = EAGAIN;
+      break;
+    case SSL_ERROR_WANT_WRITE:
+      self->super.cond = G_IO_OUT;
+      errno = EAGAIN;
+      break;
+    case SSL_ERROR_SYSCALL:
+      /* errno is set accordingly, unless the peer closed the connection */
+      if (errno == 0)
+        errno = ECONNRESET;
+      break;
+    default:
+      msg_error("SSL error during handshake",
+                tls_context_format_tls_error_tag(self->tls_session->ctx),
+                tls_context_format_location_tag(self->tls_session->ctx));
+      ERR_clear_error();
+      errno = ECONNRESET;
+      break;
+    }
+  return FALSE;
+}
 
 static void log_transport_tls_free_method(LogTransport *s);
 
@@ -164,6 +251,7 @@ log_transport_tls_new(TLSSession *tls_session, gint fd)
   self->super.cond = G_IO_IN | G_IO_OUT;
   self->super.read = log_transport_tls_read_method;
   self->super.write = log_transport_tls_write_method;
+  self->super.handshake = log_transport_tls_handshake_method;
   self->super.free_fn = log_transport_tls_free_method;
   self->tls_session = tls_session;
 
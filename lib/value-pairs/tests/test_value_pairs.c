@@ -276,6 +276,107 @@ Test(value_pairs, test_transformer_shift_levels)
   g_ptr_array_free(transformers, TRUE);
 }
 
+static gboolean
+vp_values_foreach(const gchar *name, TypeHint type, const gchar *value,
+                  gsize value_len, gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  cr_expect_eq(strlen(value), value_len, "value of %s is not NUL terminated at its length", name);
+  if (result->len > 0)
+    g_string_append_c(result, ',');
+  g_string_append_printf(result, "%s=%s", name, value);
+  return FALSE;
+}
+
+Test(value_pairs, test_pairs_are_evaluated_after_merging_keys)
+{
+  ValuePairs *vp = value_pairs_new();
+  LogMessage *msg = create_message();
+  GString *result = g_string_new("");
+  LogTemplate *template;
+
+  value_pairs_add_glob_pattern(vp, "PROGRAM", TRUE);
+  value_pairs_add_glob_pattern(vp, "PID", TRUE);
+
+  /* overrides the builtin */
+  template = create_template("string", "prog-$PID");
+  value_pairs_add_pair(vp, "PROGRAM", template);
+  log_template_unref(template);
+
+  /* identical templates */
+  template = create_template("string", "$HOST/$PID");
+  value_pairs_add_pair(vp, "a", template);
+  log_template_unref(template);
+  template = create_template("string", "$HOST/$PID");
+  value_pairs_add_pair(vp, "b", template);
+  log_template_unref(template);
+
+  /* trivial template */
+  template = create_template("string", "${.SDATA.meta.sequenceId}");
+  value_pairs_add_pair(vp, "c", template);
+  log_template_unref(template);
+
+  value_pairs_foreach(vp, vp_values_foreach, msg, 11, LTZ_LOCAL, &template_options, result);
+  cr_expect_str_eq(result->str,
+                   "PID=20208,PROGRAM=prog-20208,"
+                   "a=exchange.macartney.esbjerg/20208,b=exchange.macartney.esbjerg/20208,"
+                   "c=191732");
+
+  g_string_free(result, TRUE);
+  log_msg_unref(msg);
+  value_pairs_unref(vp);
+}
+
+static gboolean
+vp_values_changing_message_foreach(const gchar *name, TypeHint type, const gchar *value,
+                                   gsize value_len, gpointer user_data)
+{
+  gpointer *args = (gpointer *) user_data;
+  LogMessage *msg = (LogMessage *) args[0];
+  GString *result = (GString *) args[1];
+  gint i;
+
+  /* similar to what map-value-pairs() does, values are set in the same message */
+  for (i = 0; i < 64; i++)
+    {
+      gchar new_name[32];
+
+      g_snprintf(new_name, sizeof(new_name), "vp.new%d", i);
+      log_msg_set_value_by_name(msg, new_name, "a value that makes the payload grow", -1);
+    }
+  log_msg_set_value_by_name(msg, "vp.x", "changed-by-callback", -1);
+
+  return vp_values_foreach(name, type, value, value_len, result);
+}
+
+Test(value_pairs, test_values_are_evaluated_before_the_callback_changes_the_message)
+{
+  ValuePairs *vp = value_pairs_new();
+  LogMessage *msg = create_message();
+  GString *result = g_string_new("");
+  LogTemplate *template;
+  gpointer args[] = { msg, result };
+
+  log_msg_set_value_by_name(msg, "vp.x", "original", -1);
+  value_pairs_add_glob_pattern(vp, "vp.x", TRUE);
+
+  template = create_template("string", "static");
+  value_pairs_add_pair(vp, "a", template);
+  log_template_unref(template);
+
+  template = create_template("string", "${vp.x}-$PID");
+  value_pairs_add_pair(vp, "z", template);
+  log_template_unref(template);
+
+  value_pairs_foreach(vp, vp_values_changing_message_foreach, msg, 11, LTZ_LOCAL, &template_options, args);
+  cr_expect_str_eq(result->str, "a=static,vp.x=original,z=original-20208");
+
+  g_string_free(result, TRUE);
+  log_msg_unref(msg);
+  value_pairs_unref(vp);
+}
+
 GlobalConfig *cfg;
 
 void
@@ -46,14 +46,52 @@ typedef struct
   LogTemplate *template;
 } VPPairConf;
 
+enum
+{
+  VPT_MACRO,
+  VPT_NVPAIR,
+};
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *alt_name;
+  gint type;
+  gint id;
+} ValuePairSpec;
+
+typedef enum
+{
+  /* value points to a scratch buffer */
+  VPR_VALUE,
+  /* value points into the payload of the message */
+  VPR_NVPAIR,
+  VPR_BUILTIN,
+  VPR_PAIR,
+} VPResultValueType;
+
 typedef struct
 {
   /* we don't own any of the fields here, it is assumed that allocations are
    * managed by the caller */
 
   GString *name;
-  GString *value;
   TypeHint type_hint;
+
+  /* Builtins and explicit pairs are only recorded here and are evaluated
+   * once the final set of keys is known (e.g.  after duplicates were
+   * resolved), see vp_results_evaluate(). */
+  VPResultValueType type;
+  union
+  {
+    struct
+    {
+      const gchar *str;
+      gssize len;
+    } value;
+    ValuePairSpec *spec;
+    VPPairConf *vpc;
+  };
 } VPResultValue;
 
 typedef struct
@@ -62,6 +100,12 @@ typedef struct
 
   /* array of VPResultValue instances */
   GArray *values;
+
+  /* arguments needed to evaluate builtins and pairs */
+  LogMessage *msg;
+  gint32 seq_num;
+  gint time_zone_mode;
+  const LogTemplateOptions *template_options;
 } VPResults;
 
 struct _ValuePairs
@@ -88,20 +132,6 @@ typedef enum
   VPS_EVERYTHING      = 0x7f,
 } ValuePairScope;
 
-enum
-{
-  VPT_MACRO,
-  VPT_NVPAIR,
-};
-
-typedef struct
-{
-  const gchar *name;
-  const gchar *alt_name;
-  gint type;
-  gint id;
-} ValuePairSpec;
-
 static ValuePairSpec rfc3164[] =
 {
   /* there's one macro named DATE that'll be expanded specially */
@@ -190,14 +220,6 @@ vp_pair_conf_free(VPPairConf *vpc)
   g_free(vpc);
 }
 
-static void
-vp_result_value_init(VPResultValue *rv, GString *name, TypeHint type_hint, GString *value)
-{
-  rv->type_hint = type_hint;
-  rv->name = name;
-  rv->value = value;
-}
-
 static void
 vp_results_init(VPResults *results, GCompareFunc compare_func)
 {
@@ -213,17 +235,99 @@ vp_results_deinit(VPResults *results)
   g_array_free(results->values, TRUE);
 }
 
-static void
-vp_results_insert(VPResults *results, GString *name, TypeHint type_hint, GString *value)
+static VPResultValue *
+vp_results_insert(VPResults *results, GString *name, TypeHint type_hint, VPResultValueType type)
 {
   VPResultValue *rv;
   gint ndx = results->values->len;
 
   g_array_set_size(results->values, ndx + 1);
   rv = &g_array_index(results->values, VPResultValue, ndx);
-  vp_result_value_init(rv, name, type_hint, value);
+  rv->name = name;
+  rv->type_hint = type_hint;
+  rv->type = type;
   /* GTree takes over ownership of name */
   g_tree_insert(results->result_tree, name->str, GINT_TO_POINTER(ndx));
+  return rv;
+}
+
+static void
+vp_results_insert_value(VPResults *results, GString *name, TypeHint type_hint, VPResultValueType type,
+                        const gchar *value, gssize value_len)
+{
+  VPResultValue *rv = vp_results_insert(results, name, type_hint, type);
+
+  rv->value.str = value;
+  rv->value.len = value_len;
+}
+
+static void
+vp_results_format_builtin(VPResults *results, ValuePairSpec *spec, GString *result)
+{
+  switch (spec->type)
+    {
+    case VPT_MACRO:
+      log_macro_expand(result, spec->id, FALSE,
+                       results->template_options, results->time_zone_mode, results->seq_num, NULL, results->msg);
+      break;
+    case VPT_NVPAIR:
+    {
+      const gchar *nv;
+      gssize len;
+
+      nv = log_msg_get_value(results->msg, (NVHandle) spec->id, &len);
+      g_string_append_len(result, nv, len);
+      break;
+    }
+    default:
+      g_assert_not_reached();
+    }
+}
+
+/* Formats the value of a key that survived merging into a scratch buffer.
+ * Values referenced from the message are copied too, just like formatted
+ * ones, as the callback is free to change the message. */
+static gboolean
+vp_results_evaluate_value(const gchar *name, gpointer ndx_as_pointer, gpointer user_data)
+{
+  VPResults *results = (VPResults *) user_data;
+  VPResultValue *rv = &g_array_index(results->values, VPResultValue, GPOINTER_TO_INT(ndx_as_pointer));
+  GString *sb;
+
+  switch (rv->type)
+    {
+    case VPR_VALUE:
+      return FALSE;
+    case VPR_NVPAIR:
+      sb = scratch_buffers_alloc();
+      g_string_append_len(sb, rv->value.str, rv->value.len);
+      break;
+    case VPR_BUILTIN:
+      sb = scratch_buffers_alloc();
+      vp_results_format_builtin(results, rv->spec, sb);
+      break;
+    case VPR_PAIR:
+      sb = scratch_buffers_alloc();
+      log_template_append_format(rv->vpc->template, results->msg,
+                                 results->template_options,
+                                 results->time_zone_mode, results->seq_num, NULL, sb);
+      break;
+    default:
+      g_assert_not_reached();
+    }
+  rv->value.str = sb->str;
+  rv->value.len = sb->len;
+  return FALSE;
+}
+
+/* All values are evaluated before the first callback is invoked: callbacks
+ * may change the message (e.g.  map-value-pairs() or groupset() work on
+ * the same message), which could move the values referenced from its
+ * payload or change what a template evaluates to. */
+static void
+vp_results_evaluate(VPResults *results)
+{
+  g_tree_foreach(results->result_tree, (GTraverseFunc) vp_results_evaluate_value, results);
 }
 
 static GString *
@@ -252,19 +356,12 @@ static void
 vp_pairs_foreach(gpointer data, gpointer user_data)
 {
   ValuePairs *vp = ((gpointer *)user_data)[0];
-  LogMessage *msg = ((gpointer *)user_data)[2];
-  gint32 seq_num = GPOINTER_TO_INT (((gpointer *)user_data)[3]);
   VPResults *results = ((gpointer *)user_data)[5];
-  const LogTemplateOptions *template_options = ((gpointer *)user_data)[6];
-  GString *sb = scratch_buffers_alloc();
   VPPairConf *vpc = (VPPairConf *)data;
-  gint time_zone_mode = GPOINTER_TO_INT (((gpointer *)user_data)[7]);
-
-  log_template_append_format((LogTemplate *)vpc->template, msg,
-                             template_options,
-                             time_zone_mode, seq_num, NULL, sb);
+  VPResultValue *rv;
 
-  vp_results_insert(results, vp_transform_apply(vp, vpc->name), vpc->template->type_hint, sb);
+  rv = vp_results_insert(results, vp_transform_apply(vp, vpc->name), vpc->template->type_hint, VPR_PAIR);
+  rv->vpc = vpc;
 }
 
 /* runs over the LogMessage nv-pairs, and inserts them unless excluded */
@@ -277,7 +374,6 @@ vp_msg_nvpairs_foreach(NVHandle handle, gchar *name,
   VPResults *results = ((gpointer *)user_data)[5];
   guint j;
   gboolean inc;
-  GString *sb;
 
   inc = (name[0] == '.' && (vp->scopes & VPS_DOT_NV_PAIRS)) ||
   (name[0] != '.' && (vp->scopes & VPS_NV_PAIRS)) ||
@@ -293,10 +389,7 @@ vp_msg_nvpairs_foreach(NVHandle handle, gchar *name,
   if (!inc)
     return FALSE;
 
-  sb = scratch_buffers_alloc();
-
-  g_string_append_len(sb, value, value_len);
-  vp_results_insert(results, vp_transform_apply(vp, name), TYPE_HINT_STRING, sb);
+  vp_results_insert_value(results, vp_transform_apply(vp, name), TYPE_HINT_STRING, VPR_NVPAIR, value, value_len);
 
   return FALSE;
 }
@@ -368,44 +461,33 @@ vp_update_builtin_list_of_values(ValuePairs *vp)
     vp_merge_set(vp, all_macros);
 }
 
+/* Builtins with an empty value are not added to the result set, thus they
+ * must not override a value of the same name that was added earlier.  If
+ * there is such a value, the builtin is evaluated right away, otherwise
+ * it is deferred until the callback is invoked.  */
 static void
-vp_merge_builtins(ValuePairs *vp, VPResults *results, LogMessage *msg, gint32 seq_num, gint time_zone_mode,
-                  const LogTemplateOptions *template_options)
+vp_merge_builtins(ValuePairs *vp, VPResults *results)
 {
   gint i;
-  GString *sb;
 
   for (i = 0; i < vp->builtins->len; i++)
     {
       ValuePairSpec *spec = (ValuePairSpec *) g_ptr_array_index(vp->builtins, i);
+      GString *name = vp_transform_apply(vp, spec->name);
+      VPResultValue *rv;
 
-      sb = scratch_buffers_alloc();
-
-      switch (spec->type)
+      if (g_tree_lookup_extended(results->result_tree, name->str, NULL, NULL))
         {
-        case VPT_MACRO:
-          log_macro_expand(sb, spec->id, FALSE,
-                           template_options, time_zone_mode, seq_num, NULL, msg);
-          break;
-        case VPT_NVPAIR:
-        {
-          const gchar *nv;
-          gssize len;
+          GString *sb = scratch_buffers_alloc();
 
-          nv = log_msg_get_value(msg, (NVHandle) spec->id, &len);
-          g_string_append_len(sb, nv, len);
-          break;
-        }
-        default:
-          g_assert_not_reached();
-        }
-
-      if (sb->len == 0)
-        {
+          vp_results_format_builtin(results, spec, sb);
+          if (sb->len > 0)
+            vp_results_insert_value(results, name, TYPE_HINT_STRING, VPR_VALUE, sb->str, sb->len);
           continue;
         }
 
-      vp_results_insert(results, vp_transform_apply(vp, spec->name), TYPE_HINT_STRING, sb);
+      rv = vp_results_insert(results, name, TYPE_HINT_STRING, VPR_BUILTIN);
+      rv->spec = spec;
     }
 }
 
@@ -419,9 +501,12 @@ vp_foreach_helper(const gchar *name, gpointer ndx_as_pointer, gpointer data)
   gpointer user_data = ((gpointer *)data)[2];
   gboolean *r = ((gpointer *)data)[3];
 
+  /* builtins with empty values are skipped */
+  if (rv->type == VPR_BUILTIN && rv->value.len == 0)
+    return FALSE;
+
   *r &= !func(name, rv->type_hint,
-              rv->value->str,
-              rv->value->len, user_data);
+              rv->value.str, rv->value.len, user_data);
   return !*r;
 }
 
@@ -444,6 +529,10 @@ value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
 
   scratch_buffers_mark(&mark);
   vp_results_init(&results, compare_func);
+  results.msg = msg;
+  results.seq_num = seq_num;
+  results.time_zone_mode = time_zone_mode;
+  results.template_options = template_options;
   args[5] = &results;
 
   /*
@@ -454,11 +543,13 @@ value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
     nv_table_foreach(msg->payload, logmsg_registry,
                      (NVTableForeachFunc) vp_msg_nvpairs_foreach, args);
 
-  vp_merge_builtins(vp, &results, msg, seq_num, time_zone_mode, template_options);
+  vp_merge_builtins(vp, &results);
 
   /* Merge the explicit key-value pairs too */
   g_ptr_array_foreach(vp->vpairs, (GFunc)vp_pairs_foreach, args);
 
+  vp_results_evaluate(&results);
+
   /* Aaand we run it through the callback! */
   g_tree_foreach(results.result_tree, (GTraverseFunc)vp_foreach_helper, helper_args);
   vp_results_deinit(&results);
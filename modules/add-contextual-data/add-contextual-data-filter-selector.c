@@ -27,11 +27,62 @@
 #include "filter/filter-expr.h"
 #include "filter/filter-expr-parser.h"
 #include "filter/filter-pipe.h"
+#include "filter/filter-re.h"
+#include "filter/filter-op.h"
+#include "filter/filter-netmask.h"
+#include "gsockaddr.h"
+#include "logmsg/logmsg.h"
+
+#include <string.h>
+
+/*
+ * Evaluating thousands of selector filters one after the other for each
+ * message is expensive, so the filters are indexed by the literal values
+ * they test.  A filter is only evaluated if the message carries the
+ * value it was indexed by (or if it could not be indexed at all), in the
+ * original order, so the first matching filter is the same as with a
+ * linear scan.
+ *
+ * Indexable filters are host("value" type(string)), host("^value$") and
+ * friends, netmask() and AND expressions where one side is indexable.
+ */
+
+typedef struct _FilterLiteral
+{
+  gchar *value;
+  gsize len;
+} FilterLiteral;
+
+typedef struct _FilterValueIndex
+{
+  NVHandle handle;
+  /* FilterLiteral -> GArray of filter positions */
+  GHashTable *values;
+} FilterValueIndex;
+
+typedef struct _FilterNetmaskIndex
+{
+  guint32 netmask;
+  /* network address -> GArray of filter positions */
+  GHashTable *networks;
+} FilterNetmaskIndex;
+
+typedef struct _FilterStoreIndex
+{
+  gint ref_cnt;
+  FilterExprNode **filters;
+  const gchar **filter_names;
+  guint num_filters;
+  GArray *value_indexes;
+  GArray *netmask_indexes;
+  GArray *unindexed;
+} FilterStoreIndex;
 
 typedef struct _FilterStore
 {
   GList *filters;
   GList *filter_names;
+  FilterStoreIndex *index;
 } FilterStore;
 
 typedef struct _AddContextualDataFilterSelector
@@ -42,6 +93,307 @@ typedef struct _AddContextualDataFilterSelector
   FilterStore *filter_store;
 } AddContextualDataFilterSelector;
 
+static guint
+_filter_literal_hash(gconstpointer k)
+{
+  const FilterLiteral *key = (const FilterLiteral *) k;
+  guint hash = 5381;
+  gsize i;
+
+  for (i = 0; i < key->len; i++)
+    hash = (hash << 5) + hash + (guchar) key->value[i];
+  return hash;
+}
+
+static gboolean
+_filter_literal_equal(gconstpointer a, gconstpointer b)
+{
+  const FilterLiteral *key_a = (const FilterLiteral *) a;
+  const FilterLiteral *key_b = (const FilterLiteral *) b;
+
+  return key_a->len == key_b->len && memcmp(key_a->value, key_b->value, key_a->len) == 0;
+}
+
+static void
+_filter_literal_free(FilterLiteral *self)
+{
+  g_free(self->value);
+  g_free(self);
+}
+
+static void
+_free_positions(GArray *positions)
+{
+  g_array_free(positions, TRUE);
+}
+
+/* takes over key, unless an identical one is already in buckets */
+static void
+_append_position(GHashTable *buckets, gpointer key, GDestroyNotify key_free, guint32 position)
+{
+  GArray *positions = (GArray *) g_hash_table_lookup(buckets, key);
+
+  if (!positions)
+    {
+      positions = g_array_new(FALSE, FALSE, sizeof(guint32));
+      g_hash_table_insert(buckets, key, positions);
+    }
+  else if (key_free)
+    {
+      key_free(key);
+    }
+  g_array_append_val(positions, position);
+}
+
+static FilterValueIndex *
+_filter_store_index_lookup_value_index(FilterStoreIndex *self, NVHandle handle)
+{
+  FilterValueIndex vi;
+  guint i;
+
+  for (i = 0; i < self->value_indexes->len; i++)
+    {
+      FilterValueIndex *candidate = &g_array_index(self->value_indexes, FilterValueIndex, i);
+      if (candidate->handle == handle)
+        return candidate;
+    }
+
+  vi.handle = handle;
+  vi.values = g_hash_table_new_full(_filter_literal_hash, _filter_literal_equal,
+                                    (GDestroyNotify) _filter_literal_free, (GDestroyNotify) _free_positions);
+  g_array_append_val(self->value_indexes, vi);
+  return &g_array_index(self->value_indexes, FilterValueIndex, self->value_indexes->len - 1);
+}
+
+static FilterNetmaskIndex *
+_filter_store_index_lookup_netmask_index(FilterStoreIndex *self, guint32 netmask)
+{
+  FilterNetmaskIndex ni;
+  guint i;
+
+  for (i = 0; i < self->netmask_indexes->len; i++)
+    {
+      FilterNetmaskIndex *candidate = &g_array_index(self->netmask_indexes, FilterNetmaskIndex, i);
+      if (candidate->netmask == netmask)
+        return candidate;
+    }
+
+  ni.netmask = netmask;
+  ni.networks = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) _free_positions);
+  g_array_append_val(self->netmask_indexes, ni);
+  return &g_array_index(self->netmask_indexes, FilterNetmaskIndex, self->netmask_indexes->len - 1);
+}
+
+static gboolean
+_filter_store_index_add_by_key(FilterStoreIndex *self, FilterExprNode *filter, guint32 position)
+{
+  FilterExprNode *left, *right;
+  NVHandle handle;
+  gchar *literal;
+  guint32 address, netmask;
+
+  if (filter_re_get_literal(filter, &handle, &literal))
+    {
+      FilterValueIndex *vi = _filter_store_index_lookup_value_index(self, handle);
+      FilterLiteral *key = g_new0(FilterLiteral, 1);
+
+      key->value = literal;
+      key->len = strlen(literal);
+      _append_position(vi->values, key, (GDestroyNotify) _filter_literal_free, position);
+      return TRUE;
+    }
+
+  if (filter_netmask_get_network(filter, &address, &netmask))
+    {
+      FilterNetmaskIndex *ni = _filter_store_index_lookup_netmask_index(self, netmask);
+
+      _append_position(ni->networks, GUINT_TO_POINTER(address), NULL, position);
+      return TRUE;
+    }
+
+  /* an AND can only match if both of its sides do, so the key of either
+   * side selects a superset of the messages it matches */
+  if (fop_and_get_operands(filter, &left, &right))
+    return _filter_store_index_add_by_key(self, left, position) ||
+           _filter_store_index_add_by_key(self, right, position);
+
+  return FALSE;
+}
+
+static FilterStoreIndex *
+_filter_store_index_new(GList *filters, GList *filter_names)
+{
+  FilterStoreIndex *self = g_new0(FilterStoreIndex, 1);
+  GList *filter_it, *name_it;
+  guint32 position;
+
+  self->ref_cnt = 1;
+  self->num_filters = g_list_length(filters);
+  self->filters = g_new0(FilterExprNode *, self->num_filters);
+  self->filter_names = g_new0(const gchar *, self->num_filters);
+  self->value_indexes = g_array_new(FALSE, FALSE, sizeof(FilterValueIndex));
+  self->netmask_indexes = g_array_new(FALSE, FALSE, sizeof(FilterNetmaskIndex));
+  self->unindexed = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+  for (filter_it = filters, name_it = filter_names, position = 0;
+       filter_it != NULL && name_it != NULL;
+       filter_it = filter_it->next, name_it = name_it->next, position++)
+    {
+      FilterExprNode *filter = (FilterExprNode *) filter_it->data;
+
+      self->filters[position] = filter;
+      self->filter_names[position] = (const gchar *) name_it->data;
+
+      /* skipping a filter that changes the message would lose its side
+       * effects, so those are always evaluated */
+      if (filter->modify || !_filter_store_index_add_by_key(self, filter, position))
+        g_array_append_val(self->unindexed, position);
+    }
+
+  msg_debug("add-contextual-data(): selector filters indexed",
+            evt_tag_int("filters", self->num_filters),
+            evt_tag_int("unindexed", self->unindexed->len));
+  return self;
+}
+
+static FilterStoreIndex *
+_filter_store_index_ref(FilterStoreIndex *self)
+{
+  if (self)
+    self->ref_cnt++;
+  return self;
+}
+
+static void
+_filter_store_index_unref(FilterStoreIndex *self)
+{
+  guint i;
+
+  if (!self || --self->ref_cnt > 0)
+    return;
+
+  for (i = 0; i < self->value_indexes->len; i++)
+    g_hash_table_destroy(g_array_index(self->value_indexes, FilterValueIndex, i).values);
+  for (i = 0; i < self->netmask_indexes->len; i++)
+    g_hash_table_destroy(g_array_index(self->netmask_indexes, FilterNetmaskIndex, i).networks);
+  g_array_free(self->value_indexes, TRUE);
+  g_array_free(self->netmask_indexes, TRUE);
+  g_array_free(self->unindexed, TRUE);
+  g_free(self->filters);
+  g_free(self->filter_names);
+  g_free(self);
+}
+
+static gboolean
+_get_msg_inet_address(LogMessage *msg, guint32 *address)
+{
+  /* same as netmask() */
+  if (msg->saddr && g_sockaddr_inet_check(msg->saddr))
+    *address = ((struct sockaddr_in *) &msg->saddr->sa)->sin_addr.s_addr;
+  else if (!msg->saddr || msg->saddr->sa.sa_family == AF_UNIX)
+    *address = htonl(INADDR_LOOPBACK);
+  else
+    return FALSE;
+  return TRUE;
+}
+
+/* Collects the position lists of the filters that can match msg.  Returns
+ * FALSE if the index cannot be used for this message. */
+static gboolean
+_filter_store_index_collect_candidates(FilterStoreIndex *self, LogMessage *msg, GArray **candidates,
+                                       guint *num_candidates)
+{
+  guint32 address;
+  guint i;
+
+  *num_candidates = 0;
+  for (i = 0; i < self->value_indexes->len; i++)
+    {
+      FilterValueIndex *vi = &g_array_index(self->value_indexes, FilterValueIndex, i);
+      FilterLiteral key;
+      gssize len;
+      GArray *positions;
+
+      key.value = (gchar *) log_msg_get_value(msg, vi->handle, &len);
+      key.len = len;
+
+      /* "^value$" also matches "value\n", leave these to the filters */
+      if (key.len > 0 && key.value[key.len - 1] == '\n')
+        return FALSE;
+
+      positions = (GArray *) g_hash_table_lookup(vi->values, &key);
+      if (positions)
+        candidates[(*num_candidates)++] = positions;
+    }
+
+  if (self->netmask_indexes->len > 0 && _get_msg_inet_address(msg, &address))
+    {
+      for (i = 0; i < self->netmask_indexes->len; i++)
+        {
+          FilterNetmaskIndex *ni = &g_array_index(self->netmask_indexes, FilterNetmaskIndex, i);
+          GArray *positions = (GArray *) g_hash_table_lookup(ni->networks, GUINT_TO_POINTER(address & ni->netmask));
+
+          if (positions)
+            candidates[(*num_candidates)++] = positions;
+        }
+    }
+
+  if (self->unindexed->len > 0)
+    candidates[(*num_candidates)++] = self->unindexed;
+  return TRUE;
+}
+
+static const gchar *
+_filter_store_index_get_first_matching_name(FilterStoreIndex *self, LogMessage *msg)
+{
+  guint max_candidates = self->value_indexes->len + self->netmask_indexes->len + 1;
+  GArray **candidates = g_alloca(max_candidates * sizeof(GArray *));
+  guint *cursors = g_alloca(max_candidates * sizeof(guint));
+  guint num_candidates, i;
+
+  if (!_filter_store_index_collect_candidates(self, msg, candidates, &num_candidates))
+    {
+      /* fall back to evaluating all of them */
+      for (i = 0; i < self->num_filters; i++)
+        {
+          msg_debug("Evaluating filter", evt_tag_str("filter_name", self->filter_names[i]));
+          if (filter_expr_eval(self->filters[i], msg))
+            return self->filter_names[i];
+        }
+      return NULL;
+    }
+
+  memset(cursors, 0, num_candidates * sizeof(guint));
+
+  /* merge the candidate lists, each of them is sorted by position */
+  while (TRUE)
+    {
+      gint best = -1;
+      guint32 position, best_position = G_MAXUINT32;
+
+      for (i = 0; i < num_candidates; i++)
+        {
+          if (cursors[i] >= candidates[i]->len)
+            continue;
+
+          position = g_array_index(candidates[i], guint32, cursors[i]);
+          if (position < best_position)
+            {
+              best_position = position;
+              best = i;
+            }
+        }
+
+      if (best < 0)
+        return NULL;
+
+      cursors[best]++;
+      msg_debug("Evaluating filter", evt_tag_str("filter_name", self->filter_names[best_position]));
+      if (filter_expr_eval(self->filters[best_position], msg))
+        return self->filter_names[best_position];
+    }
+}
+
 static FilterStore *
 _filter_store_new(void)
 {
@@ -54,6 +406,7 @@ _filter_store_free(FilterStore *self)
 {
   g_list_free(self->filters);
   g_list_free(self->filter_names);
+  _filter_store_index_unref(self->index);
   g_free(self);
 }
 
@@ -63,6 +416,7 @@ _filter_store_clone(FilterStore *self)
   FilterStore *cloned = _filter_store_new();
   cloned->filters = g_list_copy(self->filters);
   cloned->filter_names = g_list_copy(self->filter_names);
+  cloned->index = _filter_store_index_ref(self->index);
   return cloned;
 }
 
@@ -80,6 +434,9 @@ _filter_store_get_first_matching_name(FilterStore *self, LogMessage *msg)
   FilterExprNode *filter;
   const gchar *name = NULL;
 
+  if (self->index)
+    return _filter_store_index_get_first_matching_name(self->index, msg);
+
   for (filter_it = self->filters, name_it = self->filter_names;
        filter_it != NULL && name_it != NULL;
        filter_it = filter_it->next, name_it = name_it->next)
@@ -174,6 +531,7 @@ _filter_store_order_by_selectors(FilterStore *self, GList *ordered_selectors)
     }
   fs_ordered->filters = g_list_reverse(fs_ordered->filters);
   fs_ordered->filter_names = g_list_reverse(fs_ordered->filter_names);
+  fs_ordered->index = _filter_store_index_new(fs_ordered->filters, fs_ordered->filter_names);
   _filter_store_free(self);
 
   return fs_ordered;
@@ -32,6 +32,7 @@
 #include "add-contextual-data-filter-selector.h"
 #include "template/templates.h"
 #include "context-info-db.h"
+#include "context-info-db-compiled.h"
 #include "pathutils.h"
 
 #include <stdio.h>
@@ -126,6 +127,8 @@ _process(LogParser *s, LogMessage **pmsg,
 {
   AddContextualData *self = (AddContextualData *) s;
   LogMessage *msg = log_msg_make_writable(pmsg, path_options);
+  context_info_db_reload_if_changed(self->context_info_db, msg->timestamps[LM_TS_RECVD].tv_sec);
+
   gchar *resolved_selector = add_contextual_data_selector_resolve(self->selector, msg);
   const gchar *selector = resolved_selector;
 
@@ -202,23 +205,21 @@ _complete_relative_path_with_config_path(const gchar *filename)
                      filename, NULL);
 }
 
+static gchar *
+_get_data_file_path(const gchar *filename)
+{
+  if (_is_relative_path(filename))
+    return _complete_relative_path_with_config_path(filename);
+  return g_strdup(filename);
+}
+
 static FILE *
 _open_data_file(const gchar *filename)
 {
-  FILE *f = NULL;
-
-  if (_is_relative_path(filename))
-    {
-      gchar *absolute_path =
-        _complete_relative_path_with_config_path(filename);
-      f = fopen(absolute_path, "r");
-      g_free(absolute_path);
-    }
-  else
-    {
-      f = fopen(filename, "r");
-    }
+  gchar *path = _get_data_file_path(filename);
+  FILE *f = fopen(path, "r");
 
+  g_free(path);
   return f;
 }
 
@@ -231,7 +232,7 @@ _get_scanner(AddContextualData *self)
 
   if (!scanner)
     {
-      msg_error("add-contextual-data(): unknown file extension, only files with a .csv extension are supported",
+      msg_error("add-contextual-data(): unknown file extension, only files with a .csv or .ctxdb extension are supported",
                 evt_tag_str("filename", self->filename));
       return NULL;
     }
@@ -241,9 +242,28 @@ _get_scanner(AddContextualData *self)
   return scanner;
 }
 
+static gboolean
+_is_compiled_database(AddContextualData *self)
+{
+  return g_strcmp0(get_filename_extension(self->filename), CONTEXT_INFO_DB_COMPILED_EXTENSION) == 0;
+}
+
+static gboolean
+_load_compiled_context_info_db(AddContextualData *self)
+{
+  gchar *path = _get_data_file_path(self->filename);
+  gboolean loaded = context_info_db_load_compiled(self->context_info_db, path, self->prefix);
+
+  g_free(path);
+  return loaded;
+}
+
 static gboolean
 _load_context_info_db(AddContextualData *self)
 {
+  if (_is_compiled_database(self))
+    return _load_compiled_context_info_db(self);
+
   ContextualDataRecordScanner *scanner = _get_scanner(self);
 
   if (!scanner)
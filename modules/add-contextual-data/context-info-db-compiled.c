@@ -0,0 +1,617 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "context-info-db-compiled.h"
+#include "contextual-data-record-scanner.h"
+#include "messages.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define CONTEXT_INFO_DB_COMPILED_MAGIC "SNGCTXDB"
+#define CONTEXT_INFO_DB_COMPILED_VERSION 1
+#define CONTEXT_INFO_DB_COMPILED_BYTE_ORDER 0x01020304
+
+#define CONTEXT_INFO_DB_COMPILED_IGNORE_CASE 0x0001
+
+/* the file is written in host byte order, byte_order is used to detect
+ * files compiled on a host of different endianness */
+typedef struct _ContextInfoDBCompiledHeader
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint32 flags;
+  guint32 num_selectors;
+  guint32 num_ordered_selectors;
+  guint32 num_records;
+  guint32 num_names;
+  guint32 __pad;
+  guint64 selectors_offset;
+  guint64 ordered_selectors_offset;
+  guint64 records_offset;
+  guint64 names_offset;
+  guint64 strings_offset;
+  guint64 strings_size;
+} ContextInfoDBCompiledHeader;
+
+/* string references are offsets into the string table, strings are NUL
+ * terminated */
+typedef struct _ContextInfoDBCompiledSelector
+{
+  guint32 selector;
+  guint32 first_record;
+  guint32 num_records;
+} ContextInfoDBCompiledSelector;
+
+typedef struct _ContextInfoDBCompiledRecord
+{
+  guint32 name_id;
+  guint32 value;
+  guint32 value_len;
+} ContextInfoDBCompiledRecord;
+
+struct _ContextInfoDBCompiled
+{
+  gchar *filename;
+  const gchar *base;
+  gsize size;
+
+  const ContextInfoDBCompiledHeader *header;
+  const ContextInfoDBCompiledSelector *selectors;
+  const guint32 *ordered_selectors;
+  const ContextInfoDBCompiledRecord *records;
+  const guint32 *names;
+  const gchar *strings;
+};
+
+static gint
+_selector_cmp(const gchar *s1, const gchar *s2, gboolean ignore_case)
+{
+  return ignore_case ? g_ascii_strcasecmp(s1, s2) : strcmp(s1, s2);
+}
+
+/****************************************************************************
+ * Reading
+ ****************************************************************************/
+
+static inline const gchar *
+_get_string(ContextInfoDBCompiled *self, guint32 offset)
+{
+  return self->strings + offset;
+}
+
+static gboolean
+_is_section_valid(ContextInfoDBCompiled *self, guint64 offset, guint64 count, gsize element_size)
+{
+  return offset <= self->size && count * element_size <= self->size - offset &&
+         offset % sizeof(guint32) == 0;
+}
+
+static gboolean
+_is_string_valid(ContextInfoDBCompiled *self, guint32 offset, guint32 len)
+{
+  /* the string table is known to end with a NUL character, a value must
+   * have one right at its end */
+  return (guint64) offset + len < self->header->strings_size && self->strings[offset + len] == '\0';
+}
+
+static gboolean
+_validate_header(ContextInfoDBCompiled *self)
+{
+  const ContextInfoDBCompiledHeader *header = self->header;
+
+  if (self->size < sizeof(*header) ||
+      memcmp(header->magic, CONTEXT_INFO_DB_COMPILED_MAGIC, sizeof(header->magic)) != 0)
+    {
+      msg_error("add-contextual-data(): not a compiled context database",
+                evt_tag_str("filename", self->filename));
+      return FALSE;
+    }
+
+  if (header->byte_order != CONTEXT_INFO_DB_COMPILED_BYTE_ORDER ||
+      header->version != CONTEXT_INFO_DB_COMPILED_VERSION)
+    {
+      msg_error("add-contextual-data(): compiled context database was produced by an incompatible version "
+                "or on a host with a different byte order, please recompile it",
+                evt_tag_str("filename", self->filename),
+                evt_tag_int("version", header->version));
+      return FALSE;
+    }
+
+  if (!_is_section_valid(self, header->selectors_offset, header->num_selectors,
+                         sizeof(ContextInfoDBCompiledSelector)) ||
+      !_is_section_valid(self, header->ordered_selectors_offset, header->num_ordered_selectors, sizeof(guint32)) ||
+      !_is_section_valid(self, header->records_offset, header->num_records, sizeof(ContextInfoDBCompiledRecord)) ||
+      !_is_section_valid(self, header->names_offset, header->num_names, sizeof(guint32)) ||
+      !_is_section_valid(self, header->strings_offset, header->strings_size, 1) ||
+      (header->strings_size > 0 && self->base[header->strings_offset + header->strings_size - 1] != '\0'))
+    {
+      msg_error("add-contextual-data(): compiled context database is truncated or corrupt",
+                evt_tag_str("filename", self->filename));
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* validate every reference once, so that lookups can trust the contents */
+static gboolean
+_validate_contents(ContextInfoDBCompiled *self)
+{
+  const ContextInfoDBCompiledHeader *header = self->header;
+
+  for (guint32 i = 0; i < header->num_selectors; i++)
+    {
+      const ContextInfoDBCompiledSelector *selector = &self->selectors[i];
+
+      if (selector->selector >= header->strings_size ||
+          (guint64) selector->first_record + selector->num_records > header->num_records)
+        return FALSE;
+    }
+
+  for (guint32 i = 0; i < header->num_ordered_selectors; i++)
+    {
+      if (self->ordered_selectors[i] >= header->num_selectors)
+        return FALSE;
+    }
+
+  for (guint32 i = 0; i < header->num_names; i++)
+    {
+      if (self->names[i] >= header->strings_size)
+        return FALSE;
+    }
+
+  for (guint32 i = 0; i < header->num_records; i++)
+    {
+      const ContextInfoDBCompiledRecord *record = &self->records[i];
+
+      if (record->name_id >= header->num_names || !_is_string_valid(self, record->value, record->value_len))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+_map_file(ContextInfoDBCompiled *self)
+{
+  struct stat st;
+  gint fd;
+
+  fd = open(self->filename, O_RDONLY);
+  if (fd < 0)
+    {
+      msg_error("add-contextual-data(): Error opening compiled database",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+      msg_error("add-contextual-data(): Error opening compiled database, unable to determine its size",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      close(fd);
+      return FALSE;
+    }
+
+  self->size = st.st_size;
+  self->base = mmap(NULL, self->size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (self->base == MAP_FAILED)
+    {
+      msg_error("add-contextual-data(): Error mapping compiled database",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      self->base = NULL;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+ContextInfoDBCompiled *
+context_info_db_compiled_open(const gchar *filename)
+{
+  ContextInfoDBCompiled *self = g_new0(ContextInfoDBCompiled, 1);
+
+  self->filename = g_strdup(filename);
+  if (!_map_file(self))
+    goto error;
+
+  self->header = (const ContextInfoDBCompiledHeader *) self->base;
+  if (!_validate_header(self))
+    goto error;
+
+  self->selectors = (const ContextInfoDBCompiledSelector *) (self->base + self->header->selectors_offset);
+  self->ordered_selectors = (const guint32 *) (self->base + self->header->ordered_selectors_offset);
+  self->records = (const ContextInfoDBCompiledRecord *) (self->base + self->header->records_offset);
+  self->names = (const guint32 *) (self->base + self->header->names_offset);
+  self->strings = self->base + self->header->strings_offset;
+
+  if (!_validate_contents(self))
+    {
+      msg_error("add-contextual-data(): compiled context database is corrupt",
+                evt_tag_str("filename", self->filename));
+      goto error;
+    }
+
+  return self;
+
+error:
+  context_info_db_compiled_close(self);
+  return NULL;
+}
+
+void
+context_info_db_compiled_close(ContextInfoDBCompiled *self)
+{
+  if (self->base)
+    munmap((gpointer) self->base, self->size);
+  g_free(self->filename);
+  g_free(self);
+}
+
+gboolean
+context_info_db_compiled_is_case_insensitive(ContextInfoDBCompiled *self)
+{
+  return !!(self->header->flags & CONTEXT_INFO_DB_COMPILED_IGNORE_CASE);
+}
+
+gboolean
+context_info_db_compiled_lookup(ContextInfoDBCompiled *self, const gchar *selector,
+                                guint32 *first_record, guint32 *num_records)
+{
+  gboolean ignore_case = context_info_db_compiled_is_case_insensitive(self);
+  guint32 lo = 0, hi = self->header->num_selectors;
+
+  while (lo < hi)
+    {
+      guint32 mid = lo + (hi - lo) / 2;
+      const ContextInfoDBCompiledSelector *candidate = &self->selectors[mid];
+      gint cmp = _selector_cmp(selector, _get_string(self, candidate->selector), ignore_case);
+
+      if (cmp == 0)
+        {
+          *first_record = candidate->first_record;
+          *num_records = candidate->num_records;
+          return TRUE;
+        }
+      if (cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+  return FALSE;
+}
+
+guint32
+context_info_db_compiled_get_num_selectors(ContextInfoDBCompiled *self)
+{
+  return self->header->num_selectors;
+}
+
+const gchar *
+context_info_db_compiled_get_selector(ContextInfoDBCompiled *self, guint32 selector_index)
+{
+  return _get_string(self, self->selectors[selector_index].selector);
+}
+
+guint32
+context_info_db_compiled_get_num_ordered_selectors(ContextInfoDBCompiled *self)
+{
+  return self->header->num_ordered_selectors;
+}
+
+const gchar *
+context_info_db_compiled_get_ordered_selector(ContextInfoDBCompiled *self, guint32 order)
+{
+  return context_info_db_compiled_get_selector(self, self->ordered_selectors[order]);
+}
+
+guint32
+context_info_db_compiled_get_num_names(ContextInfoDBCompiled *self)
+{
+  return self->header->num_names;
+}
+
+const gchar *
+context_info_db_compiled_get_name(ContextInfoDBCompiled *self, guint32 name_id)
+{
+  return _get_string(self, self->names[name_id]);
+}
+
+void
+context_info_db_compiled_get_record(ContextInfoDBCompiled *self, guint32 record_index,
+                                    guint32 *name_id, const gchar **value, gsize *value_len)
+{
+  const ContextInfoDBCompiledRecord *record = &self->records[record_index];
+
+  *name_id = record->name_id;
+  *value = _get_string(self, record->value);
+  *value_len = record->value_len;
+}
+
+/****************************************************************************
+ * Writing
+ ****************************************************************************/
+
+typedef struct _ContextInfoDBCompiledWriter
+{
+  gboolean ignore_case;
+  GHashTable *string_offsets;
+  GString *strings;
+  GHashTable *name_ids;
+  GArray *names;
+  GArray *selectors;
+  GArray *ordered_selectors;
+  GArray *records;
+} ContextInfoDBCompiledWriter;
+
+static guint32
+_intern_string(ContextInfoDBCompiledWriter *self, const gchar *str, gsize len)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended(self->string_offsets, str, NULL, &offset))
+    return GPOINTER_TO_UINT(offset);
+
+  guint32 new_offset = self->strings->len;
+  g_string_append_len(self->strings, str, len);
+  g_string_append_c(self->strings, '\0');
+  g_hash_table_insert(self->string_offsets, g_strndup(str, len), GUINT_TO_POINTER(new_offset));
+  return new_offset;
+}
+
+static guint32
+_intern_name(ContextInfoDBCompiledWriter *self, const GString *name)
+{
+  gpointer name_id;
+
+  if (g_hash_table_lookup_extended(self->name_ids, name->str, NULL, &name_id))
+    return GPOINTER_TO_UINT(name_id);
+
+  guint32 new_name_id = self->names->len;
+  guint32 name_offset = _intern_string(self, name->str, name->len);
+
+  g_array_append_val(self->names, name_offset);
+  g_hash_table_insert(self->name_ids, g_strdup(name->str), GUINT_TO_POINTER(new_name_id));
+  return new_name_id;
+}
+
+static void
+_add_records(ContextInfoDBCompiledWriter *self, GArray *sorted_records)
+{
+  ContextInfoDBCompiledSelector *current = NULL;
+  const gchar *current_selector = NULL;
+
+  for (guint32 i = 0; i < sorted_records->len; i++)
+    {
+      ContextualDataRecord *record = &g_array_index(sorted_records, ContextualDataRecord, i);
+      ContextInfoDBCompiledRecord compiled_record;
+
+      if (!current || _selector_cmp(current_selector, record->selector->str, self->ignore_case) != 0)
+        {
+          ContextInfoDBCompiledSelector selector =
+          {
+            .selector = _intern_string(self, record->selector->str, record->selector->len),
+            .first_record = i,
+            .num_records = 0,
+          };
+          g_array_append_val(self->selectors, selector);
+          current = &g_array_index(self->selectors, ContextInfoDBCompiledSelector, self->selectors->len - 1);
+          current_selector = record->selector->str;
+        }
+
+      compiled_record.name_id = _intern_name(self, record->name);
+      compiled_record.value = _intern_string(self, record->value->str, record->value->len);
+      compiled_record.value_len = record->value->len;
+      g_array_append_val(self->records, compiled_record);
+      current->num_records++;
+    }
+}
+
+static gboolean
+_find_selector(ContextInfoDBCompiledWriter *self, const gchar *selector, guint32 *selector_index)
+{
+  guint32 lo = 0, hi = self->selectors->len;
+
+  while (lo < hi)
+    {
+      guint32 mid = lo + (hi - lo) / 2;
+      ContextInfoDBCompiledSelector *candidate = &g_array_index(self->selectors, ContextInfoDBCompiledSelector, mid);
+      gint cmp = _selector_cmp(selector, self->strings->str + candidate->selector, self->ignore_case);
+
+      if (cmp == 0)
+        {
+          *selector_index = mid;
+          return TRUE;
+        }
+      if (cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+  return FALSE;
+}
+
+static void
+_add_ordered_selectors(ContextInfoDBCompiledWriter *self, GList *ordered_selectors)
+{
+  GHashTable *seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  for (GList *l = ordered_selectors; l; l = l->next)
+    {
+      guint32 selector_index;
+
+      /* with ignore-case, different spellings of a selector map to the same entry */
+      if (!_find_selector(self, (const gchar *) l->data, &selector_index) ||
+          g_hash_table_lookup(seen, GUINT_TO_POINTER(selector_index + 1)))
+        continue;
+
+      g_hash_table_insert(seen, GUINT_TO_POINTER(selector_index + 1), GUINT_TO_POINTER(selector_index + 1));
+      g_array_append_val(self->ordered_selectors, selector_index);
+    }
+  g_hash_table_destroy(seen);
+}
+
+static gboolean
+_write_section(FILE *f, guint64 *offset, gconstpointer data, gsize len)
+{
+  static const gchar padding[sizeof(guint64)];
+  gsize pad = (sizeof(guint64) - (*offset % sizeof(guint64))) % sizeof(guint64);
+
+  if (pad && fwrite(padding, 1, pad, f) != pad)
+    return FALSE;
+  *offset += pad;
+
+  if (len && fwrite(data, 1, len, f) != len)
+    return FALSE;
+  return TRUE;
+}
+
+static gboolean
+_write_file(ContextInfoDBCompiledWriter *self, FILE *f)
+{
+  ContextInfoDBCompiledHeader header;
+  guint64 offset = sizeof(header);
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CONTEXT_INFO_DB_COMPILED_MAGIC, sizeof(header.magic));
+  header.version = CONTEXT_INFO_DB_COMPILED_VERSION;
+  header.byte_order = CONTEXT_INFO_DB_COMPILED_BYTE_ORDER;
+  header.flags = self->ignore_case ? CONTEXT_INFO_DB_COMPILED_IGNORE_CASE : 0;
+  header.num_selectors = self->selectors->len;
+  header.num_ordered_selectors = self->ordered_selectors->len;
+  header.num_records = self->records->len;
+  header.num_names = self->names->len;
+  header.strings_size = self->strings->len;
+
+  /* the header is rewritten once the offsets are known */
+  if (fwrite(&header, sizeof(header), 1, f) != 1)
+    return FALSE;
+
+  struct
+  {
+    guint64 *offset;
+    GArray *contents;
+  } sections[] =
+  {
+    { &header.selectors_offset, self->selectors },
+    { &header.ordered_selectors_offset, self->ordered_selectors },
+    { &header.records_offset, self->records },
+    { &header.names_offset, self->names },
+  };
+
+  for (gsize i = 0; i < G_N_ELEMENTS(sections); i++)
+    {
+      gsize len = sections[i].contents->len * g_array_get_element_size(sections[i].contents);
+
+      if (!_write_section(f, &offset, sections[i].contents->data, len))
+        return FALSE;
+      *sections[i].offset = offset;
+      offset += len;
+    }
+
+  if (!_write_section(f, &offset, self->strings->str, self->strings->len))
+    return FALSE;
+  header.strings_offset = offset;
+
+  if (fseek(f, 0, SEEK_SET) < 0 || fwrite(&header, sizeof(header), 1, f) != 1)
+    return FALSE;
+  return TRUE;
+}
+
+/*
+ * @sorted_records must be sorted by selector (case-insensitively if
+ * @ignore_case is set), as done by context_info_db_index().
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * that a running syslog-ng never maps a partially written database.
+ */
+gboolean
+context_info_db_compiled_write(const gchar *filename, GArray *sorted_records,
+                               GList *ordered_selectors, gboolean ignore_case)
+{
+  ContextInfoDBCompiledWriter self;
+  gchar *temp_filename = g_strdup_printf("%s.tmp", filename);
+  gboolean success = FALSE;
+  FILE *f;
+
+  self.ignore_case = ignore_case;
+  self.string_offsets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  self.strings = g_string_sized_new(4096);
+  self.name_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  self.names = g_array_new(FALSE, FALSE, sizeof(guint32));
+  self.selectors = g_array_new(FALSE, FALSE, sizeof(ContextInfoDBCompiledSelector));
+  self.ordered_selectors = g_array_new(FALSE, FALSE, sizeof(guint32));
+  self.records = g_array_new(FALSE, FALSE, sizeof(ContextInfoDBCompiledRecord));
+
+  _add_records(&self, sorted_records);
+  _add_ordered_selectors(&self, ordered_selectors);
+
+  f = fopen(temp_filename, "w");
+  if (!f)
+    {
+      msg_error("add-contextual-data(): Error creating compiled database",
+                evt_tag_str("filename", temp_filename),
+                evt_tag_error("error"));
+      goto exit;
+    }
+
+  if (!_write_file(&self, f))
+    {
+      msg_error("add-contextual-data(): Error writing compiled database",
+                evt_tag_str("filename", temp_filename),
+                evt_tag_error("error"));
+      fclose(f);
+      unlink(temp_filename);
+      goto exit;
+    }
+
+  if (fclose(f) != 0 || rename(temp_filename, filename) < 0)
+    {
+      msg_error("add-contextual-data(): Error storing compiled database",
+                evt_tag_str("filename", filename),
+                evt_tag_error("error"));
+      unlink(temp_filename);
+      goto exit;
+    }
+  success = TRUE;
+
+exit:
+  g_hash_table_destroy(self.string_offsets);
+  g_string_free(self.strings, TRUE);
+  g_hash_table_destroy(self.name_ids);
+  g_array_free(self.names, TRUE);
+  g_array_free(self.selectors, TRUE);
+  g_array_free(self.ordered_selectors, TRUE);
+  g_array_free(self.records, TRUE);
+  g_free(temp_filename);
+  return success;
+}
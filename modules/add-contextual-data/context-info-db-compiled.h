@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef CONTEXTINFODB_COMPILED_H_INCLUDED
+#define CONTEXTINFODB_COMPILED_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Compiled (binary) representation of a context-info-db, produced by
+ * ctxdbtool from a CSV file and mmapped read-only by add-contextual-data().
+ * All strings are interned in a single string table, selectors are sorted
+ * (case-insensitively if the database was compiled with ignore-case) so
+ * that they can be looked up with a binary search.
+ */
+
+#define CONTEXT_INFO_DB_COMPILED_EXTENSION "ctxdb"
+
+typedef struct _ContextInfoDBCompiled ContextInfoDBCompiled;
+
+ContextInfoDBCompiled *context_info_db_compiled_open(const gchar *filename);
+void context_info_db_compiled_close(ContextInfoDBCompiled *self);
+
+gboolean context_info_db_compiled_is_case_insensitive(ContextInfoDBCompiled *self);
+
+gboolean context_info_db_compiled_lookup(ContextInfoDBCompiled *self, const gchar *selector,
+                                         guint32 *first_record, guint32 *num_records);
+
+guint32 context_info_db_compiled_get_num_selectors(ContextInfoDBCompiled *self);
+const gchar *context_info_db_compiled_get_selector(ContextInfoDBCompiled *self, guint32 selector_index);
+guint32 context_info_db_compiled_get_num_ordered_selectors(ContextInfoDBCompiled *self);
+const gchar *context_info_db_compiled_get_ordered_selector(ContextInfoDBCompiled *self, guint32 order);
+
+guint32 context_info_db_compiled_get_num_names(ContextInfoDBCompiled *self);
+const gchar *context_info_db_compiled_get_name(ContextInfoDBCompiled *self, guint32 name_id);
+
+void context_info_db_compiled_get_record(ContextInfoDBCompiled *self, guint32 record_index,
+                                         guint32 *name_id, const gchar **value, gsize *value_len);
+
+gboolean context_info_db_compiled_write(const gchar *filename, GArray *sorted_records,
+                                        GList *ordered_selectors, gboolean ignore_case);
+
+#endif
@@ -21,11 +21,16 @@
  */
 
 #include "context-info-db.h"
+#include "context-info-db-compiled.h"
 #include "atomic.h"
 #include "messages.h"
 #include <string.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+
+/* seconds between checking a compiled database file for changes */
+#define CONTEXT_INFO_DB_COMPILED_CHECK_FREQ 5
 
 struct _ContextInfoDB
 {
@@ -35,7 +40,21 @@ struct _ContextInfoDB
   gboolean is_data_indexed;
   gboolean is_ordering_enabled;
   GList *ordered_selectors;
+  GList *ordered_selectors_last;
+  GHashTable *ordered_selectors_seen;
   gboolean ignore_case;
+
+  /* compiled databases are mmapped instead of being loaded into data/index,
+   * and are swapped as a whole when the file changes */
+  GStaticRWLock compiled_lock;
+  ContextInfoDBCompiled *compiled;
+  GPtrArray *compiled_names;
+  gchar *compiled_filename;
+  gchar *compiled_name_prefix;
+  GStaticMutex compiled_reload_lock;
+  time_t compiled_last_check;
+  ino_t compiled_inode;
+  time_t compiled_mtime;
 };
 
 typedef struct _element_range
@@ -53,12 +72,6 @@ _contextual_data_record_cmp(gconstpointer k1, gconstpointer k2)
   return strcmp(r1->selector->str, r2->selector->str);
 }
 
-static gint
-_g_strcmp(gconstpointer a, gconstpointer b)
-{
-  return g_strcmp0((const gchar *) a, (const gchar *) b);
-}
-
 static gint
 _g_strcasecmp(gconstpointer a, gconstpointer b)
 {
@@ -80,6 +93,8 @@ void
 context_info_db_enable_ordering(ContextInfoDB *self)
 {
   self->is_ordering_enabled = TRUE;
+  if (!self->ordered_selectors_seen)
+    self->ordered_selectors_seen = g_hash_table_new(g_str_hash, g_str_equal);
 }
 
 GList *
@@ -201,9 +216,12 @@ _free_array(GArray *array)
   g_array_free(array, TRUE);
 }
 
+static void _free_compiled(ContextInfoDB *self);
+
 static void
 _free(ContextInfoDB *self)
 {
+  _free_compiled(self);
   if (self->index)
     {
       g_hash_table_unref(self->index);
@@ -216,6 +234,10 @@ _free(ContextInfoDB *self)
     {
       g_list_free(self->ordered_selectors);
     }
+  if (self->ordered_selectors_seen)
+    {
+      g_hash_table_destroy(self->ordered_selectors_seen);
+    }
 }
 
 ContextInfoDB *
@@ -224,6 +246,8 @@ context_info_db_new(void)
   ContextInfoDB *self = g_new0(ContextInfoDB, 1);
 
   g_atomic_counter_set(&self->ref_cnt, 1);
+  g_static_rw_lock_init(&self->compiled_lock);
+  g_static_mutex_init(&self->compiled_reload_lock);
 
   return self;
 }
@@ -278,16 +302,45 @@ context_info_db_insert(ContextInfoDB *self,
 {
   g_array_append_val(self->data, *record);
   self->is_data_indexed = FALSE;
-  if (self->is_ordering_enabled && !g_list_find_custom(self->ordered_selectors, record->selector->str, _g_strcmp))
-    self->ordered_selectors = g_list_append(self->ordered_selectors, record->selector->str);
+  if (self->is_ordering_enabled && !g_hash_table_lookup(self->ordered_selectors_seen, record->selector->str))
+    {
+      /* appending at the last element keeps this linear for large databases */
+      g_hash_table_insert(self->ordered_selectors_seen, record->selector->str, record->selector->str);
+      if (!self->ordered_selectors)
+        self->ordered_selectors_last = self->ordered_selectors = g_list_append(NULL, record->selector->str);
+      else
+        self->ordered_selectors_last = g_list_append(self->ordered_selectors_last, record->selector->str)->next;
+    }
+}
+
+static gboolean
+_is_compiled(ContextInfoDB *self)
+{
+  return self->compiled_filename != NULL;
+}
+
+static gboolean
+_compiled_lookup(ContextInfoDB *self, const gchar *selector, guint32 *first_record, guint32 *num_records)
+{
+  gboolean found;
+
+  g_static_rw_lock_reader_lock(&self->compiled_lock);
+  found = context_info_db_compiled_lookup(self->compiled, selector, first_record, num_records);
+  g_static_rw_lock_reader_unlock(&self->compiled_lock);
+  return found;
 }
 
 gboolean
 context_info_db_contains(ContextInfoDB *self, const gchar *selector)
 {
+  guint32 first_record, num_records;
+
   if (!selector)
     return FALSE;
 
+  if (_is_compiled(self))
+    return _compiled_lookup(self, selector, &first_record, &num_records);
+
   _ensure_indexed_db(self);
   return (_get_range_of_records(self, selector) != NULL);
 }
@@ -296,6 +349,15 @@ gsize
 context_info_db_number_of_records(ContextInfoDB *self,
                                   const gchar *selector)
 {
+  if (_is_compiled(self))
+    {
+      guint32 first_record, num_records;
+
+      if (!_compiled_lookup(self, selector, &first_record, &num_records))
+        return 0;
+      return num_records;
+    }
+
   _ensure_indexed_db(self);
 
   gsize n = 0;
@@ -307,10 +369,49 @@ context_info_db_number_of_records(ContextInfoDB *self,
   return n;
 }
 
+/* the records passed to @callback refer to the mapped file, their
+ * selector and value GStrings are read-only views, not allocated strings */
+static void
+_compiled_foreach_record(ContextInfoDB *self, const gchar *selector,
+                         ADD_CONTEXT_INFO_CB callback, gpointer arg)
+{
+  guint32 first_record, num_records;
+  GString selector_view = { .str = (gchar *) selector, .len = strlen(selector), .allocated_len = 0 };
+
+  g_static_rw_lock_reader_lock(&self->compiled_lock);
+  if (context_info_db_compiled_lookup(self->compiled, selector, &first_record, &num_records))
+    {
+      for (guint32 i = first_record; i < first_record + num_records; ++i)
+        {
+          guint32 name_id;
+          const gchar *value;
+          gsize value_len;
+
+          context_info_db_compiled_get_record(self->compiled, i, &name_id, &value, &value_len);
+
+          GString value_view = { .str = (gchar *) value, .len = value_len, .allocated_len = 0 };
+          ContextualDataRecord record =
+          {
+            .selector = &selector_view,
+            .name = g_ptr_array_index(self->compiled_names, name_id),
+            .value = &value_view,
+          };
+          callback(arg, &record);
+        }
+    }
+  g_static_rw_lock_reader_unlock(&self->compiled_lock);
+}
+
 void
 context_info_db_foreach_record(ContextInfoDB *self, const gchar *selector,
                                ADD_CONTEXT_INFO_CB callback, gpointer arg)
 {
+  if (_is_compiled(self))
+    {
+      _compiled_foreach_record(self, selector, callback, arg);
+      return;
+    }
+
   _ensure_indexed_db(self);
 
   element_range *record_range = _get_range_of_records(self, selector);
@@ -330,18 +431,31 @@ context_info_db_foreach_record(ContextInfoDB *self, const gchar *selector,
 gboolean
 context_info_db_is_indexed(const ContextInfoDB *self)
 {
-  return self->is_data_indexed;
+  return self->is_data_indexed || self->compiled;
 }
 
 gboolean
 context_info_db_is_loaded(const ContextInfoDB *self)
 {
-  return (self->data != NULL && self->data->len > 0);
+  return self->compiled || (self->data != NULL && self->data->len > 0);
 }
 
+/* with a compiled database, the returned selectors are valid until the
+ * database file is reloaded */
 GList *
 context_info_db_get_selectors(ContextInfoDB *self)
 {
+  if (_is_compiled(self))
+    {
+      GList *selectors = NULL;
+
+      g_static_rw_lock_reader_lock(&self->compiled_lock);
+      for (guint32 i = context_info_db_compiled_get_num_selectors(self->compiled); i > 0; i--)
+        selectors = g_list_prepend(selectors, (gpointer) context_info_db_compiled_get_selector(self->compiled, i - 1));
+      g_static_rw_lock_reader_unlock(&self->compiled_lock);
+      return selectors;
+    }
+
   _ensure_indexed_db(self);
   return g_hash_table_get_keys(self->index);
 }
@@ -398,3 +512,205 @@ context_info_db_import(ContextInfoDB *self, FILE *fp,
 
   return TRUE;
 }
+
+/****************************************************************************
+ * Compiled databases
+ ****************************************************************************/
+
+static GPtrArray *
+_compiled_build_prefixed_names(ContextInfoDBCompiled *compiled, const gchar *name_prefix)
+{
+  guint32 num_names = context_info_db_compiled_get_num_names(compiled);
+  GPtrArray *names = g_ptr_array_sized_new(num_names);
+
+  for (guint32 i = 0; i < num_names; i++)
+    {
+      GString *name = g_string_new(name_prefix);
+
+      g_string_append(name, context_info_db_compiled_get_name(compiled, i));
+      g_ptr_array_add(names, name);
+    }
+  return names;
+}
+
+static GList *
+_compiled_build_ordered_selectors(ContextInfoDBCompiled *compiled)
+{
+  GList *ordered_selectors = NULL;
+
+  for (guint32 i = context_info_db_compiled_get_num_ordered_selectors(compiled); i > 0; i--)
+    ordered_selectors = g_list_prepend(ordered_selectors,
+                                       (gpointer) context_info_db_compiled_get_ordered_selector(compiled, i - 1));
+  return ordered_selectors;
+}
+
+static void
+_free_compiled_names(GPtrArray *names)
+{
+  if (!names)
+    return;
+
+  for (guint i = 0; i < names->len; i++)
+    g_string_free(g_ptr_array_index(names, i), TRUE);
+  g_ptr_array_free(names, TRUE);
+}
+
+static gboolean
+_ordered_selectors_equal(GList *a, GList *b)
+{
+  for (; a && b; a = a->next, b = b->next)
+    {
+      if (strcmp((const gchar *) a->data, (const gchar *) b->data) != 0)
+        return FALSE;
+    }
+  return a == NULL && b == NULL;
+}
+
+static gboolean
+_open_and_install_compiled(ContextInfoDB *self)
+{
+  ContextInfoDBCompiled *compiled = context_info_db_compiled_open(self->compiled_filename);
+
+  if (!compiled)
+    return FALSE;
+
+  if (context_info_db_compiled_is_case_insensitive(compiled) != self->ignore_case)
+    {
+      msg_error("add-contextual-data(): the ignore-case() setting does not match the one the database was compiled with",
+                evt_tag_str("filename", self->compiled_filename),
+                evt_tag_int("ignore_case", self->ignore_case));
+      context_info_db_compiled_close(compiled);
+      return FALSE;
+    }
+
+  GList *ordered_selectors = _compiled_build_ordered_selectors(compiled);
+
+  /* selectors depending on the order (e.g. filters) were initialized with
+   * the order of the loaded database, it can't be changed under them */
+  if (self->compiled && self->is_ordering_enabled &&
+      !_ordered_selectors_equal(self->ordered_selectors, ordered_selectors))
+    {
+      msg_error("add-contextual-data(): the order of selectors changed in the compiled database, "
+                "it is only applied when the configuration is reloaded",
+                evt_tag_str("filename", self->compiled_filename));
+      g_list_free(ordered_selectors);
+      context_info_db_compiled_close(compiled);
+      return FALSE;
+    }
+
+  GPtrArray *names = _compiled_build_prefixed_names(compiled, self->compiled_name_prefix);
+
+  g_static_rw_lock_writer_lock(&self->compiled_lock);
+  ContextInfoDBCompiled *old_compiled = self->compiled;
+  GPtrArray *old_names = self->compiled_names;
+  GList *old_ordered_selectors = self->ordered_selectors;
+
+  self->compiled = compiled;
+  self->compiled_names = names;
+  self->ordered_selectors = ordered_selectors;
+  g_static_rw_lock_writer_unlock(&self->compiled_lock);
+
+  if (old_compiled)
+    context_info_db_compiled_close(old_compiled);
+  _free_compiled_names(old_names);
+  g_list_free(old_ordered_selectors);
+  return TRUE;
+}
+
+static gboolean
+_compiled_file_changed(ContextInfoDB *self)
+{
+  struct stat st;
+
+  if (stat(self->compiled_filename, &st) < 0)
+    {
+      msg_error("add-contextual-data(): Error stating compiled database file, keeping the loaded one",
+                evt_tag_str("filename", self->compiled_filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  if (self->compiled_inode == st.st_ino && self->compiled_mtime == st.st_mtime)
+    return FALSE;
+
+  self->compiled_inode = st.st_ino;
+  self->compiled_mtime = st.st_mtime;
+  return TRUE;
+}
+
+static void
+_free_compiled(ContextInfoDB *self)
+{
+  if (self->compiled)
+    context_info_db_compiled_close(self->compiled);
+  _free_compiled_names(self->compiled_names);
+  g_free(self->compiled_filename);
+  g_free(self->compiled_name_prefix);
+  g_static_rw_lock_free(&self->compiled_lock);
+  g_static_mutex_free(&self->compiled_reload_lock);
+}
+
+/*
+ * Maps a database produced by ctxdbtool.  The database is looked up
+ * directly in the mapping, instead of being loaded into memory, @name_prefix
+ * is applied to the names stored in the file.
+ */
+gboolean
+context_info_db_load_compiled(ContextInfoDB *self, const gchar *filename, const gchar *name_prefix)
+{
+  g_free(self->compiled_filename);
+  self->compiled_filename = g_strdup(filename);
+  g_free(self->compiled_name_prefix);
+  self->compiled_name_prefix = g_strdup(name_prefix ? name_prefix : "");
+
+  struct stat st;
+  if (stat(filename, &st) == 0)
+    {
+      self->compiled_inode = st.st_ino;
+      self->compiled_mtime = st.st_mtime;
+    }
+  return _open_and_install_compiled(self);
+}
+
+/*
+ * Called by the users of the database (from any thread) with the current
+ * time, it replaces the compiled database if its file was changed.  Lookups
+ * running in parallel continue to use the old mapping until the new one is
+ * installed.  Databases loaded from CSV are not reloaded automatically.
+ */
+void
+context_info_db_reload_if_changed(ContextInfoDB *self, time_t now)
+{
+  if (!_is_compiled(self) || now < self->compiled_last_check + CONTEXT_INFO_DB_COMPILED_CHECK_FREQ)
+    return;
+
+  /* some other thread is already checking */
+  if (!g_static_mutex_trylock(&self->compiled_reload_lock))
+    return;
+
+  if (now >= self->compiled_last_check + CONTEXT_INFO_DB_COMPILED_CHECK_FREQ)
+    {
+      self->compiled_last_check = now;
+      if (_compiled_file_changed(self))
+        {
+          if (_open_and_install_compiled(self))
+            msg_notice("add-contextual-data(): compiled database reloaded",
+                       evt_tag_str("filename", self->compiled_filename));
+          else
+            msg_error("add-contextual-data(): Error reloading compiled database, keeping the loaded one",
+                      evt_tag_str("filename", self->compiled_filename));
+        }
+    }
+  g_static_mutex_unlock(&self->compiled_reload_lock);
+}
+
+/*
+ * Writes the contents of the database (loaded from CSV) in the compiled
+ * format, the order of selectors is only retained if ordering was enabled.
+ */
+gboolean
+context_info_db_export_compiled(ContextInfoDB *self, const gchar *filename)
+{
+  _ensure_indexed_db(self);
+  return context_info_db_compiled_write(filename, self->data, self->ordered_selectors, self->ignore_case);
+}
@@ -66,4 +66,8 @@ GList *context_info_db_get_selectors(ContextInfoDB *self);
 gboolean context_info_db_import(ContextInfoDB *self, FILE *fp,
                                 ContextualDataRecordScanner *scanner);
 
+gboolean context_info_db_load_compiled(ContextInfoDB *self, const gchar *filename, const gchar *name_prefix);
+void context_info_db_reload_if_changed(ContextInfoDB *self, time_t now);
+gboolean context_info_db_export_compiled(ContextInfoDB *self, const gchar *filename);
+
 #endif
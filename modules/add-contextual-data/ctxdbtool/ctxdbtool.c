@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+/*
+ * Compiles an add-contextual-data() CSV database into the binary format
+ * that can be mmapped by syslog-ng, see context-info-db-compiled.h.
+ */
+
+#include "syslog-ng.h"
+#include "messages.h"
+#include "context-info-db.h"
+#include "context-info-db-compiled.h"
+#include "contextual-data-record-scanner.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static gboolean ignore_case = FALSE;
+
+static GOptionEntry ctxdbtool_options[] =
+{
+  {
+    "ignore-case", 'i', 0, G_OPTION_ARG_NONE, &ignore_case,
+    "Compile the database for use with ignore-case(yes)", NULL
+  },
+  { NULL }
+};
+
+static gboolean
+_compile_database(const gchar *input_filename, const gchar *output_filename)
+{
+  ContextualDataRecordScanner *scanner;
+  ContextInfoDB *db;
+  gboolean success = FALSE;
+  FILE *f;
+
+  f = fopen(input_filename, "r");
+  if (!f)
+    {
+      fprintf(stderr, "Error opening input file %s: %s\n", input_filename, g_strerror(errno));
+      return FALSE;
+    }
+
+  scanner = create_contextual_data_record_scanner_by_type(input_filename, "csv");
+  db = context_info_db_new();
+  context_info_db_set_ignore_case(db, ignore_case);
+  /* filter based selectors evaluate selectors in the order of the CSV file */
+  context_info_db_enable_ordering(db);
+  context_info_db_init(db);
+
+  if (!context_info_db_import(db, f, scanner))
+    {
+      fprintf(stderr, "Error parsing input file %s\n", input_filename);
+      goto exit;
+    }
+
+  success = context_info_db_export_compiled(db, output_filename);
+
+exit:
+  fclose(f);
+  context_info_db_unref(db);
+  contextual_data_record_scanner_free(scanner);
+  return success;
+}
+
+int
+main(int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *error = NULL;
+
+  ctx = g_option_context_new("INPUT.csv OUTPUT." CONTEXT_INFO_DB_COMPILED_EXTENSION);
+  g_option_context_set_summary(ctx, "Compile an add-contextual-data() CSV database into its binary format");
+  g_option_context_add_main_entries(ctx, ctxdbtool_options, NULL);
+  msg_add_option_group(ctx);
+
+  msg_init(TRUE);
+  if (!g_option_context_parse(ctx, &argc, &argv, &error))
+    {
+      fprintf(stderr, "Error parsing command line arguments: %s\n", error ? error->message : "Invalid arguments");
+      g_clear_error(&error);
+      g_option_context_free(ctx);
+      return 1;
+    }
+  g_option_context_free(ctx);
+
+  if (argc != 3)
+    {
+      fprintf(stderr, "Usage: %s [--ignore-case] INPUT.csv OUTPUT.%s\n", argv[0], CONTEXT_INFO_DB_COMPILED_EXTENSION);
+      return 1;
+    }
+
+  gboolean success = _compile_database(argv[1], argv[2]);
+
+  msg_deinit();
+  return success ? 0 : 1;
+}
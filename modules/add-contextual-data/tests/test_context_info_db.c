@@ -27,6 +27,8 @@
 #include <criterion/parameterized.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <time.h>
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -547,3 +549,151 @@ teardown(void)
 }
 
 TestSuite(add_contextual_data, .init=app_startup, .fini=teardown);
+
+static void
+_compile_csv(gchar *csv_content, gboolean ignore_case, const gchar *filename)
+{
+  FILE *fp = fmemopen(csv_content, strlen(csv_content), "r");
+  ContextInfoDB *db = context_info_db_new();
+  context_info_db_set_ignore_case(db, ignore_case);
+  context_info_db_enable_ordering(db);
+  context_info_db_init(db);
+  ContextualDataRecordScanner *scanner =
+    create_contextual_data_record_scanner_by_type("dummy.csv", "csv");
+
+  cr_assert(context_info_db_import(db, fp, scanner),
+            "Failed to import valid CSV file.");
+  cr_assert(context_info_db_export_compiled(db, filename),
+            "Failed to write compiled database.");
+  fclose(fp);
+  context_info_db_free(db);
+  contextual_data_record_scanner_free(scanner);
+}
+
+static ContextInfoDB *
+_compile_and_load_csv(gchar *csv_content, gboolean ignore_case, const gchar *prefix)
+{
+  gchar *filename = g_build_filename(g_get_tmp_dir(), "test_context_info_db.ctxdb", NULL);
+
+  _compile_csv(csv_content, ignore_case, filename);
+
+  ContextInfoDB *compiled_db = context_info_db_new();
+  context_info_db_set_ignore_case(compiled_db, ignore_case);
+  cr_assert(context_info_db_load_compiled(compiled_db, filename, prefix),
+            "Failed to load compiled database.");
+  unlink(filename);
+  g_free(filename);
+  return compiled_db;
+}
+
+Test(add_contextual_data, test_compiled_db)
+{
+  gchar csv_content[] = "selector2,name2,value2\n"
+                        "selector1,name1,value1\n"
+                        "selector1,name1.1,value1.1\n"
+                        "selector3,name1,value3";
+  ContextInfoDB *db = _compile_and_load_csv(csv_content, FALSE, ".prefix.");
+
+  cr_assert(context_info_db_is_loaded(db));
+  cr_assert(context_info_db_contains(db, "selector1"));
+  cr_assert_not(context_info_db_contains(db, "SELECTOR1"));
+  cr_assert_not(context_info_db_contains(db, "selector4"));
+  cr_assert_eq(context_info_db_number_of_records(db, "selector1"), 2);
+  cr_assert_eq(context_info_db_number_of_records(db, "selector4"), 0);
+
+  TestNVPair expected_nvpairs_selector1[] =
+  {
+    {.name = ".prefix.name1",.value = "value1"},
+    {.name = ".prefix.name1.1",.value = "value1.1"},
+  };
+  TestNVPair expected_nvpairs_selector3[] =
+  {
+    {.name = ".prefix.name1",.value = "value3"},
+  };
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector1", expected_nvpairs_selector1,
+      ARRAY_SIZE(expected_nvpairs_selector1));
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector3", expected_nvpairs_selector3,
+      ARRAY_SIZE(expected_nvpairs_selector3));
+
+  GList *ordered_selectors = context_info_db_ordered_selectors(db);
+  cr_assert_eq(g_list_length(ordered_selectors), 3);
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 0), "selector2");
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 1), "selector1");
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 2), "selector3");
+
+  context_info_db_unref(db);
+}
+
+Test(add_contextual_data, test_compiled_db_ignore_case)
+{
+  gchar csv_content[] = "LoCaLhOsT,tag1,value1\n"
+                        "another,tag2,value2";
+  ContextInfoDB *db = _compile_and_load_csv(csv_content, TRUE, NULL);
+
+  cr_assert(context_info_db_contains(db, "localhost"));
+  cr_assert(context_info_db_contains(db, "LOCALHOST"));
+  cr_assert(context_info_db_contains(db, "ANOTHER"));
+  cr_assert_not(context_info_db_contains(db, "localhost2"));
+
+  context_info_db_unref(db);
+}
+
+Test(add_contextual_data, test_compiled_db_reload)
+{
+  gchar *filename = g_build_filename(g_get_tmp_dir(), "test_context_info_db_reload.ctxdb", NULL);
+  gchar csv_content[] = "selector1,name1,value1\n"
+                        "selector2,name2,value2";
+  gchar changed_csv_content[] = "selector1,name1,changed1\n"
+                                "selector2,name2,changed2";
+  ContextInfoDB *db = context_info_db_new();
+
+  _compile_csv(csv_content, FALSE, filename);
+  cr_assert(context_info_db_load_compiled(db, filename, NULL));
+
+  _compile_csv(changed_csv_content, FALSE, filename);
+  context_info_db_reload_if_changed(db, time(NULL));
+
+  TestNVPair expected_nvpairs[] =
+  {
+    {.name = "name1",.value = "changed1"},
+  };
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector1", expected_nvpairs,
+      ARRAY_SIZE(expected_nvpairs));
+
+  context_info_db_unref(db);
+  unlink(filename);
+  g_free(filename);
+}
+
+Test(add_contextual_data, test_compiled_db_reload_keeps_the_order_of_selectors_if_ordering_is_enabled)
+{
+  gchar *filename = g_build_filename(g_get_tmp_dir(), "test_context_info_db_reorder.ctxdb", NULL);
+  gchar csv_content[] = "selector1,name1,value1\n"
+                        "selector2,name2,value2";
+  gchar reordered_csv_content[] = "selector2,name2,changed2\n"
+                                  "selector1,name1,changed1";
+  ContextInfoDB *db = context_info_db_new();
+
+  _compile_csv(csv_content, FALSE, filename);
+  context_info_db_enable_ordering(db);
+  cr_assert(context_info_db_load_compiled(db, filename, NULL));
+
+  _compile_csv(reordered_csv_content, FALSE, filename);
+  context_info_db_reload_if_changed(db, time(NULL));
+
+  /* the loaded database is kept */
+  GList *ordered_selectors = context_info_db_ordered_selectors(db);
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 0), "selector1");
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 1), "selector2");
+
+  TestNVPair expected_nvpairs[] =
+  {
+    {.name = "name1",.value = "value1"},
+  };
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector1", expected_nvpairs,
+      ARRAY_SIZE(expected_nvpairs));
+
+  context_info_db_unref(db);
+  unlink(filename);
+  g_free(filename);
+}
@@ -24,6 +24,7 @@
 #include "template/macros.h"
 #include "cfg.h"
 #include "apphook.h"
+#include "gsockaddr.h"
 #include <criterion/criterion.h>
 #include <unistd.h>
 
@@ -152,6 +153,62 @@ Test(add_contextual_data_filter_selector, test_matching_host_and_msg_filter_sele
   g_free(resolved_selector);
 }
 
+static gchar *
+_resolve_host_program_addr(AddContextualDataSelector *selector, const gchar *host, const gchar *program,
+                           const gchar *addr)
+{
+  LogMessage *msg = _create_log_msg("testmsg", host);
+  gchar *resolved_selector;
+
+  log_msg_set_value(msg, LM_V_PROGRAM, program, -1);
+  msg->saddr = g_sockaddr_inet_new(addr, 514);
+  resolved_selector = add_contextual_data_selector_resolve(selector, msg);
+  log_msg_unref(msg);
+  return resolved_selector;
+}
+
+Test(add_contextual_data_filter_selector, test_indexed_filters_keep_the_database_order)
+{
+  const gchar cfg_content[] = "filter f_sshd_on_db01 {"\
+                              "    program(\"sshd\" type(string)) and host(\"^db01$\");"\
+                              "};"\
+                              "filter f_any_db {"\
+                              "    host(\"db\");"\
+                              "};"\
+                              "filter f_db01 {"\
+                              "    host(\"db01\" type(string));"\
+                              "};"\
+                              "filter f_internal {"\
+                              "    netmask(\"10.0.0.0/8\");"\
+                              "};";
+  GList *ordered_filters = NULL;
+  ordered_filters = g_list_append(ordered_filters, "f_sshd_on_db01");
+  ordered_filters = g_list_append(ordered_filters, "f_any_db");
+  ordered_filters = g_list_append(ordered_filters, "f_db01");
+  ordered_filters = g_list_append(ordered_filters, "f_internal");
+  AddContextualDataSelector *selector = _create_filter_selector(cfg_content, strlen(cfg_content), ordered_filters);
+  gchar *resolved_selector;
+
+  resolved_selector = _resolve_host_program_addr(selector, "db01", "sshd", "192.168.1.1");
+  cr_assert_str_eq(resolved_selector, "f_sshd_on_db01");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_host_program_addr(selector, "db01", "cron", "10.1.2.3");
+  cr_assert_str_eq(resolved_selector, "f_any_db", "Unindexed filter earlier in the order is skipped");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_host_program_addr(selector, "web01", "sshd", "10.1.2.3");
+  cr_assert_str_eq(resolved_selector, "f_internal");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_host_program_addr(selector, "web01", "sshd", "192.168.1.1");
+  cr_assert_null(resolved_selector);
+
+  resolved_selector = _resolve_host_program_addr(selector, "db01\n", "sshd", "192.168.1.1");
+  cr_assert_str_eq(resolved_selector, "f_sshd_on_db01", "Trailing newline matches an anchored regexp");
+  g_free(resolved_selector);
+}
+
 Test(add_contextual_data_filter_selector, test_invalid_filter_config)
 {
   const gchar cfg_content[] = "filter f_localhost {"\
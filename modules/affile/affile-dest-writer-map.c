@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "affile-dest-writer-map.h"
+
+typedef struct _AFFileDestWriterMapChange
+{
+  gboolean remove;
+  const gchar *key;
+  gpointer value;
+} AFFileDestWriterMapChange;
+
+static void
+_queue_change(AFFileDestWriterMap *self, gboolean remove, const gchar *key, gpointer value)
+{
+  AFFileDestWriterMapChange *change = g_new0(AFFileDestWriterMapChange, 1);
+
+  change->remove = remove;
+  change->key = key;
+  change->value = value;
+  g_queue_push_tail(&self->pending_changes, change);
+}
+
+void
+affile_dest_writer_map_insert(AFFileDestWriterMap *self, const gchar *key, gpointer value)
+{
+  _queue_change(self, FALSE, key, value);
+}
+
+/* removes @key only if it still maps to @value */
+void
+affile_dest_writer_map_remove(AFFileDestWriterMap *self, const gchar *key, gpointer value)
+{
+  _queue_change(self, TRUE, key, value);
+}
+
+static void
+_apply_change(GHashTable *copy, AFFileDestWriterMapChange *change)
+{
+  if (!change->remove)
+    g_hash_table_replace(copy, (gpointer) change->key, change->value);
+  else if (g_hash_table_lookup(copy, change->key) == change->value)
+    g_hash_table_remove(copy, change->key);
+}
+
+static gboolean
+_standby_has_readers(AFFileDestWriterMap *self, gint standby)
+{
+  return g_atomic_int_get(&self->readers[standby]) != 0;
+}
+
+/*
+ * Applies the queued changes to both copies, as far as the readers let us.
+ * Returns FALSE if some changes are still pending, in which case the
+ * caller should try again a bit later.
+ */
+gboolean
+affile_dest_writer_map_sync(AFFileDestWriterMap *self)
+{
+  AFFileDestWriterMapChange *change;
+
+  while (TRUE)
+    {
+      gint active = self->active;
+      gint standby = 1 - active;
+
+      if (!g_queue_is_empty(&self->lagging_changes))
+        {
+          if (_standby_has_readers(self, standby))
+            return FALSE;
+
+          /* the standby copy has no readers and no new reader can find it
+           * until we swap, so removed values are unreachable once this
+           * copy catches up.  The retire callback may queue new changes. */
+          while ((change = g_queue_pop_head(&self->lagging_changes)))
+            {
+              _apply_change(self->copies[standby], change);
+              if (change->remove && self->retire)
+                self->retire(change->value, self->retire_data);
+              g_free(change);
+            }
+        }
+
+      if (g_queue_is_empty(&self->pending_changes))
+        return TRUE;
+
+      while ((change = g_queue_pop_head(&self->pending_changes)))
+        {
+          _apply_change(self->copies[standby], change);
+          g_queue_push_tail(&self->lagging_changes, change);
+        }
+
+      g_atomic_int_compare_and_exchange(&self->active, active, standby);
+    }
+}
+
+void
+affile_dest_writer_map_init(AFFileDestWriterMap *self, AFFileDestWriterMapRetireFunc retire, gpointer retire_data)
+{
+  self->copies[0] = g_hash_table_new(g_str_hash, g_str_equal);
+  self->copies[1] = g_hash_table_new(g_str_hash, g_str_equal);
+  self->readers[0] = self->readers[1] = 0;
+  self->active = 0;
+  g_queue_init(&self->lagging_changes);
+  g_queue_init(&self->pending_changes);
+  self->retire = retire;
+  self->retire_data = retire_data;
+}
+
+/* the caller must make sure there are no readers left */
+void
+affile_dest_writer_map_deinit(AFFileDestWriterMap *self)
+{
+  AFFileDestWriterMapChange *change;
+
+  while ((change = g_queue_pop_head(&self->lagging_changes)))
+    g_free(change);
+  while ((change = g_queue_pop_head(&self->pending_changes)))
+    g_free(change);
+  g_hash_table_destroy(self->copies[0]);
+  g_hash_table_destroy(self->copies[1]);
+  self->copies[0] = self->copies[1] = NULL;
+}
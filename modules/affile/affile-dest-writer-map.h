@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef AFFILE_DEST_WRITER_MAP_H_INCLUDED
+#define AFFILE_DEST_WRITER_MAP_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Maps filenames to file writers, read by the source threads without
+ * taking locks and changed by a single thread (the main thread).
+ *
+ * The map keeps two copies of the hash table.  Readers use the active copy
+ * and announce that in a counter of their own copy, the writer changes the
+ * standby copy while it has no readers and then swaps the two.  Changes
+ * are queued, and affile_dest_writer_map_sync() applies them once the
+ * copy to be changed has no readers.  Every change costs a hash table
+ * operation on both copies.
+ *
+ * Keys are not copied, they must stay valid until the value is retired:
+ * the retire callback is invoked when a removed value can't be found by
+ * any reader, in progress or future.
+ */
+typedef struct _AFFileDestWriterMap AFFileDestWriterMap;
+typedef void (*AFFileDestWriterMapRetireFunc)(gpointer value, gpointer user_data);
+
+struct _AFFileDestWriterMap
+{
+  GHashTable *copies[2];
+  gint readers[2];
+  gint active;
+
+  /* changes applied to the active copy, but not to the standby one */
+  GQueue lagging_changes;
+  /* changes not applied to either copy */
+  GQueue pending_changes;
+
+  AFFileDestWriterMapRetireFunc retire;
+  gpointer retire_data;
+};
+
+static inline gint
+affile_dest_writer_map_read_begin(AFFileDestWriterMap *self)
+{
+  gint copy;
+
+  while (TRUE)
+    {
+      copy = g_atomic_int_get(&self->active);
+      g_atomic_int_inc(&self->readers[copy]);
+
+      /* the copy may have been swapped out before we announced ourselves */
+      if (G_LIKELY(g_atomic_int_get(&self->active) == copy))
+        return copy;
+      g_atomic_int_add(&self->readers[copy], -1);
+    }
+}
+
+static inline gpointer
+affile_dest_writer_map_lookup(AFFileDestWriterMap *self, gint copy, const gchar *key)
+{
+  return g_hash_table_lookup(self->copies[copy], key);
+}
+
+static inline void
+affile_dest_writer_map_read_end(AFFileDestWriterMap *self, gint copy)
+{
+  g_atomic_int_add(&self->readers[copy], -1);
+}
+
+void affile_dest_writer_map_insert(AFFileDestWriterMap *self, const gchar *key, gpointer value);
+void affile_dest_writer_map_remove(AFFileDestWriterMap *self, const gchar *key, gpointer value);
+gboolean affile_dest_writer_map_sync(AFFileDestWriterMap *self);
+
+void affile_dest_writer_map_init(AFFileDestWriterMap *self, AFFileDestWriterMapRetireFunc retire,
+                                 gpointer retire_data);
+void affile_dest_writer_map_deinit(AFFileDestWriterMap *self);
+
+#endif
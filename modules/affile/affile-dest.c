@@ -37,6 +37,8 @@
 #include "file-specializations.h"
 #include "apphook.h"
 #include "timeutils/cache.h"
+#include "scratch-buffers.h"
+#include "tls-support.h"
 
 #include <iv.h>
 #include <sys/types.h>
@@ -78,11 +80,41 @@
  *    - looked up in _queue() (in the source thread)
  *    - cleaned up in reap callback (in the main thread)
  *
- * writer_hash is locked (currently a simple mutex) using
- * AFFileDestDriver->lock.  The "queue" method cannot hold the lock while
- * forwarding it to the next pipe, thus a reference is taken under the
- * protection of the lock, keeping a the next pipe alive, even if that would
- * go away in a parallel reaper process.
+ * writer_hash (or single_writer) is only changed by the main thread, with
+ * AFFileDestDriver->lock held.  Source threads look writers up in
+ * writer_map instead, which is changed by the main thread too, but can be
+ * read without taking locks (see affile-dest-writer-map.h).  Changes are
+ * queued to writer_map and are synced in one go, at the end of the
+ * operation causing them.  The "queue" method cannot stay in the
+ * writer_map read section while forwarding the message to the next pipe,
+ * thus a reference is taken during the lookup, keeping the next pipe
+ * alive, even if that would go away in a parallel reaper process.
+ * queue_pending is a counter, as several source threads may be forwarding
+ * messages to the same writer at the same time.
+ *
+ * The reaper only removes an idle writer from writer_map and marks it as
+ * retiring, it stays in writer_hash.  Once the removal has been synced, no
+ * source thread can find the writer in writer_map anymore, and lookups
+ * that have found it earlier have already bumped queue_pending.  The
+ * writer is then reaped if it is still idle, otherwise it is added back
+ * to writer_map.  Lookups missing writer_map check writer_hash with the
+ * lock held, so they can't race with the reaper either.
+ *
+ * Each source thread remembers the last writer it has looked up, so
+ * subsequent messages going to the same file don't need to hash the
+ * filename.  The cached pointer holds no reference, it is only used in a
+ * writer_map read section, and only if no writer has been removed from any
+ * writer_map since the pointer was cached.
+ *
+ * Opening a new file does not block the source thread: the message is
+ * parked in pending_opens and the open is requested from the main thread
+ * by posting the open_requested event.  The main thread opens the file,
+ * forwards the parked messages in order, and then publishes the new
+ * writer.  Without flow-control, at most log-fifo-size() messages are
+ * parked per file, the rest is dropped.  Reopening a file that couldn't
+ * be opened earlier is requested from the main thread the same way.  The
+ * single_writer of a non-templated destination is opened and published
+ * the same way too, using the template string as the filename.
  */
 
 static GList *affile_dest_drivers = NULL;
@@ -98,9 +130,46 @@ struct _AFFileDestWriter
   time_t last_open_stamp;
   time_t time_reopen;
   struct iv_timer reap_timer;
-  gboolean reopen_pending, queue_pending;
+  gboolean reopen_pending;
+  gint queue_pending;
+  gboolean retiring;
 };
 
+typedef struct _AFFileDestParkedMsg
+{
+  LogMessage *msg;
+  LogPathOptions path_options;
+} AFFileDestParkedMsg;
+
+typedef struct _AFFileDestPendingOpen
+{
+  gchar *filename;
+  GQueue msgs;
+} AFFileDestPendingOpen;
+
+#define AFFILE_DD_CACHED_FILENAME_MAX 256
+
+typedef struct _AFFileDestWriterCache
+{
+  AFFileDestDriver *owner;
+  gint generation;
+  AFFileDestWriter *writer;
+  gchar filename[AFFILE_DD_CACHED_FILENAME_MAX];
+} AFFileDestWriterCache;
+
+TLS_BLOCK_START
+{
+  AFFileDestWriterCache last_writer;
+}
+TLS_BLOCK_END;
+
+#define last_writer __tls_deref(last_writer)
+
+/* bumped whenever a writer is removed from any writer_map */
+static gint affile_dd_writer_cache_generation;
+
+#define AFFILE_DD_WRITER_MAP_SYNC_RETRY_MSEC 10
+
 static gchar *
 affile_dw_format_persist_name(AFFileDestWriter *self)
 {
@@ -112,7 +181,8 @@ affile_dw_format_persist_name(AFFileDestWriter *self)
   return persist_name;
 }
 
-static void affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw);
+static void affile_dd_retire_writer(AFFileDestDriver *self, AFFileDestWriter *dw);
+static void affile_dd_request_reopen(AFFileDestDriver *self, AFFileDestWriter *dw);
 
 static void
 affile_dw_arm_reaper(AFFileDestWriter *self)
@@ -124,30 +194,33 @@ affile_dw_arm_reaper(AFFileDestWriter *self)
   iv_timer_register(&self->reap_timer);
 }
 
+static gboolean
+affile_dw_is_idle(AFFileDestWriter *self)
+{
+  return !log_writer_has_pending_writes((LogWriter *) self->writer) && g_atomic_int_get(&self->queue_pending) == 0;
+}
+
 static void
 affile_dw_reap(gpointer s)
 {
   AFFileDestWriter *self = (AFFileDestWriter *) s;
-  AFFileDestDriver *owner = self->owner;
 
   main_loop_assert_main_thread();
 
-  g_static_mutex_lock(&owner->lock);
-  if (!log_writer_has_pending_writes((LogWriter *) self->writer) && !self->queue_pending)
-    {
-      msg_verbose("Destination timed out, reaping",
-                  evt_tag_str("template", self->owner->filename_template->template),
-                  evt_tag_str("filename", self->filename));
-      affile_dd_reap_writer(self->owner, self);
-      g_static_mutex_unlock(&owner->lock);
-    }
-  else
+  if (self->retiring)
+    return;
+
+  if (!affile_dw_is_idle(self))
     {
-      g_static_mutex_unlock(&owner->lock);
       affile_dw_arm_reaper(self);
+      return;
     }
+
+  /* reaped once the source threads can't find it anymore */
+  affile_dd_retire_writer(self->owner, self);
 }
 
+/* runs in the main thread, see affile_dw_request_reopen() */
 static gboolean
 affile_dw_reopen(AFFileDestWriter *self)
 {
@@ -182,8 +255,8 @@ affile_dw_reopen(AFFileDestWriter *self)
       proto = file_opener_construct_dst_proto(self->owner->file_opener, transport,
                                               &self->owner->writer_options.proto_options.super);
 
-      if (!iv_timer_registered(&self->reap_timer))
-        main_loop_call((void *(*)(void *)) affile_dw_arm_reaper, self, TRUE);
+      if (!iv_timer_registered(&self->reap_timer) && !self->retiring)
+        affile_dw_arm_reaper(self);
     }
   else
     {
@@ -203,6 +276,7 @@ affile_dw_init(LogPipe *s)
   AFFileDestWriter *self = (AFFileDestWriter *) s;
   GlobalConfig *cfg = log_pipe_get_config(s);
 
+  self->retiring = FALSE;
   if (!self->writer)
     {
       self->writer = log_writer_new(self->owner->writer_flags, cfg);
@@ -246,6 +320,39 @@ affile_dw_deinit(LogPipe *s)
   return TRUE;
 }
 
+/*
+ * Reopens the file in the main thread, can be called from any thread.  The
+ * message being queued is not held back, it is written once the file gets
+ * opened, like the messages queued while the file was closed.
+ */
+static void
+affile_dw_request_reopen(AFFileDestWriter *self)
+{
+  g_static_mutex_lock(&self->lock);
+  if (self->reopen_pending)
+    {
+      g_static_mutex_unlock(&self->lock);
+      return;
+    }
+  self->reopen_pending = TRUE;
+  g_static_mutex_unlock(&self->lock);
+
+  affile_dd_request_reopen(self->owner, self);
+}
+
+static void
+affile_dw_complete_reopen(AFFileDestWriter *self)
+{
+  main_loop_assert_main_thread();
+
+  /* the writer may have been reaped since the request */
+  if (self->super.flags & PIF_INITIALIZED)
+    affile_dw_reopen(self);
+  g_static_mutex_lock(&self->lock);
+  self->reopen_pending = FALSE;
+  g_static_mutex_unlock(&self->lock);
+}
+
 /*
  * NOTE: the caller (e.g. AFFileDestDriver) holds a reference to @self, thus
  * @self may _never_ be freed, even if the reaper timer is elapsed in the
@@ -267,19 +374,14 @@ affile_dw_queue(LogPipe *s, LogMessage *lm, const LogPathOptions *path_options)
   if (self->last_open_stamp == 0)
     self->last_open_stamp = self->last_msg_stamp;
 
-  if (!log_writer_opened(self->writer) &&
-      !self->reopen_pending &&
-      (self->last_open_stamp < self->last_msg_stamp - self->time_reopen))
-    {
-      self->reopen_pending = TRUE;
-      /* if the file couldn't be opened, try it again every time_reopen seconds */
-      g_static_mutex_unlock(&self->lock);
-      affile_dw_reopen(self);
-      g_static_mutex_lock(&self->lock);
-      self->reopen_pending = FALSE;
-    }
+  /* if the file couldn't be opened, try it again every time_reopen seconds */
+  gboolean reopen_needed = !log_writer_opened(self->writer) &&
+                           (self->last_open_stamp < self->last_msg_stamp - self->time_reopen);
   g_static_mutex_unlock(&self->lock);
 
+  if (reopen_needed)
+    affile_dw_request_reopen(self);
+
   log_pipe_forward_msg(&self->super, lm, path_options);
 }
 
@@ -326,7 +428,7 @@ affile_dw_notify(LogPipe *s, gint notify_code, gpointer user_data)
   switch(notify_code)
     {
     case NC_REOPEN_REQUIRED:
-      affile_dw_reopen((AFFileDestWriter *)s);
+      affile_dw_request_reopen((AFFileDestWriter *)s);
       break;
     default:
       break;
@@ -422,17 +524,65 @@ affile_dd_format_persist_name(const LogPipe *s)
   return persist_name;
 }
 
-/* DestDriver lock must be held before calling this function */
 static void
-affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
+affile_dd_sync_writer_map(AFFileDestDriver *self)
 {
-  LogWriter *writer = (LogWriter *)dw->writer;
+  main_loop_assert_main_thread();
+
+  if (affile_dest_writer_map_sync(&self->writer_map))
+    return;
 
+  /* some source threads are still reading the copy to be changed */
+  if (!iv_timer_registered(&self->writer_map_sync_timer))
+    {
+      iv_validate_now();
+      self->writer_map_sync_timer.expires = iv_now;
+      timespec_add_msec(&self->writer_map_sync_timer.expires, AFFILE_DD_WRITER_MAP_SYNC_RETRY_MSEC);
+      iv_timer_register(&self->writer_map_sync_timer);
+    }
+}
+
+static void
+affile_dd_sync_writer_map_timer(gpointer s)
+{
+  affile_dd_sync_writer_map((AFFileDestDriver *) s);
+}
+
+static const gchar *
+affile_dd_writer_map_key(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
+  if (self->filename_is_a_template)
+    return dw->filename;
+  return self->filename_template->template;
+}
+
+/* DestDriver lock must be held, the writer_map is synced by the caller */
+static void
+affile_dd_publish_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
+  main_loop_assert_main_thread();
+
+  if (self->filename_is_a_template)
+    {
+      if (!self->writer_hash)
+        self->writer_hash = g_hash_table_new(g_str_hash, g_str_equal);
+      g_hash_table_insert(self->writer_hash, dw->filename, dw);
+    }
+  else
+    {
+      self->single_writer = dw;
+    }
+  affile_dest_writer_map_insert(&self->writer_map, affile_dd_writer_map_key(self, dw), dw);
+}
+
+/* DestDriver lock must be held */
+static void
+affile_dd_unpublish_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
   main_loop_assert_main_thread();
 
   if (self->filename_is_a_template)
     {
-      /* remove from hash table */
       g_hash_table_remove(self->writer_hash, dw->filename);
     }
   else
@@ -440,6 +590,15 @@ affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
       g_assert(dw == self->single_writer);
       self->single_writer = NULL;
     }
+}
+
+/* DestDriver lock must be held, the writer must have been unpublished */
+static void
+affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
+  LogWriter *writer = (LogWriter *)dw->writer;
+
+  main_loop_assert_main_thread();
 
   LogQueue *queue = log_writer_get_queue(writer);
   log_pipe_deinit(&dw->super);
@@ -447,6 +606,68 @@ affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
   log_pipe_unref(&dw->super);
 }
 
+/*
+ * Removes an idle writer from writer_map, it is reaped by
+ * affile_dd_writer_retired() once no source thread can find it there.
+ */
+static void
+affile_dd_retire_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
+  main_loop_assert_main_thread();
+
+  dw->retiring = TRUE;
+  g_atomic_int_inc(&affile_dd_writer_cache_generation);
+  affile_dest_writer_map_remove(&self->writer_map, affile_dd_writer_map_key(self, dw), dw);
+  affile_dd_sync_writer_map(self);
+}
+
+/* retire callback of writer_map, called from affile_dest_writer_map_sync() */
+static void
+affile_dd_writer_retired(gpointer value, gpointer user_data)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) user_data;
+  AFFileDestWriter *dw = (AFFileDestWriter *) value;
+
+  /* lookups that found the writer in writer_map have bumped queue_pending
+   * by now, the rest find it in writer_hash with the lock held */
+  g_static_mutex_lock(&self->lock);
+  if (affile_dw_is_idle(dw))
+    {
+      msg_verbose("Destination timed out, reaping",
+                  evt_tag_str("template", self->filename_template->template),
+                  evt_tag_str("filename", dw->filename));
+      affile_dd_unpublish_writer(self, dw);
+      affile_dd_reap_writer(self, dw);
+      g_static_mutex_unlock(&self->lock);
+      return;
+    }
+
+  /* a message has arrived meanwhile, added back by the running sync */
+  dw->retiring = FALSE;
+  affile_dest_writer_map_insert(&self->writer_map, affile_dd_writer_map_key(self, dw), dw);
+  g_static_mutex_unlock(&self->lock);
+  affile_dw_arm_reaper(dw);
+}
+
+/* builds writer_map from the writers reused from the previous configuration */
+static void
+affile_dd_init_writer_map(AFFileDestDriver *self)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  affile_dest_writer_map_init(&self->writer_map, affile_dd_writer_retired, self);
+  if (self->writer_hash)
+    {
+      g_hash_table_iter_init(&iter, self->writer_hash);
+      while (g_hash_table_iter_next(&iter, NULL, &value))
+        affile_dest_writer_map_insert(&self->writer_map, affile_dd_writer_map_key(self, value), value);
+    }
+  if (self->single_writer)
+    affile_dest_writer_map_insert(&self->writer_map, affile_dd_writer_map_key(self, self->single_writer),
+                                  self->single_writer);
+  affile_dd_sync_writer_map(self);
+}
 
 /**
  * affile_dd_reuse_writer:
@@ -511,6 +732,9 @@ affile_dd_init(LogPipe *s)
         }
     }
 
+  affile_dd_init_writer_map(self);
+  self->pending_opens = g_hash_table_new(g_str_hash, g_str_equal);
+  iv_event_register(&self->open_requested);
   return TRUE;
 }
 
@@ -561,11 +785,117 @@ affile_dd_deinit_writer(gpointer key, gpointer value, gpointer user_data)
   log_pipe_deinit((LogPipe *) value);
 }
 
+/*
+ * Constructs the writer for a pending open, forwards the messages parked
+ * in the meantime and publishes the writer.  Runs in the main thread.
+ */
+static void
+affile_dd_complete_pending_open(AFFileDestDriver *self, AFFileDestPendingOpen *pending)
+{
+  AFFileDestWriter *next;
+  AFFileDestParkedMsg *parked;
+
+  main_loop_assert_main_thread();
+
+  next = affile_dw_new(pending->filename, log_pipe_get_config(&self->super.super.super));
+  affile_dw_set_owner(next, self);
+  if (!log_pipe_init(&next->super))
+    {
+      log_pipe_unref(&next->super);
+      next = NULL;
+    }
+
+  /* source threads keep parking messages until the writer is published,
+   * forward them in batches without holding the lock, then publish the
+   * writer once the queue has been drained, so ordering is retained */
+  while (TRUE)
+    {
+      GQueue batch;
+
+      g_static_mutex_lock(&self->lock);
+      if (g_queue_is_empty(&pending->msgs))
+        {
+          g_hash_table_remove(self->pending_opens, pending->filename);
+          if (next)
+            affile_dd_publish_writer(self, next);
+          g_static_mutex_unlock(&self->lock);
+          break;
+        }
+      batch = pending->msgs;
+      g_queue_init(&pending->msgs);
+      g_static_mutex_unlock(&self->lock);
+
+      while ((parked = g_queue_pop_head(&batch)))
+        {
+          if (next)
+            log_pipe_queue(&next->super, parked->msg, &parked->path_options);
+          else
+            log_msg_drop(parked->msg, &parked->path_options, AT_PROCESSED);
+          g_free(parked);
+        }
+    }
+}
+
+/*
+ * Handler of the open_requested event, also called from deinit so that
+ * parked messages end up in writers that are persisted across reloads,
+ * instead of being dropped.
+ */
+static void
+affile_dd_open_requested_writers(gpointer s)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+  AFFileDestPendingOpen *pending;
+  AFFileDestWriter *dw;
+  GQueue requested_opens;
+  GQueue requested_reopens;
+
+  g_static_mutex_lock(&self->lock);
+  requested_opens = self->requested_opens;
+  g_queue_init(&self->requested_opens);
+  requested_reopens = self->requested_reopens;
+  g_queue_init(&self->requested_reopens);
+  g_static_mutex_unlock(&self->lock);
+
+  while ((dw = g_queue_pop_head(&requested_reopens)))
+    {
+      affile_dw_complete_reopen(dw);
+      log_pipe_unref(&dw->super);
+    }
+
+  if (g_queue_is_empty(&requested_opens))
+    return;
+
+  while ((pending = g_queue_pop_head(&requested_opens)))
+    {
+      affile_dd_complete_pending_open(self, pending);
+      g_free(pending->filename);
+      g_free(pending);
+    }
+  affile_dd_sync_writer_map(self);
+}
+
+static void
+affile_dd_request_reopen(AFFileDestDriver *self, AFFileDestWriter *dw)
+{
+  g_static_mutex_lock(&self->lock);
+  g_queue_push_tail(&self->requested_reopens, log_pipe_ref(&dw->super));
+  g_static_mutex_unlock(&self->lock);
+
+  iv_event_post(&self->open_requested);
+}
+
 static gboolean
 affile_dd_deinit(LogPipe *s)
 {
   AFFileDestDriver *self = (AFFileDestDriver *) s;
   GlobalConfig *cfg = log_pipe_get_config(s);
+
+  affile_dd_open_requested_writers(self);
+  iv_event_unregister(&self->open_requested);
+  g_hash_table_destroy(self->pending_opens);
+  self->pending_opens = NULL;
+
   /* NOTE: we free all AFFileDestWriter instances here as otherwise we'd
    * have circular references between AFFileDestDriver and file writers */
   if (self->single_writer)
@@ -587,93 +917,166 @@ affile_dd_deinit(LogPipe *s)
       self->writer_hash = NULL;
     }
 
+  /* source threads are not running at this point, writers removed from
+   * writer_map, but not yet reaped are kept for the next configuration */
+  if (iv_timer_registered(&self->writer_map_sync_timer))
+    iv_timer_unregister(&self->writer_map_sync_timer);
+  affile_dest_writer_map_deinit(&self->writer_map);
+  g_atomic_int_inc(&affile_dd_writer_cache_generation);
+
   if (!log_dest_driver_deinit_method(s))
     return FALSE;
 
   return TRUE;
 }
 
+static gint
+affile_dd_get_parked_messages_limit(AFFileDestDriver *self)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
+
+  return self->super.log_fifo_size < 0 ? cfg->log_fifo_size : self->super.log_fifo_size;
+}
+
 /*
- * This function is ran in the main thread whenever a writer is not yet
- * instantiated.  Returns a reference to the newly constructed LogPipe
- * instance where the caller needs to forward its message.
+ * Parks a message until the writer for @filename gets opened.  Returns
+ * TRUE if the open has to be requested from the main thread, FALSE if it
+ * was already requested.  DestDriver lock must be held.
  */
-static LogPipe *
-affile_dd_open_writer(gpointer args[])
+static gboolean
+affile_dd_park_message(AFFileDestDriver *self, const gchar *filename, LogMessage *msg,
+                       const LogPathOptions *path_options)
 {
-  AFFileDestDriver *self = args[0];
-  AFFileDestWriter *next;
+  AFFileDestPendingOpen *pending;
+  AFFileDestParkedMsg *parked;
+  gboolean new_open = FALSE;
 
-  main_loop_assert_main_thread();
-  if (!self->filename_is_a_template)
+  pending = g_hash_table_lookup(self->pending_opens, filename);
+  if (!pending)
     {
-      if (!self->single_writer)
-        {
-          next = affile_dw_new(self->filename_template->template, log_pipe_get_config(&self->super.super.super));
-          affile_dw_set_owner(next, self);
-          if (next && log_pipe_init(&next->super))
-            {
-              log_pipe_ref(&next->super);
-              g_static_mutex_lock(&self->lock);
-              self->single_writer = next;
-              g_static_mutex_unlock(&self->lock);
-            }
-          else
-            {
-              log_pipe_unref(&next->super);
-              next = NULL;
-            }
-        }
-      else
-        {
-          next = self->single_writer;
-          log_pipe_ref(&next->super);
-        }
+      pending = g_new0(AFFileDestPendingOpen, 1);
+      pending->filename = g_strdup(filename);
+      g_queue_init(&pending->msgs);
+      g_hash_table_insert(self->pending_opens, pending->filename, pending);
+      g_queue_push_tail(&self->requested_opens, pending);
+      new_open = TRUE;
     }
-  else
+  else if (!path_options->flow_control_requested &&
+           g_queue_get_length(&pending->msgs) >= affile_dd_get_parked_messages_limit(self))
     {
-      GString *filename = args[1];
+      msg_debug("Destination file is being opened and too many messages are waiting for it, dropping message",
+                evt_tag_str("filename", filename),
+                evt_tag_int("log_fifo_size", affile_dd_get_parked_messages_limit(self)));
+      log_msg_drop(msg, path_options, AT_PROCESSED);
+      return FALSE;
+    }
 
-      /* hash table construction is serialized, as we only do that in the main thread. */
-      if (!self->writer_hash)
-        self->writer_hash = g_hash_table_new(g_str_hash, g_str_equal);
+  parked = g_new(AFFileDestParkedMsg, 1);
+  log_msg_add_ack(msg, path_options);
+  parked->msg = log_msg_ref(msg);
+  parked->path_options = *path_options;
+  parked->path_options.matched = NULL;
+  g_queue_push_tail(&pending->msgs, parked);
 
-      /* we don't need to lock the hashtable as it is only written in
-       * the main thread, which we're running right now.  lookups in
-       * other threads must be locked. writers must be locked even in
-       * this thread to exclude lookups in other threads.  */
+  return new_open;
+}
 
-      next = g_hash_table_lookup(self->writer_hash, filename->str);
-      if (!next)
-        {
-          next = affile_dw_new(filename->str, log_pipe_get_config(&self->super.super.super));
-          affile_dw_set_owner(next, self);
-          if (!log_pipe_init(&next->super))
-            {
-              log_pipe_unref(&next->super);
-              next = NULL;
-            }
-          else
-            {
-              log_pipe_ref(&next->super);
-              g_static_mutex_lock(&self->lock);
-              g_hash_table_insert(self->writer_hash, next->filename, next);
-              g_static_mutex_unlock(&self->lock);
-            }
-        }
-      else
-        {
-          log_pipe_ref(&next->super);
-        }
-    }
+static inline void
+affile_dd_ref_writer_for_queue(AFFileDestWriter *dw)
+{
+  log_pipe_ref(&dw->super);
+  g_atomic_int_inc(&dw->queue_pending);
+}
+
+/*
+ * Slow path of the writer lookup, either the writer is not in writer_map
+ * (yet or anymore), or @msg is parked until the main thread opens the
+ * file.  Returns a reference to the writer, or NULL if @msg was parked.
+ */
+static AFFileDestWriter *
+affile_dd_lookup_writer_or_park_message(AFFileDestDriver *self, const gchar *filename, LogMessage *msg,
+                                        const LogPathOptions *path_options)
+{
+  AFFileDestWriter *next;
+  gboolean open_needed = FALSE;
+
+  g_static_mutex_lock(&self->lock);
+  if (self->filename_is_a_template)
+    next = self->writer_hash ? g_hash_table_lookup(self->writer_hash, filename) : NULL;
+  else
+    next = self->single_writer;
 
   if (next)
+    affile_dd_ref_writer_for_queue(next);
+  else
+    open_needed = affile_dd_park_message(self, filename, msg, path_options);
+  g_static_mutex_unlock(&self->lock);
+
+  if (open_needed)
+    iv_event_post(&self->open_requested);
+  return next;
+}
+
+/* must be called in a writer_map read section of @copy */
+static AFFileDestWriter *
+affile_dd_lookup_writer(AFFileDestDriver *self, gint copy, const gchar *filename)
+{
+  AFFileDestWriterCache *cache = &last_writer;
+  gint generation = g_atomic_int_get(&affile_dd_writer_cache_generation);
+  AFFileDestWriter *next;
+
+  if (cache->owner == self && cache->generation == generation &&
+      strcmp(cache->filename, filename) == 0)
+    return cache->writer;
+
+  next = affile_dest_writer_map_lookup(&self->writer_map, copy, filename);
+  if (next && strlen(filename) < sizeof(cache->filename))
     {
-      next->queue_pending = TRUE;
-      /* we're returning a reference */
-      return &next->super;
+      cache->owner = self;
+      cache->generation = generation;
+      cache->writer = next;
+      strcpy(cache->filename, filename);
     }
-  return NULL;
+  return next;
+}
+
+/*
+ * Returns a reference to the writer where @msg is to be forwarded, or NULL
+ * if the message has been parked, waiting for its file to be opened.
+ */
+static AFFileDestWriter *
+affile_dd_get_writer(AFFileDestDriver *self, const gchar *filename, LogMessage *msg,
+                     const LogPathOptions *path_options)
+{
+  AFFileDestWriter *next;
+  gint copy;
+
+  copy = affile_dest_writer_map_read_begin(&self->writer_map);
+  next = affile_dd_lookup_writer(self, copy, filename);
+  if (next)
+    affile_dd_ref_writer_for_queue(next);
+  affile_dest_writer_map_read_end(&self->writer_map, copy);
+
+  if (!next)
+    next = affile_dd_lookup_writer_or_park_message(self, filename, msg, path_options);
+  return next;
+}
+
+static AFFileDestWriter *
+affile_dd_get_templated_writer(AFFileDestDriver *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  AFFileDestWriter *next;
+  ScratchBuffersMarker mark;
+  GString *filename;
+
+  scratch_buffers_mark(&mark);
+  filename = scratch_buffers_alloc();
+  log_template_format(self->filename_template, msg, &self->writer_options.template_options, LTZ_LOCAL, 0, NULL, filename);
+
+  next = affile_dd_get_writer(self, filename->str, msg, path_options);
+
+  scratch_buffers_reclaim_marked(mark);
+  return next;
 }
 
 static void
@@ -681,60 +1084,17 @@ affile_dd_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
 {
   AFFileDestDriver *self = (AFFileDestDriver *) s;
   AFFileDestWriter *next;
-  gpointer args[2] = { self, NULL };
 
   if (!self->filename_is_a_template)
-    {
-
-      /* we need to lock single_writer in order to get a reference and
-       * make sure it is not a stale pointer by the time we ref it */
-
-      g_static_mutex_lock(&self->lock);
-      if (!self->single_writer)
-        {
-          g_static_mutex_unlock(&self->lock);
-          next = main_loop_call((void *(*)(void *)) affile_dd_open_writer, args, TRUE);
-        }
-      else
-        {
-          next = self->single_writer;
-          next->queue_pending = TRUE;
-          log_pipe_ref(&next->super);
-          g_static_mutex_unlock(&self->lock);
-        }
-    }
+    next = affile_dd_get_writer(self, self->filename_template->template, msg, path_options);
   else
-    {
-      GString *filename;
-
-      filename = g_string_sized_new(32);
-      log_template_format(self->filename_template, msg, &self->writer_options.template_options, LTZ_LOCAL, 0, NULL, filename);
+    next = affile_dd_get_templated_writer(self, msg, path_options);
 
-      g_static_mutex_lock(&self->lock);
-      if (self->writer_hash)
-        next = g_hash_table_lookup(self->writer_hash, filename->str);
-      else
-        next = NULL;
-
-      if (next)
-        {
-          log_pipe_ref(&next->super);
-          next->queue_pending = TRUE;
-          g_static_mutex_unlock(&self->lock);
-        }
-      else
-        {
-          g_static_mutex_unlock(&self->lock);
-          args[1] = filename;
-          next = main_loop_call((void *(*)(void *)) affile_dd_open_writer, args, TRUE);
-        }
-      g_string_free(filename, TRUE);
-    }
   if (next)
     {
       log_msg_add_ack(msg, path_options);
       log_pipe_queue(&next->super, log_msg_ref(msg), path_options);
-      next->queue_pending = FALSE;
+      g_atomic_int_add(&next->queue_pending, -1);
       log_pipe_unref(&next->super);
     }
 
@@ -785,6 +1145,14 @@ affile_dd_new_instance(gchar *filename, GlobalConfig *cfg)
 
   self->time_reap = -1;
   g_static_mutex_init(&self->lock);
+  g_queue_init(&self->requested_opens);
+  g_queue_init(&self->requested_reopens);
+  IV_TIMER_INIT(&self->writer_map_sync_timer);
+  self->writer_map_sync_timer.cookie = self;
+  self->writer_map_sync_timer.handler = affile_dd_sync_writer_map_timer;
+  IV_EVENT_INIT(&self->open_requested);
+  self->open_requested.cookie = self;
+  self->open_requested.handler = affile_dd_open_requested_writers;
 
   affile_dest_drivers = g_list_append(affile_dest_drivers, self);
 
@@ -27,6 +27,10 @@
 #include "driver.h"
 #include "logwriter.h"
 #include "file-opener.h"
+#include "affile-dest-writer-map.h"
+
+#include <iv.h>
+#include <iv_event.h>
 
 typedef struct _AFFileDestWriter AFFileDestWriter;
 
@@ -45,6 +49,12 @@ typedef struct _AFFileDestDriver
   LogWriterOptions writer_options;
   guint32 writer_flags;
   GHashTable *writer_hash;
+  AFFileDestWriterMap writer_map;
+  struct iv_timer writer_map_sync_timer;
+  GHashTable *pending_opens;
+  GQueue requested_opens;
+  GQueue requested_reopens;
+  struct iv_event open_requested;
 
   gint overwrite_if_older;
   gboolean use_time_recvd;
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "file-monitor-inotify.h"
+#include "messages.h"
+#include "mainloop.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Shared inotify watches for followed files.
+ *
+ * All followed files are watched through a single inotify instance, as the
+ * number of inotify instances per user is severely limited.  inotify
+ * returns the same watch descriptor for the same inode, so files opened by
+ * several readers are watched only once and the events are dispatched to
+ * every subscriber.  Only used from the main thread.
+ */
+
+#define FILE_MONITOR_INOTIFY_MASK (IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+typedef struct _FileInodeWatch
+{
+  dev_t dev;
+  ino_t ino;
+  struct iv_inotify_watch watcher;
+  GList *subscriptions;
+} FileInodeWatch;
+
+struct _FileMonitorInotifySubscription
+{
+  FileInodeWatch *watch;
+  FileMonitorInotifyCallback callback;
+  gpointer user_data;
+};
+
+static struct iv_inotify file_monitor_inotify;
+static GHashTable *file_monitor_watches;
+
+static guint
+_inode_hash(gconstpointer key)
+{
+  const FileInodeWatch *watch = (const FileInodeWatch *) key;
+
+  return (guint) (watch->ino ^ watch->dev);
+}
+
+static gboolean
+_inode_equal(gconstpointer a, gconstpointer b)
+{
+  const FileInodeWatch *wa = (const FileInodeWatch *) a;
+  const FileInodeWatch *wb = (const FileInodeWatch *) b;
+
+  return wa->ino == wb->ino && wa->dev == wb->dev;
+}
+
+static gboolean
+_inotify_acquire(void)
+{
+  if (file_monitor_watches)
+    return TRUE;
+
+  IV_INOTIFY_INIT(&file_monitor_inotify);
+  if (iv_inotify_register(&file_monitor_inotify))
+    {
+      msg_debug("file-monitor-inotify: could not create inotify object, falling back to polling",
+                evt_tag_errno("errno", errno));
+      return FALSE;
+    }
+  file_monitor_watches = g_hash_table_new(_inode_hash, _inode_equal);
+  return TRUE;
+}
+
+static void
+_inotify_release(void)
+{
+  if (g_hash_table_size(file_monitor_watches) > 0)
+    return;
+
+  g_hash_table_destroy(file_monitor_watches);
+  file_monitor_watches = NULL;
+  iv_inotify_unregister(&file_monitor_inotify);
+}
+
+static void
+_forget_watch(FileInodeWatch *watch)
+{
+  GList *l;
+
+  for (l = watch->subscriptions; l; l = l->next)
+    ((FileMonitorInotifySubscription *) l->data)->watch = NULL;
+  g_list_free(watch->subscriptions);
+
+  g_hash_table_remove(file_monitor_watches, watch);
+  g_free(watch);
+  _inotify_release();
+}
+
+static void
+_handle_event(gpointer s, struct inotify_event *event)
+{
+  FileInodeWatch *watch = (FileInodeWatch *) s;
+  GList *l;
+
+  for (l = watch->subscriptions; l; l = l->next)
+    {
+      FileMonitorInotifySubscription *subscription = (FileMonitorInotifySubscription *) l->data;
+
+      subscription->callback(event->mask, subscription->user_data);
+    }
+
+  /* the kernel has dropped the watch, it is already removed from the inotify object */
+  if (event->mask & IN_IGNORED)
+    _forget_watch(watch);
+}
+
+static FileInodeWatch *
+_watch_inode(gint fd, struct stat *st)
+{
+  FileInodeWatch lookup = { .dev = st->st_dev, .ino = st->st_ino };
+  FileInodeWatch *watch;
+  gchar fd_path[64];
+
+  watch = g_hash_table_lookup(file_monitor_watches, &lookup);
+  if (watch)
+    return watch;
+
+  watch = g_new0(FileInodeWatch, 1);
+  watch->dev = st->st_dev;
+  watch->ino = st->st_ino;
+
+  /* watch the inode we have opened, the filename may point elsewhere by now */
+  g_snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
+
+  IV_INOTIFY_WATCH_INIT(&watch->watcher);
+  watch->watcher.inotify = &file_monitor_inotify;
+  watch->watcher.pathname = fd_path;
+  watch->watcher.mask = FILE_MONITOR_INOTIFY_MASK;
+  watch->watcher.cookie = watch;
+  watch->watcher.handler = _handle_event;
+  if (iv_inotify_watch_register(&watch->watcher) < 0)
+    {
+      msg_debug("file-monitor-inotify: could not add inotify watch, falling back to polling",
+                evt_tag_int("fd", fd),
+                evt_tag_errno("errno", errno));
+      g_free(watch);
+      return NULL;
+    }
+  /* pathname is only used while registering */
+  watch->watcher.pathname = NULL;
+
+  g_hash_table_insert(file_monitor_watches, watch, watch);
+  return watch;
+}
+
+FileMonitorInotifySubscription *
+file_monitor_inotify_subscribe(gint fd, FileMonitorInotifyCallback callback, gpointer user_data)
+{
+  FileMonitorInotifySubscription *subscription;
+  FileInodeWatch *watch;
+  struct stat st;
+
+  main_loop_assert_main_thread();
+
+  if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+    return NULL;
+
+  if (!_inotify_acquire())
+    return NULL;
+
+  watch = _watch_inode(fd, &st);
+  if (!watch)
+    {
+      _inotify_release();
+      return NULL;
+    }
+
+  subscription = g_new0(FileMonitorInotifySubscription, 1);
+  subscription->watch = watch;
+  subscription->callback = callback;
+  subscription->user_data = user_data;
+  watch->subscriptions = g_list_prepend(watch->subscriptions, subscription);
+  return subscription;
+}
+
+void
+file_monitor_inotify_unsubscribe(FileMonitorInotifySubscription *subscription)
+{
+  FileInodeWatch *watch = subscription->watch;
+
+  main_loop_assert_main_thread();
+
+  if (watch)
+    {
+      watch->subscriptions = g_list_remove(watch->subscriptions, subscription);
+      if (!watch->subscriptions)
+        {
+          iv_inotify_watch_unregister(&watch->watcher);
+          g_hash_table_remove(file_monitor_watches, watch);
+          g_free(watch);
+          _inotify_release();
+        }
+    }
+  g_free(subscription);
+}
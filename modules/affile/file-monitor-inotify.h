@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#ifndef MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_
+#define MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_
+
+#include "syslog-ng.h"
+#include <iv_inotify.h>
+
+typedef struct _FileMonitorInotifySubscription FileMonitorInotifySubscription;
+
+/* called with the inotify event mask, must not unsubscribe */
+typedef void (*FileMonitorInotifyCallback)(guint32 mask, gpointer user_data);
+
+FileMonitorInotifySubscription *file_monitor_inotify_subscribe(gint fd, FileMonitorInotifyCallback callback,
+    gpointer user_data);
+void file_monitor_inotify_unsubscribe(FileMonitorInotifySubscription *subscription);
+
+#endif /* MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_ */
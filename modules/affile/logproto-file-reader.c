@@ -39,6 +39,7 @@ log_proto_file_reader_options_defaults(LogProtoFileReaderOptions *options)
 {
   log_proto_multi_line_server_options_defaults(&options->super);
   options->pad_size = 0;
+  options->read_ahead = 0;
 }
 
 void
@@ -30,6 +30,8 @@ typedef struct _LogProtoFileReaderOptions
 {
   LogProtoMultiLineServerOptions super;
   gint pad_size;
+  /* bytes to request in advance while catching up with a backlog, 0 to disable */
+  gint read_ahead;
 } LogProtoFileReaderOptions;
 
 LogProtoServer *log_proto_file_reader_new(LogTransport *transport, const LogProtoFileReaderOptions *options);
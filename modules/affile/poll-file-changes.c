@@ -24,6 +24,10 @@
 #include "logpipe.h"
 #include "timeutils/timeutils.h"
 
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "file-monitor-inotify.h"
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -46,8 +50,26 @@ typedef struct _PollFileChanges
   gint follow_freq;
   struct iv_timer follow_timer;
   LogPipe *control;
+#if SYSLOG_NG_HAVE_INOTIFY
+  /* while at EOF, wait for inotify to tell us about changes instead of polling */
+  FileMonitorInotifySubscription *inotify;
+  gboolean inotify_tried;
+  gboolean file_rotated;
+  gboolean idle_at_eof;
+  gboolean input_requested;
+#endif
 } PollFileChanges;
 
+static void poll_file_changes_rearm_timer(PollFileChanges *self, gint delay);
+
+#if SYSLOG_NG_HAVE_INOTIFY
+static inline gboolean
+poll_file_changes_is_inotify_usable(PollFileChanges *self)
+{
+  return self->inotify && !self->file_rotated;
+}
+#endif
+
 /* follow timer callback. Check if the file has new content, or deleted or
  * moved.  Ran every follow_freq seconds.  */
 static void
@@ -94,12 +116,18 @@ poll_file_changes_check_file(gpointer s)
       if (pos < st.st_size || !S_ISREG(st.st_mode))
         {
           /* we have data to read */
+#if SYSLOG_NG_HAVE_INOTIFY
+          self->idle_at_eof = FALSE;
+#endif
           poll_events_invoke_callback(s);
           return;
         }
       else if (pos == st.st_size)
         {
           /* we are at EOF */
+#if SYSLOG_NG_HAVE_INOTIFY
+          self->idle_at_eof = poll_file_changes_is_inotify_usable(self);
+#endif
           log_pipe_notify(self->control, NC_FILE_EOF, self);
         }
       else if (pos > st.st_size)
@@ -138,21 +166,72 @@ reschedule:
   poll_events_update_watches(s, G_IO_IN);
 }
 
+#if SYSLOG_NG_HAVE_INOTIFY
+
+static gboolean
+_is_unlinked(PollFileChanges *self)
+{
+  struct stat st;
+
+  return fstat(self->fd, &st) < 0 || st.st_nlink == 0;
+}
+
+static void
+poll_file_changes_inotify_event(guint32 mask, gpointer s)
+{
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  if ((mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) ||
+      ((mask & IN_ATTRIB) && _is_unlinked(self)))
+    {
+      /* the file is being rotated, the next one can only be found by
+       * polling the filename, which is what we fall back to from now on */
+      msg_trace("Followed file moved or deleted, falling back to polling",
+                evt_tag_str("follow_filename", self->follow_filename));
+      self->file_rotated = TRUE;
+    }
+  else if (!(mask & (IN_MODIFY | IN_ATTRIB)))
+    {
+      return;
+    }
+
+  if (self->idle_at_eof && self->input_requested && !iv_timer_registered(&self->follow_timer))
+    {
+      self->idle_at_eof = FALSE;
+      poll_file_changes_rearm_timer(self, 0);
+    }
+}
+
+static void
+poll_file_changes_start_inotify(PollFileChanges *self)
+{
+  if (self->inotify_tried)
+    return;
+
+  self->inotify_tried = TRUE;
+  self->inotify = file_monitor_inotify_subscribe(self->fd, poll_file_changes_inotify_event, self);
+}
+
+#endif
+
 static void
 poll_file_changes_stop_watches(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
+#if SYSLOG_NG_HAVE_INOTIFY
+  self->input_requested = FALSE;
+#endif
   if (iv_timer_registered(&self->follow_timer))
     iv_timer_unregister(&self->follow_timer);
 }
 
 static void
-poll_file_changes_rearm_timer(PollFileChanges *self)
+poll_file_changes_rearm_timer(PollFileChanges *self, gint delay)
 {
   iv_validate_now();
   self->follow_timer.expires = iv_now;
-  timespec_add_msec(&self->follow_timer.expires, self->follow_freq);
+  timespec_add_msec(&self->follow_timer.expires, delay);
   iv_timer_register(&self->follow_timer);
 }
 
@@ -166,8 +245,19 @@ poll_file_changes_update_watches(PollEvents *s, GIOCondition cond)
 
   poll_file_changes_stop_watches(s);
 
-  if (cond & G_IO_IN)
-    poll_file_changes_rearm_timer(self);
+  if (!(cond & G_IO_IN))
+    return;
+
+#if SYSLOG_NG_HAVE_INOTIFY
+  poll_file_changes_start_inotify(self);
+  self->input_requested = TRUE;
+
+  /* nothing to do until the file changes, inotify is going to wake us up */
+  if (poll_file_changes_is_inotify_usable(self) && self->idle_at_eof)
+    return;
+#endif
+
+  poll_file_changes_rearm_timer(self, self->follow_freq);
 }
 
 static void
@@ -175,6 +265,10 @@ poll_file_changes_free(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->inotify)
+    file_monitor_inotify_unsubscribe(self->inotify);
+#endif
   log_pipe_unref(self->control);
   g_free(self->follow_filename);
 }
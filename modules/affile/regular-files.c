@@ -22,6 +22,7 @@
  */
 #include "file-specializations.h"
 #include "transport/transport-file.h"
+#include "transport-regular-file.h"
 #include "logproto-file-writer.h"
 #include "messages.h"
 
@@ -51,15 +52,14 @@ _prepare_open(FileOpener *self, const gchar *name)
 static LogTransport *
 _construct_src_transport(FileOpener *self, gint fd)
 {
-  LogTransport *transport = log_transport_file_new(fd);
-
-  transport->read = log_transport_file_read_and_ignore_eof_method;
-  return transport;
+  return log_transport_regular_file_new(fd);
 }
 
 static LogProtoServer *
 _construct_src_proto(FileOpener *s, LogTransport *transport, LogProtoFileReaderOptions *proto_options)
 {
+  if (log_transport_is_regular_file(transport))
+    log_transport_regular_file_set_read_ahead(transport, proto_options->read_ahead);
   proto_options->super.super.position_tracking_enabled = TRUE;
   return log_proto_file_reader_new(transport, proto_options);
 }
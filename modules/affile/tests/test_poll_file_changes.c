@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "syslog-ng.h"
+
+#if SYSLOG_NG_HAVE_INOTIFY
+
+#include "poll-file-changes.c"
+#include "file-monitor-inotify.c"
+#include "apphook.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+
+#define TEST_FILE "test_poll_file_changes.log"
+#define ROTATED_TEST_FILE "test_poll_file_changes.log.1"
+/* long enough not to expire during the tests, only inotify can wake us up */
+#define FOLLOW_FREQ 60000
+#define WAIT_TIMEOUT 5000
+
+typedef struct _TestControl
+{
+  LogPipe super;
+  gint eof_count;
+  gint moved_count;
+} TestControl;
+
+typedef struct _TestSubscriber
+{
+  guint32 mask;
+} TestSubscriber;
+
+static gboolean timed_out;
+static gboolean input_available;
+
+static void
+_append_to_test_file(const gchar *data)
+{
+  FILE *f = fopen(TEST_FILE, "a");
+
+  cr_assert_not_null(f);
+  cr_assert_eq(fwrite(data, 1, strlen(data), f), strlen(data));
+  fclose(f);
+}
+
+static gint
+_open_test_file_at_eof(void)
+{
+  gint fd = open(TEST_FILE, O_RDONLY);
+
+  cr_assert(fd >= 0);
+  cr_assert_neq(lseek(fd, 0, SEEK_END), (off_t) -1);
+  return fd;
+}
+
+static void
+_wait_timeout(gpointer s)
+{
+  timed_out = TRUE;
+  iv_quit();
+}
+
+/* runs the main loop until one of the callbacks quits it */
+static void
+_run_main_loop(void)
+{
+  struct iv_timer timeout;
+
+  IV_TIMER_INIT(&timeout);
+  timeout.handler = _wait_timeout;
+  iv_validate_now();
+  timeout.expires = iv_now;
+  timespec_add_msec(&timeout.expires, WAIT_TIMEOUT);
+  iv_timer_register(&timeout);
+
+  iv_main();
+
+  if (iv_timer_registered(&timeout))
+    iv_timer_unregister(&timeout);
+  cr_assert_not(timed_out, "Timed out waiting for inotify events");
+}
+
+static void
+_subscriber_callback(guint32 mask, gpointer user_data)
+{
+  TestSubscriber *subscriber = (TestSubscriber *) user_data;
+
+  subscriber->mask |= mask;
+  iv_quit();
+}
+
+static void
+_test_control_notify(LogPipe *s, gint notify_code, gpointer user_data)
+{
+  TestControl *self = (TestControl *) s;
+
+  if (notify_code == NC_FILE_EOF)
+    self->eof_count++;
+  else if (notify_code == NC_FILE_MOVED)
+    self->moved_count++;
+  iv_quit();
+}
+
+static TestControl *
+_test_control_new(void)
+{
+  TestControl *self = g_new0(TestControl, 1);
+
+  log_pipe_init_instance(&self->super, NULL);
+  self->super.notify = _test_control_notify;
+  return self;
+}
+
+static void
+_input_callback(gpointer user_data)
+{
+  input_available = TRUE;
+  iv_quit();
+}
+
+/* starts following the file and checks it once, so that it is idle at EOF */
+static PollFileChanges *
+_follow_test_file_idle_at_eof(gint fd, TestControl *control)
+{
+  PollFileChanges *self = (PollFileChanges *) poll_file_changes_new(fd, TEST_FILE, FOLLOW_FREQ, &control->super);
+
+  poll_events_set_callback(&self->super, _input_callback, NULL);
+  poll_events_update_watches(&self->super, G_IO_IN);
+  cr_assert_not_null(self->inotify);
+
+  poll_file_changes_check_file(self);
+  cr_assert_eq(control->eof_count, 1);
+  cr_assert(self->idle_at_eof);
+  cr_assert_not(iv_timer_registered(&self->follow_timer), "Followed file is polled while idle at EOF");
+  return self;
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  unlink(TEST_FILE);
+  unlink(ROTATED_TEST_FILE);
+  _append_to_test_file("first line\n");
+}
+
+static void
+teardown(void)
+{
+  unlink(TEST_FILE);
+  unlink(ROTATED_TEST_FILE);
+  app_shutdown();
+}
+
+TestSuite(file_monitor_inotify, .init = setup, .fini = teardown);
+
+Test(file_monitor_inotify, test_subscribers_of_the_same_file_share_a_watch)
+{
+  TestSubscriber subscriber1 = { 0 }, subscriber2 = { 0 };
+  gint fd1 = _open_test_file_at_eof();
+  gint fd2 = _open_test_file_at_eof();
+  FileMonitorInotifySubscription *subscription1 = file_monitor_inotify_subscribe(fd1, _subscriber_callback,
+                                                  &subscriber1);
+  FileMonitorInotifySubscription *subscription2 = file_monitor_inotify_subscribe(fd2, _subscriber_callback,
+                                                  &subscriber2);
+
+  cr_assert_not_null(subscription1);
+  cr_assert_not_null(subscription2);
+  cr_assert_eq(subscription1->watch, subscription2->watch);
+  cr_assert_eq(g_hash_table_size(file_monitor_watches), 1);
+
+  _append_to_test_file("second line\n");
+  _run_main_loop();
+  cr_assert(subscriber1.mask & IN_MODIFY);
+  cr_assert(subscriber2.mask & IN_MODIFY);
+
+  file_monitor_inotify_unsubscribe(subscription1);
+  cr_assert_eq(g_hash_table_size(file_monitor_watches), 1);
+  file_monitor_inotify_unsubscribe(subscription2);
+  cr_assert_null(file_monitor_watches);
+
+  close(fd1);
+  close(fd2);
+}
+
+Test(file_monitor_inotify, test_non_regular_files_are_not_watched)
+{
+  TestSubscriber subscriber = { 0 };
+  gint fds[2];
+
+  cr_assert_eq(pipe(fds), 0);
+  cr_assert_null(file_monitor_inotify_subscribe(fds[0], _subscriber_callback, &subscriber));
+  cr_assert_null(file_monitor_inotify_subscribe(-1, _subscriber_callback, &subscriber));
+  cr_assert_null(file_monitor_watches);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+Test(file_monitor_inotify, test_watch_is_forgotten_once_dropped_by_the_kernel)
+{
+  TestSubscriber subscriber = { 0 };
+  gint fd = _open_test_file_at_eof();
+  FileMonitorInotifySubscription *subscription = file_monitor_inotify_subscribe(fd, _subscriber_callback,
+                                                 &subscriber);
+
+  cr_assert_not_null(subscription);
+
+  /* the inode goes away with the last reference to it */
+  unlink(TEST_FILE);
+  close(fd);
+
+  while (!(subscriber.mask & IN_IGNORED))
+    _run_main_loop();
+
+  cr_assert_null(subscription->watch);
+  cr_assert_null(file_monitor_watches);
+  file_monitor_inotify_unsubscribe(subscription);
+}
+
+TestSuite(poll_file_changes, .init = setup, .fini = teardown);
+
+Test(poll_file_changes, test_inotify_wakes_up_the_reader_idle_at_eof)
+{
+  TestControl *control = _test_control_new();
+  gint fd = _open_test_file_at_eof();
+  PollFileChanges *self = _follow_test_file_idle_at_eof(fd, control);
+
+  _append_to_test_file("second line\n");
+  _run_main_loop();
+  cr_assert(input_available);
+  cr_assert_not(self->idle_at_eof);
+
+  /* there is data to read, polling is back until the next EOF */
+  poll_events_update_watches(&self->super, G_IO_IN);
+  cr_assert(iv_timer_registered(&self->follow_timer));
+
+  poll_events_stop_watches(&self->super);
+  poll_events_free(&self->super);
+  log_pipe_unref(&control->super);
+  close(fd);
+}
+
+Test(poll_file_changes, test_rotation_falls_back_to_polling)
+{
+  TestControl *control = _test_control_new();
+  gint fd = _open_test_file_at_eof();
+  PollFileChanges *self = _follow_test_file_idle_at_eof(fd, control);
+
+  cr_assert_eq(rename(TEST_FILE, ROTATED_TEST_FILE), 0);
+  _run_main_loop();
+  cr_assert(self->file_rotated);
+
+  /* the immediate check after the event finds the reader at EOF again */
+  cr_assert_eq(control->eof_count, 2);
+  cr_assert_not(self->idle_at_eof);
+  cr_assert(iv_timer_registered(&self->follow_timer), "Rotated file is not polled");
+
+  /* the new file can only be found by polling its name */
+  _append_to_test_file("new file\n");
+  poll_file_changes_check_file(self);
+  cr_assert_eq(control->moved_count, 1);
+
+  poll_events_stop_watches(&self->super);
+  poll_events_free(&self->super);
+  log_pipe_unref(&control->super);
+  close(fd);
+}
+
+#endif
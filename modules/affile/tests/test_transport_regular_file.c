@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport-regular-file.c"
+#include "apphook.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FILE "test_transport_regular_file.log"
+#define BACKLOG_LINES 1000
+
+static GString *backlog;
+
+static void
+_append_to_test_file(const gchar *data, gsize len)
+{
+  FILE *f = fopen(TEST_FILE, "a");
+
+  cr_assert_not_null(f);
+  cr_assert_eq(fwrite(data, 1, len, f), len);
+  fclose(f);
+}
+
+static LogTransport *
+_open_test_file(gsize read_ahead)
+{
+  gint fd = open(TEST_FILE, O_RDONLY);
+  LogTransport *transport;
+
+  cr_assert(fd >= 0);
+  transport = log_transport_regular_file_new(fd);
+  log_transport_regular_file_set_read_ahead(transport, read_ahead);
+  return transport;
+}
+
+/* reads in small chunks until EOF, checking that the fd position is never
+ * ahead of what was returned */
+static GString *
+_read_until_eof(LogTransport *transport)
+{
+  off_t start = lseek(transport->fd, 0, SEEK_CUR);
+  GString *result = g_string_new("");
+  gchar buf[100];
+  gssize rc;
+
+  while ((rc = log_transport_read(transport, buf, sizeof(buf), NULL)) > 0)
+    {
+      g_string_append_len(result, buf, rc);
+      cr_assert_eq(lseek(transport->fd, 0, SEEK_CUR), start + (off_t) result->len);
+    }
+
+  /* EOF is reported as "try again later" */
+  cr_assert_eq(rc, -1);
+  cr_assert_eq(errno, EAGAIN);
+  return result;
+}
+
+static void
+setup(void)
+{
+  gint i;
+
+  app_startup();
+  unlink(TEST_FILE);
+
+  backlog = g_string_new("");
+  for (i = 0; i < BACKLOG_LINES; i++)
+    g_string_append_printf(backlog, "backlog line %d\n", i);
+  _append_to_test_file(backlog->str, backlog->len);
+}
+
+static void
+teardown(void)
+{
+  g_string_free(backlog, TRUE);
+  unlink(TEST_FILE);
+  app_shutdown();
+}
+
+TestSuite(transport_regular_file, .init = setup, .fini = teardown);
+
+Test(transport_regular_file, test_regular_file_transport_is_recognized)
+{
+  LogTransport *regular = log_transport_regular_file_new(-1);
+  LogTransport *plain = log_transport_file_new(-1);
+
+  cr_assert(log_transport_is_regular_file(regular));
+  cr_assert_not(log_transport_is_regular_file(plain));
+
+  log_transport_free(regular);
+  log_transport_free(plain);
+}
+
+Test(transport_regular_file, test_file_is_followed_without_read_ahead)
+{
+  LogTransport *transport = _open_test_file(0);
+  GString *result;
+
+  result = _read_until_eof(transport);
+  cr_assert_str_eq(result->str, backlog->str);
+  g_string_free(result, TRUE);
+
+  _append_to_test_file("appended\n", strlen("appended\n"));
+  result = _read_until_eof(transport);
+  cr_assert_str_eq(result->str, "appended\n");
+  g_string_free(result, TRUE);
+
+  log_transport_free(transport);
+}
+
+#ifdef POSIX_FADV_SEQUENTIAL
+
+Test(transport_regular_file, test_read_ahead_is_enabled_while_catching_up_with_a_backlog)
+{
+  LogTransport *transport = _open_test_file(1024);
+  LogTransportRegularFile *self = (LogTransportRegularFile *) transport;
+  GString *result = g_string_new("");
+  gchar buf[100];
+  gssize rc;
+
+  rc = log_transport_read(transport, buf, sizeof(buf), NULL);
+  cr_assert_eq(rc, sizeof(buf));
+  g_string_append_len(result, buf, rc);
+  cr_assert(self->catching_up);
+  /* a read-ahead window is requested beyond what was read */
+  cr_assert_geq(self->advised_until, self->read_pos + 1024 / 2);
+
+  cr_assert_eq(lseek(transport->fd, 0, SEEK_CUR), (off_t) result->len);
+
+  GString *rest = _read_until_eof(transport);
+  g_string_append_len(result, rest->str, rest->len);
+  g_string_free(rest, TRUE);
+
+  cr_assert_str_eq(result->str, backlog->str);
+  cr_assert_eq(self->read_pos, (off_t) backlog->len);
+  /* back to normal tailing at EOF */
+  cr_assert_not(self->catching_up);
+
+  g_string_free(result, TRUE);
+  log_transport_free(transport);
+}
+
+Test(transport_regular_file, test_read_ahead_is_not_enabled_for_a_small_backlog)
+{
+  LogTransport *transport = _open_test_file(backlog->len + 1);
+  LogTransportRegularFile *self = (LogTransportRegularFile *) transport;
+  GString *result;
+
+  result = _read_until_eof(transport);
+  cr_assert_str_eq(result->str, backlog->str);
+  cr_assert(self->catch_up_checked);
+  cr_assert_not(self->catching_up);
+  cr_assert_eq(self->advised_until, 0);
+
+  g_string_free(result, TRUE);
+  log_transport_free(transport);
+}
+
+#endif
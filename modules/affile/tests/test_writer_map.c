@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "affile-dest-writer-map.h"
+
+static AFFileDestWriterMap map;
+static GList *retired;
+static gboolean insert_on_retire;
+
+static void
+_retire(gpointer value, gpointer user_data)
+{
+  retired = g_list_append(retired, value);
+  if (insert_on_retire)
+    affile_dest_writer_map_insert(&map, (const gchar *) value, value);
+}
+
+static gpointer
+_lookup(const gchar *key)
+{
+  gint copy = affile_dest_writer_map_read_begin(&map);
+  gpointer value = affile_dest_writer_map_lookup(&map, copy, key);
+
+  affile_dest_writer_map_read_end(&map, copy);
+  return value;
+}
+
+static void
+setup(void)
+{
+  affile_dest_writer_map_init(&map, _retire, NULL);
+  retired = NULL;
+  insert_on_retire = FALSE;
+}
+
+static void
+teardown(void)
+{
+  affile_dest_writer_map_deinit(&map);
+  g_list_free(retired);
+}
+
+TestSuite(writer_map, .init = setup, .fini = teardown);
+
+Test(writer_map, test_changes_are_visible_after_sync)
+{
+  static gchar foo[] = "foo";
+  static gchar bar[] = "bar";
+
+  affile_dest_writer_map_insert(&map, foo, foo);
+  cr_assert_null(_lookup("foo"));
+
+  cr_assert(affile_dest_writer_map_sync(&map));
+  cr_assert_eq(_lookup("foo"), foo);
+
+  affile_dest_writer_map_insert(&map, bar, bar);
+  affile_dest_writer_map_remove(&map, foo, foo);
+  cr_assert(affile_dest_writer_map_sync(&map));
+  cr_assert_null(_lookup("foo"));
+  cr_assert_eq(_lookup("bar"), bar);
+
+  /* both copies are up-to-date */
+  cr_assert(affile_dest_writer_map_sync(&map));
+  cr_assert_null(affile_dest_writer_map_lookup(&map, 0, "foo"));
+  cr_assert_null(affile_dest_writer_map_lookup(&map, 1, "foo"));
+  cr_assert_eq(affile_dest_writer_map_lookup(&map, 0, "bar"), bar);
+  cr_assert_eq(affile_dest_writer_map_lookup(&map, 1, "bar"), bar);
+}
+
+Test(writer_map, test_removed_value_is_retired_once_readers_are_gone)
+{
+  static gchar foo[] = "foo";
+  gint copy;
+
+  affile_dest_writer_map_insert(&map, foo, foo);
+  cr_assert(affile_dest_writer_map_sync(&map));
+
+  copy = affile_dest_writer_map_read_begin(&map);
+  cr_assert_eq(affile_dest_writer_map_lookup(&map, copy, "foo"), foo);
+
+  affile_dest_writer_map_remove(&map, foo, foo);
+  cr_assert_not(affile_dest_writer_map_sync(&map));
+  cr_assert_null(retired);
+
+  /* new readers don't find it, the one in progress still does */
+  cr_assert_null(_lookup("foo"));
+  cr_assert_eq(affile_dest_writer_map_lookup(&map, copy, "foo"), foo);
+
+  affile_dest_writer_map_read_end(&map, copy);
+  cr_assert(affile_dest_writer_map_sync(&map));
+  cr_assert_eq(g_list_length(retired), 1);
+  cr_assert_eq(retired->data, foo);
+}
+
+Test(writer_map, test_changes_wait_for_readers_of_the_standby_copy)
+{
+  static gchar foo[] = "foo";
+  static gchar bar[] = "bar";
+  gint copy;
+
+  copy = affile_dest_writer_map_read_begin(&map);
+
+  affile_dest_writer_map_insert(&map, foo, foo);
+  cr_assert_not(affile_dest_writer_map_sync(&map));
+  cr_assert_eq(_lookup("foo"), foo);
+
+  /* the reader is still on the copy that needs to catch up */
+  affile_dest_writer_map_insert(&map, bar, bar);
+  cr_assert_not(affile_dest_writer_map_sync(&map));
+  cr_assert_null(_lookup("bar"));
+
+  affile_dest_writer_map_read_end(&map, copy);
+  cr_assert(affile_dest_writer_map_sync(&map));
+  cr_assert_eq(_lookup("foo"), foo);
+  cr_assert_eq(_lookup("bar"), bar);
+}
+
+Test(writer_map, test_remove_only_removes_the_given_value)
+{
+  static gchar old_foo[] = "foo";
+  static gchar new_foo[] = "foo";
+
+  affile_dest_writer_map_insert(&map, old_foo, old_foo);
+  affile_dest_writer_map_insert(&map, new_foo, new_foo);
+  affile_dest_writer_map_remove(&map, old_foo, old_foo);
+  cr_assert(affile_dest_writer_map_sync(&map));
+
+  cr_assert_eq(_lookup("foo"), new_foo);
+}
+
+Test(writer_map, test_retired_value_can_be_inserted_again)
+{
+  static gchar foo[] = "foo";
+
+  affile_dest_writer_map_insert(&map, foo, foo);
+  cr_assert(affile_dest_writer_map_sync(&map));
+
+  insert_on_retire = TRUE;
+  affile_dest_writer_map_remove(&map, foo, foo);
+  cr_assert(affile_dest_writer_map_sync(&map));
+
+  cr_assert_eq(g_list_length(retired), 1);
+  cr_assert_eq(_lookup("foo"), foo);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "transport-regular-file.h"
+#include "transport/transport-file.h"
+#include "messages.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define LOG_TRANSPORT_REGULAR_FILE_NAME "regular-file"
+
+/*
+ * Transport for regular files being followed.  If read_ahead is set and
+ * the file has at least that many unread bytes when we start reading it
+ * (e.g. we are catching up on a backlog), the kernel is told that the
+ * file is read sequentially and the next read_ahead bytes are requested
+ * in advance, so the disk is kept busy while we are parsing.  Once EOF is
+ * reached we switch back to normal tailing.
+ *
+ * NOTE: the read position of the fd is left alone (no private buffering)
+ * as poll-file-changes and the persisted file position rely on it.
+ */
+typedef struct _LogTransportRegularFile
+{
+  LogTransportFile super;
+  gsize read_ahead;
+  gboolean catch_up_checked;
+  gboolean catching_up;
+  off_t read_pos;
+  off_t advised_until;
+} LogTransportRegularFile;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+
+static void
+log_transport_regular_file_start_catch_up(LogTransportRegularFile *self)
+{
+  struct stat st;
+  off_t pos;
+
+  self->catch_up_checked = TRUE;
+
+  pos = lseek(self->super.super.fd, 0, SEEK_CUR);
+  if (pos == (off_t) -1 || fstat(self->super.super.fd, &st) < 0 || !S_ISREG(st.st_mode))
+    return;
+
+  if (st.st_size - pos < (off_t) self->read_ahead)
+    return;
+
+  msg_debug("Catching up with the backlog of a followed file, enabling read-ahead",
+            evt_tag_int("fd", self->super.super.fd),
+            evt_tag_long("backlog", st.st_size - pos));
+
+  posix_fadvise(self->super.super.fd, pos, 0, POSIX_FADV_SEQUENTIAL);
+  self->read_pos = self->advised_until = pos;
+  self->catching_up = TRUE;
+}
+
+static void
+log_transport_regular_file_stop_catch_up(LogTransportRegularFile *self)
+{
+  msg_debug("Reached the end of a followed file, disabling read-ahead",
+            evt_tag_int("fd", self->super.super.fd));
+
+  posix_fadvise(self->super.super.fd, 0, 0, POSIX_FADV_NORMAL);
+  self->catching_up = FALSE;
+}
+
+/* keep between half and one and a half read_ahead windows requested ahead of us */
+static void
+log_transport_regular_file_advise_read_ahead(LogTransportRegularFile *self, gsize bytes_read)
+{
+  self->read_pos += bytes_read;
+  if (self->advised_until - self->read_pos >= (off_t) self->read_ahead / 2)
+    return;
+
+  if (self->advised_until < self->read_pos)
+    self->advised_until = self->read_pos;
+  posix_fadvise(self->super.super.fd, self->advised_until, self->read_ahead, POSIX_FADV_WILLNEED);
+  self->advised_until += self->read_ahead;
+}
+
+static gssize
+log_transport_regular_file_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  LogTransportRegularFile *self = (LogTransportRegularFile *) s;
+  gssize rc;
+
+  if (self->read_ahead && !self->catch_up_checked)
+    log_transport_regular_file_start_catch_up(self);
+
+  rc = log_transport_file_read_method(s, buf, buflen, aux);
+
+  if (self->catching_up)
+    {
+      if (rc > 0)
+        log_transport_regular_file_advise_read_ahead(self, rc);
+      else if (rc == 0)
+        log_transport_regular_file_stop_catch_up(self);
+    }
+
+  if (rc == 0)
+    {
+      /* EOF is not an error for followed files, we wait for more data */
+      rc = -1;
+      errno = EAGAIN;
+    }
+  return rc;
+}
+
+#endif
+
+gboolean
+log_transport_is_regular_file(LogTransport *s)
+{
+  return g_strcmp0(s->name, LOG_TRANSPORT_REGULAR_FILE_NAME) == 0;
+}
+
+void
+log_transport_regular_file_set_read_ahead(LogTransport *s, gsize read_ahead)
+{
+  LogTransportRegularFile *self = (LogTransportRegularFile *) s;
+
+  g_assert(log_transport_is_regular_file(s));
+  self->read_ahead = read_ahead;
+}
+
+LogTransport *
+log_transport_regular_file_new(gint fd)
+{
+  LogTransportRegularFile *self = g_new0(LogTransportRegularFile, 1);
+
+  log_transport_file_init_instance(&self->super, fd);
+  self->super.super.name = LOG_TRANSPORT_REGULAR_FILE_NAME;
+#ifdef POSIX_FADV_SEQUENTIAL
+  self->super.super.read = log_transport_regular_file_read_method;
+#else
+  self->super.super.read = log_transport_file_read_and_ignore_eof_method;
+#endif
+  return &self->super.super;
+}
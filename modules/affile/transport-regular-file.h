@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef AFFILE_TRANSPORT_REGULAR_FILE_H_INCLUDED
+#define AFFILE_TRANSPORT_REGULAR_FILE_H_INCLUDED 1
+
+#include "transport/logtransport.h"
+
+LogTransport *log_transport_regular_file_new(gint fd);
+gboolean log_transport_is_regular_file(LogTransport *s);
+void log_transport_regular_file_set_read_ahead(LogTransport *s, gsize read_ahead);
+
+#endif
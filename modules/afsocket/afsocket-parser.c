@@ -56,6 +56,10 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "cipher_suite",       KW_CIPHER_SUITE },
   { "ecdh_curve_list",    KW_ECDH_CURVE_LIST },
   { "curve_list",         KW_ECDH_CURVE_LIST, KWS_OBSOLETE, "ecdh_curve_list"},
+  { "session_cache_size", KW_SESSION_CACHE_SIZE },
+  { "session_timeout",    KW_SESSION_TIMEOUT },
+  { "session_tickets",    KW_SESSION_TICKETS },
+  { "ktls",               KW_KTLS },
   { "ssl_options",        KW_SSL_OPTIONS },
   { "allow_compress",     KW_ALLOW_COMPRESS },
 
@@ -83,6 +87,8 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "ip_protocol",        KW_IP_PROTOCOL },
   { "max_connections",    KW_MAX_CONNECTIONS },
   { "listen_backlog",     KW_LISTEN_BACKLOG },
+  { "listeners",          KW_LISTENERS },
+  { "accept_threads",     KW_ACCEPT_THREADS },
   { "keep_alive",         KW_KEEP_ALIVE },
   { "close_on_input",     KW_CLOSE_ON_INPUT },
   { "systemd_syslog",     KW_SYSTEMD_SYSLOG  },
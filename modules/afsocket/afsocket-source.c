@@ -26,12 +26,18 @@
 #include "fdhelpers.h"
 #include "gsocket.h"
 #include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
 #include "mainloop.h"
+#include "mainloop-worker.h"
 #include "poll-fd-events.h"
+#include "apphook.h"
+#include "timeutils/timeutils.h"
 
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
 
 #if SYSLOG_NG_ENABLE_TCP_WRAPPER
 #include <tcpd.h>
@@ -46,6 +52,8 @@ typedef struct _AFSocketSourceConnection
   LogReader *reader;
   int sock;
   GSockAddr *peer_addr;
+  /* set up in an accept worker, owns sock until the reader is constructed */
+  LogTransport *transport;
 } AFSocketSourceConnection;
 
 static void afsocket_sd_close_connection(AFSocketSourceDriver *self, AFSocketSourceConnection *sc);
@@ -88,7 +96,8 @@ afsocket_sc_init(LogPipe *s)
 
   if (!self->reader)
     {
-      transport = afsocket_sc_construct_transport(self, self->sock);
+      transport = self->transport ? : afsocket_sc_construct_transport(self, self->sock);
+      self->transport = NULL;
       /* transport_mapper_inet_construct_log_transport() can return NULL on TLS errors */
       if (!transport)
         return FALSE;
@@ -182,6 +191,8 @@ static void
 afsocket_sc_free(LogPipe *s)
 {
   AFSocketSourceConnection *self = (AFSocketSourceConnection *) s;
+  if (self->transport)
+    log_transport_free(self->transport);
   g_sockaddr_unref(self->peer_addr);
   log_pipe_free_method(s);
 }
@@ -260,6 +271,22 @@ afsocket_sd_set_max_connections(LogDriver *s, gint max_connections)
   self->max_connections = max_connections;
 }
 
+void
+afsocket_sd_set_accept_threads(LogDriver *s, gint accept_threads)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+
+  self->accept_threads = accept_threads;
+}
+
+void
+afsocket_sd_set_listeners(LogDriver *s, gint listeners)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+
+  self->listeners = listeners;
+}
+
 void
 afsocket_sd_set_listen_backlog(LogDriver *s, gint listen_backlog)
 {
@@ -313,11 +340,17 @@ afsocket_sd_format_connections_name(const AFSocketSourceDriver *self)
   return persist_name;
 }
 
+#if SYSLOG_NG_ENABLE_TCP_WRAPPER
+/* libwrap is not reentrant, while accept workers may run in parallel */
+static GStaticMutex tcp_wrapper_lock = G_STATIC_MUTEX_INIT;
+#endif
+
 static gboolean
-afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr, gint fd)
+afsocket_sd_check_tcp_wrapper(GSockAddr *client_addr, GSockAddr *local_addr, gint fd)
 {
-  gchar buf[MAX_SOCKADDR_STRING], buf2[MAX_SOCKADDR_STRING];
 #if SYSLOG_NG_ENABLE_TCP_WRAPPER
+  gchar buf[MAX_SOCKADDR_STRING], buf2[MAX_SOCKADDR_STRING];
+
   if (client_addr && (client_addr->sa.sa_family == AF_INET
 #if SYSLOG_NG_ENABLE_IPV6
                       || client_addr->sa.sa_family == AF_INET6
@@ -325,10 +358,15 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
                      ))
     {
       struct request_info req;
+      gboolean allowed;
 
+      g_static_mutex_lock(&tcp_wrapper_lock);
       request_init(&req, RQ_DAEMON, "syslog-ng", RQ_FILE, fd, 0);
       fromhost(&req);
-      if (hosts_access(&req) == 0)
+      allowed = (hosts_access(&req) != 0);
+      g_static_mutex_unlock(&tcp_wrapper_lock);
+
+      if (!allowed)
         {
 
           msg_error("Syslog connection rejected by tcpd",
@@ -339,13 +377,40 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
     }
 
 #endif
+  return TRUE;
+}
+
+/*
+ * max-connections() limits accepted stream connections, including the ones
+ * still being set up by the accept workers, dgram listeners are bounded by
+ * listeners()
+ */
+static gboolean
+afsocket_sd_connection_limit_reached(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr)
+{
+  gchar buf[MAX_SOCKADDR_STRING], buf2[MAX_SOCKADDR_STRING];
 
-  if (self->num_connections >= self->max_connections)
+  if (self->transport_mapper->sock_type == SOCK_STREAM &&
+      self->num_connections + self->num_accept_jobs >= self->max_connections)
     {
       msg_error("Number of allowed concurrent connections reached, rejecting connection",
                 evt_tag_str("client", g_sockaddr_format(client_addr, buf, sizeof(buf), GSA_FULL)),
                 evt_tag_str("local", g_sockaddr_format(local_addr, buf2, sizeof(buf2), GSA_FULL)),
                 evt_tag_int("max", self->max_connections));
+      return TRUE;
+    }
+  return FALSE;
+}
+
+/* consumes @transport if specified, which also takes care of closing @fd */
+static gboolean
+afsocket_sd_setup_connection(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr, gint fd,
+                             LogTransport *transport)
+{
+  if (afsocket_sd_connection_limit_reached(self, client_addr, local_addr))
+    {
+      if (transport)
+        log_transport_free(transport);
       return FALSE;
     }
   else
@@ -353,6 +418,7 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
       AFSocketSourceConnection *conn;
 
       conn = afsocket_sc_new(client_addr, fd, self->super.super.super.cfg);
+      conn->transport = transport;
       afsocket_sc_set_owner(conn, self);
       if (log_pipe_init(&conn->super))
         {
@@ -369,6 +435,323 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
   return TRUE;
 }
 
+static gboolean
+afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr, gint fd)
+{
+  return afsocket_sd_check_tcp_wrapper(client_addr, local_addr, fd) &&
+         afsocket_sd_setup_connection(self, client_addr, local_addr, fd, NULL);
+}
+
+static void
+afsocket_sd_log_accepted_connection(AFSocketSourceDriver *self, GSockAddr *peer_addr, gint fd)
+{
+  gchar buf1[256], buf2[256];
+
+  if (peer_addr->sa.sa_family != AF_UNIX)
+    msg_notice("Syslog connection accepted",
+               evt_tag_int("fd", fd),
+               evt_tag_str("client", g_sockaddr_format(peer_addr, buf1, sizeof(buf1), GSA_FULL)),
+               evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
+  else
+    msg_verbose("Syslog connection accepted",
+                evt_tag_int("fd", fd),
+                evt_tag_str("client", g_sockaddr_format(peer_addr, buf1, sizeof(buf1), GSA_FULL)),
+                evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
+}
+
+/*
+ * Accept workers
+ *
+ * With accept-threads() set, accepted connections are set up in a
+ * dedicated thread pool: the tcp-wrapper check, the construction of the
+ * transport and its handshake (e.g. TLS) are performed there, so that
+ * connection storms don't stall the main loop.  Workers never wait for
+ * the peer: if the handshake needs more I/O, the fd is watched by the main
+ * loop and the job is submitted again once the fd becomes ready.  The
+ * connection itself is registered in the main thread, once the handshake
+ * has completed.  Jobs are owned by the main thread, except while they
+ * are in the pool.
+ */
+
+#define AFSOCKET_HANDSHAKE_TIMEOUT 10000
+
+typedef enum
+{
+  AFSOCKET_ACCEPT_JOB_FAILED,
+  AFSOCKET_ACCEPT_JOB_WANTS_IO,
+  AFSOCKET_ACCEPT_JOB_ACCEPTED,
+} AFSocketAcceptJobState;
+
+typedef struct _AFSocketAcceptJob
+{
+  struct iv_work_item work_item;
+  struct iv_fd handshake_fd;
+  struct iv_timer handshake_timer;
+  AFSocketSourceDriver *owner;
+  GSockAddr *peer_addr;
+  gint fd;
+  LogTransport *transport;
+  AFSocketAcceptJobState state;
+  gboolean timed_out;
+  struct timespec submitted;
+} AFSocketAcceptJob;
+
+/* NOTE: runs in an accept worker thread */
+static void
+afsocket_sd_accept_job_work(gpointer s)
+{
+  AFSocketAcceptJob *job = (AFSocketAcceptJob *) s;
+  AFSocketSourceDriver *self = job->owner;
+
+  job->state = AFSOCKET_ACCEPT_JOB_FAILED;
+  if (!job->transport)
+    {
+      if (!afsocket_sd_check_tcp_wrapper(job->peer_addr, self->bind_addr, job->fd))
+        return;
+
+      job->transport = transport_mapper_construct_log_transport(self->transport_mapper, job->fd);
+      if (!job->transport)
+        return;
+    }
+
+  if (log_transport_handshake(job->transport))
+    job->state = AFSOCKET_ACCEPT_JOB_ACCEPTED;
+  else if (errno == EAGAIN)
+    job->state = AFSOCKET_ACCEPT_JOB_WANTS_IO;
+}
+
+static void afsocket_sd_accept_job_complete(gpointer s);
+
+static void
+afsocket_sd_submit_accept_job_work(AFSocketAcceptJob *job)
+{
+  IV_WORK_ITEM_INIT(&job->work_item);
+  job->work_item.cookie = job;
+  job->work_item.work = afsocket_sd_accept_job_work;
+  job->work_item.completion = afsocket_sd_accept_job_complete;
+
+  /* reloads wait for the jobs in the pool, so the driver stays initialized until completion */
+  main_loop_worker_job_start();
+  iv_work_pool_submit_work(&job->owner->accept_workers, &job->work_item);
+}
+
+/* NOTE: runs in the main thread, frees @job */
+static void
+afsocket_sd_finish_accept_job(AFSocketAcceptJob *job)
+{
+  AFSocketSourceDriver *self = job->owner;
+
+  if (iv_timer_registered(&job->handshake_timer))
+    iv_timer_unregister(&job->handshake_timer);
+  if (iv_fd_registered(&job->handshake_fd))
+    iv_fd_unregister(&job->handshake_fd);
+
+  self->accept_jobs = g_list_remove(self->accept_jobs, job);
+  self->num_accept_jobs--;
+  stats_counter_dec(self->accept_queue);
+
+  if (job->state == AFSOCKET_ACCEPT_JOB_ACCEPTED)
+    {
+      iv_validate_now();
+      stats_counter_inc(self->handshakes);
+      stats_counter_add(self->handshake_time, timespec_diff_msec(&iv_now, &job->submitted));
+
+      if (afsocket_sd_setup_connection(self, job->peer_addr, self->bind_addr, job->fd, job->transport))
+        afsocket_sd_log_accepted_connection(self, job->peer_addr, job->fd);
+    }
+  else
+    {
+      if (job->timed_out)
+        msg_verbose("Handshake did not complete in time, dropping connection",
+                    evt_tag_int("fd", job->fd),
+                    evt_tag_int("timeout", AFSOCKET_HANDSHAKE_TIMEOUT));
+
+      if (job->transport)
+        log_transport_free(job->transport);
+      else
+        close(job->fd);
+    }
+
+  g_sockaddr_unref(job->peer_addr);
+  log_pipe_unref(&self->super.super.super);
+  g_free(job);
+}
+
+/* NOTE: runs in the main thread */
+static void
+afsocket_sd_accept_job_io_ready(gpointer s)
+{
+  AFSocketAcceptJob *job = (AFSocketAcceptJob *) s;
+
+  iv_fd_unregister(&job->handshake_fd);
+  if (main_loop_worker_job_quit())
+    {
+      afsocket_sd_finish_accept_job(job);
+      return;
+    }
+  afsocket_sd_submit_accept_job_work(job);
+}
+
+static void
+afsocket_sd_accept_job_wait_for_io(AFSocketAcceptJob *job)
+{
+  job->handshake_fd.fd = job->fd;
+  if (job->transport->cond & G_IO_OUT)
+    {
+      job->handshake_fd.handler_in = NULL;
+      job->handshake_fd.handler_out = afsocket_sd_accept_job_io_ready;
+    }
+  else
+    {
+      job->handshake_fd.handler_in = afsocket_sd_accept_job_io_ready;
+      job->handshake_fd.handler_out = NULL;
+    }
+  iv_fd_register(&job->handshake_fd);
+}
+
+/* NOTE: runs in the main thread */
+static void
+afsocket_sd_accept_job_timed_out(gpointer s)
+{
+  AFSocketAcceptJob *job = (AFSocketAcceptJob *) s;
+
+  job->timed_out = TRUE;
+
+  /* jobs in the pool are finished by their completion callback */
+  if (iv_fd_registered(&job->handshake_fd))
+    afsocket_sd_finish_accept_job(job);
+}
+
+/* NOTE: runs in the main thread */
+static void
+afsocket_sd_accept_job_complete(gpointer s)
+{
+  AFSocketAcceptJob *job = (AFSocketAcceptJob *) s;
+
+  /* don't hold up reloads and shutdown */
+  if (job->state == AFSOCKET_ACCEPT_JOB_WANTS_IO && !job->timed_out && !main_loop_worker_job_quit())
+    afsocket_sd_accept_job_wait_for_io(job);
+  else
+    afsocket_sd_finish_accept_job(job);
+  main_loop_worker_job_complete();
+}
+
+static gboolean
+afsocket_sd_submit_accept_job(AFSocketSourceDriver *self, GSockAddr *peer_addr, gint fd)
+{
+  AFSocketAcceptJob *job;
+
+  if (main_loop_worker_job_quit())
+    return FALSE;
+
+  job = g_new0(AFSocketAcceptJob, 1);
+  job->owner = (AFSocketSourceDriver *) log_pipe_ref(&self->super.super.super);
+  job->peer_addr = g_sockaddr_ref(peer_addr);
+  job->fd = fd;
+
+  IV_FD_INIT(&job->handshake_fd);
+  job->handshake_fd.cookie = job;
+
+  iv_validate_now();
+  job->submitted = iv_now;
+  IV_TIMER_INIT(&job->handshake_timer);
+  job->handshake_timer.cookie = job;
+  job->handshake_timer.handler = afsocket_sd_accept_job_timed_out;
+  job->handshake_timer.expires = iv_now;
+  timespec_add_msec(&job->handshake_timer.expires, AFSOCKET_HANDSHAKE_TIMEOUT);
+  iv_timer_register(&job->handshake_timer);
+
+  self->accept_jobs = g_list_prepend(self->accept_jobs, job);
+  self->num_accept_jobs++;
+  stats_counter_inc(self->accept_queue);
+  afsocket_sd_submit_accept_job_work(job);
+  return TRUE;
+}
+
+/* drops the connections waiting for their handshake, jobs can't be in the pool at this point */
+static void
+afsocket_sd_abort_accept_jobs(AFSocketSourceDriver *self)
+{
+  while (self->accept_jobs)
+    {
+      AFSocketAcceptJob *job = (AFSocketAcceptJob *) self->accept_jobs->data;
+
+      job->state = AFSOCKET_ACCEPT_JOB_FAILED;
+      afsocket_sd_finish_accept_job(job);
+    }
+}
+
+static void
+afsocket_sd_register_accept_counters(AFSocketSourceDriver *self)
+{
+  gchar instance[MAX_SOCKADDR_STRING];
+  StatsClusterKey sc_key;
+  guint16 component = SCS_SOURCE | self->transport_mapper->stats_source;
+
+  g_sockaddr_format(self->bind_addr, instance, sizeof(instance), GSA_FULL);
+
+  stats_lock();
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "accept_queue");
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->accept_queue);
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "handshakes");
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->handshakes);
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "handshake_time_msec");
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->handshake_time);
+  stats_unlock();
+}
+
+static void
+afsocket_sd_unregister_accept_counters(AFSocketSourceDriver *self)
+{
+  gchar instance[MAX_SOCKADDR_STRING];
+  StatsClusterKey sc_key;
+  guint16 component = SCS_SOURCE | self->transport_mapper->stats_source;
+
+  g_sockaddr_format(self->bind_addr, instance, sizeof(instance), GSA_FULL);
+
+  stats_lock();
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "accept_queue");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->accept_queue);
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "handshakes");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->handshakes);
+  stats_cluster_single_key_set_with_name(&sc_key, component, self->super.super.id, instance, "handshake_time_msec");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->handshake_time);
+  stats_unlock();
+}
+
+static gboolean
+afsocket_sd_start_accept_workers(AFSocketSourceDriver *self)
+{
+  if (self->accept_threads <= 0 || self->transport_mapper->sock_type != SOCK_STREAM)
+    return TRUE;
+
+  memset(&self->accept_workers, 0, sizeof(self->accept_workers));
+  self->accept_workers.max_threads = self->accept_threads;
+  self->accept_workers.thread_start = (void (*)(void *)) app_thread_start;
+  self->accept_workers.thread_stop = (void (*)(void *)) app_thread_stop;
+  if (iv_work_pool_create(&self->accept_workers) < 0)
+    {
+      msg_error("Error creating accept worker threads",
+                evt_tag_int("accept_threads", self->accept_threads));
+      return FALSE;
+    }
+  self->accept_workers_running = TRUE;
+  afsocket_sd_register_accept_counters(self);
+  return TRUE;
+}
+
+static void
+afsocket_sd_stop_accept_workers(AFSocketSourceDriver *self)
+{
+  if (!self->accept_workers_running)
+    return;
+
+  afsocket_sd_abort_accept_jobs(self);
+  afsocket_sd_unregister_accept_counters(self);
+  iv_work_pool_put(&self->accept_workers);
+  self->accept_workers_running = FALSE;
+}
+
 #define MAX_ACCEPTS_AT_A_TIME 30
 
 static void
@@ -376,7 +759,6 @@ afsocket_sd_accept(gpointer s)
 {
   AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
   GSockAddr *peer_addr;
-  gchar buf1[256], buf2[256];
   gint new_fd;
   gboolean res;
   int accepts = 0;
@@ -401,26 +783,26 @@ afsocket_sd_accept(gpointer s)
       g_fd_set_nonblock(new_fd, TRUE);
       g_fd_set_cloexec(new_fd, TRUE);
 
-      res = afsocket_sd_process_connection(self, peer_addr, self->bind_addr, new_fd);
-
-      if (res)
+      if (self->accept_workers_running && afsocket_sd_connection_limit_reached(self, peer_addr, self->bind_addr))
         {
-          if (peer_addr->sa.sa_family != AF_UNIX)
-            msg_notice("Syslog connection accepted",
-                       evt_tag_int("fd", new_fd),
-                       evt_tag_str("client", g_sockaddr_format(peer_addr, buf1, sizeof(buf1), GSA_FULL)),
-                       evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
-          else
-            msg_verbose("Syslog connection accepted",
-                        evt_tag_int("fd", new_fd),
-                        evt_tag_str("client", g_sockaddr_format(peer_addr, buf1, sizeof(buf1), GSA_FULL)),
-                        evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
+          res = FALSE;
+        }
+      else if (self->accept_workers_running && afsocket_sd_submit_accept_job(self, peer_addr, new_fd))
+        {
+          g_sockaddr_unref(peer_addr);
+          accepts++;
+          continue;
         }
       else
         {
-          close(new_fd);
+          res = afsocket_sd_process_connection(self, peer_addr, self->bind_addr, new_fd);
         }
 
+      if (res)
+        afsocket_sd_log_accepted_connection(self, peer_addr, new_fd);
+      else
+        close(new_fd);
+
       g_sockaddr_unref(peer_addr);
       accepts++;
     }
@@ -514,6 +896,14 @@ afsocket_sd_setup_transport(AFSocketSourceDriver *self)
       return FALSE;
     }
 
+  if (self->listeners != 1 && self->transport_mapper->sock_type != SOCK_DGRAM)
+    {
+      msg_error("The listeners() option is only supported for datagram transports",
+                evt_tag_str("transport", self->transport_mapper->transport),
+                evt_tag_int("listeners", self->listeners));
+      return FALSE;
+    }
+
   self->transport_mapper->create_multitransport = self->proto_factory->use_multitransport;
 
   afsocket_sd_setup_reader_options(self);
@@ -599,25 +989,78 @@ _sd_open_stream(AFSocketSourceDriver *self)
   return transport_mapper_async_init(self->transport_mapper, _finalize_init, self);
 }
 
+static gint
+afsocket_sd_get_num_listeners(AFSocketSourceDriver *self)
+{
+  glong num_cpus;
+
+  if (self->listeners > 0)
+    return self->listeners;
+
+  /* listeners(0): one socket per online CPU */
+  num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return num_cpus > 0 ? (gint) num_cpus : 1;
+}
+
+static gboolean
+_sd_open_dgram_socket(AFSocketSourceDriver *self, gint num_listeners, gint *sock)
+{
+  /* sockets of the same driver are bound to the same address, the kernel
+   * distributes incoming datagrams between them */
+  if (num_listeners > 1)
+    return transport_mapper_open_reuseport_socket(self->transport_mapper, self->socket_options, self->bind_addr,
+                                                  AFSOCKET_DIR_RECV, sock);
+
+  return transport_mapper_open_socket(self->transport_mapper, self->socket_options, self->bind_addr, AFSOCKET_DIR_RECV,
+                                      sock);
+}
+
 static gboolean
 _sd_open_dgram(AFSocketSourceDriver *self)
 {
+  gint num_listeners = afsocket_sd_get_num_listeners(self);
   gint sock = -1;
+
+  if (self->connections && self->num_connections != num_listeners)
+    {
+      /* the number of listeners changed, sockets kept alive across the
+       * reload may not have SO_REUSEPORT set, start over */
+      msg_verbose("Number of dgram listeners changed, reopening sockets",
+                  evt_tag_int("old_listeners", self->num_connections),
+                  evt_tag_int("new_listeners", num_listeners));
+      afsocket_sd_kill_connection_list(self->connections);
+      self->connections = NULL;
+      self->num_connections = 0;
+    }
+
   if (!self->connections)
     {
       if (!afsocket_sd_acquire_socket(self, &sock))
         return self->super.super.optional;
-      if (sock == -1
-          && !transport_mapper_open_socket(self->transport_mapper, self->socket_options, self->bind_addr, AFSOCKET_DIR_RECV,
-                                           &sock))
-        return self->super.super.optional;
+      if (sock != -1)
+        {
+          /* a socket passed in by the runtime environment cannot be fanned out */
+          num_listeners = 1;
+        }
+      else if (!_sd_open_dgram_socket(self, num_listeners, &sock))
+        {
+          return self->super.super.optional;
+        }
+
+      if (!afsocket_sd_process_connection(self, NULL, self->bind_addr, sock))
+        return FALSE;
+
+      while (self->num_connections < num_listeners)
+        {
+          if (!_sd_open_dgram_socket(self, num_listeners, &sock))
+            return self->super.super.optional;
+          if (!afsocket_sd_process_connection(self, NULL, self->bind_addr, sock))
+            return FALSE;
+        }
     }
   self->fd = -1;
 
-  /* we either have self->connections != NULL, or sock contains a new fd */
-  if (self->connections || afsocket_sd_process_connection(self, NULL, self->bind_addr, sock))
-    return transport_mapper_init(self->transport_mapper);
-  return FALSE;
+  return transport_mapper_init(self->transport_mapper);
 }
 
 static gboolean
@@ -707,6 +1150,7 @@ afsocket_sd_init_method(LogPipe *s)
          afsocket_sd_setup_transport(self) &&
          afsocket_sd_setup_addresses(self) &&
          afsocket_sd_restore_kept_alive_connections(self) &&
+         afsocket_sd_start_accept_workers(self) &&
          afsocket_sd_open_listener(self);
 }
 
@@ -717,6 +1161,7 @@ afsocket_sd_deinit_method(LogPipe *s)
 
   afsocket_sd_save_connections(self);
   afsocket_sd_save_listener(self);
+  afsocket_sd_stop_accept_workers(self);
 
   return log_src_driver_deinit_method(s);
 }
@@ -768,6 +1213,7 @@ afsocket_sd_init_instance(AFSocketSourceDriver *self,
   self->transport_mapper = transport_mapper;
   self->max_connections = 10;
   self->listen_backlog = 255;
+  self->listeners = 1;
   self->connections_kept_alive_across_reloads = TRUE;
   log_reader_options_defaults(&self->reader_options);
   self->reader_options.super.stats_level = STATS_LEVEL1;
@@ -31,6 +31,7 @@
 #include "logreader.h"
 
 #include <iv.h>
+#include <iv_work.h>
 
 typedef struct _AFSocketSourceDriver AFSocketSourceDriver;
 
@@ -47,6 +48,15 @@ struct _AFSocketSourceDriver
   gint max_connections;
   gint num_connections;
   gint listen_backlog;
+  gint listeners;
+  gint accept_threads;
+  gboolean accept_workers_running;
+  struct iv_work_pool accept_workers;
+  GList *accept_jobs;
+  gint num_accept_jobs;
+  StatsCounterItem *accept_queue;
+  StatsCounterItem *handshakes;
+  StatsCounterItem *handshake_time;
   GList *connections;
   SocketOptions *socket_options;
   TransportMapper *transport_mapper;
@@ -70,6 +80,8 @@ struct _AFSocketSourceDriver
 void afsocket_sd_set_keep_alive(LogDriver *self, gint enable);
 void afsocket_sd_set_max_connections(LogDriver *self, gint max_connections);
 void afsocket_sd_set_listen_backlog(LogDriver *self, gint listen_backlog);
+void afsocket_sd_set_listeners(LogDriver *self, gint listeners);
+void afsocket_sd_set_accept_threads(LogDriver *self, gint accept_threads);
 
 static inline gboolean
 afsocket_sd_acquire_socket(AFSocketSourceDriver *s, gint *fd)
@@ -83,8 +83,8 @@ _setup_keepalive(gint fd)
   return TRUE;
 }
 
-static gboolean
-_setup_reuseport(gint fd)
+gboolean
+socket_options_setup_reuseport(gint fd)
 {
 #ifdef SO_REUSEPORT
   gint on = 1;
@@ -109,7 +109,7 @@ socket_options_setup_socket_method(SocketOptions *self, gint fd, GSockAddr *bind
     {
       if (self->so_rcvbuf && !_setup_receive_buffer(fd, self->so_rcvbuf))
         return FALSE;
-      if (self->so_reuseport && !_setup_reuseport(fd))
+      if (self->so_reuseport && !socket_options_setup_reuseport(fd))
         return FALSE;
     }
   if (dir & AFSOCKET_DIR_SEND)
@@ -45,6 +45,7 @@ struct _SocketOptions
   void (*free)(gpointer s);
 };
 
+gboolean socket_options_setup_reuseport(gint fd);
 gboolean socket_options_setup_socket_method(SocketOptions *self, gint fd, GSockAddr *bind_addr, AFSocketDirection dir);
 void socket_options_init_instance(SocketOptions *self);
 SocketOptions *socket_options_new(void);
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "afunix-source.h"
+#include "afinet-source.h"
+#include "afsocket-source.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "stats/stats-counter.h"
+#include "timeutils/timeutils.h"
+
+#include <iv.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#define WAIT_CHECK_INTERVAL 10
+#define WAIT_TIMEOUT 5000
+
+static gchar socket_path[64];
+
+typedef struct _ConnectionsWait
+{
+  struct iv_timer timer;
+  AFSocketSourceDriver *driver;
+  gint expected_connections;
+  gint waited;
+} ConnectionsWait;
+
+static void
+_arm_connections_wait(ConnectionsWait *wait)
+{
+  iv_validate_now();
+  wait->timer.expires = iv_now;
+  timespec_add_msec(&wait->timer.expires, WAIT_CHECK_INTERVAL);
+  iv_timer_register(&wait->timer);
+}
+
+static void
+_check_connections(gpointer s)
+{
+  ConnectionsWait *wait = (ConnectionsWait *) s;
+
+  wait->waited += WAIT_CHECK_INTERVAL;
+  if ((wait->driver->num_connections == wait->expected_connections && wait->driver->num_accept_jobs == 0) ||
+      wait->waited >= WAIT_TIMEOUT)
+    {
+      iv_quit();
+      return;
+    }
+  _arm_connections_wait(wait);
+}
+
+/* runs the main loop until the accepted connections are all set up */
+static void
+_wait_for_connections(AFSocketSourceDriver *driver, gint expected_connections)
+{
+  ConnectionsWait wait = { .driver = driver, .expected_connections = expected_connections };
+
+  IV_TIMER_INIT(&wait.timer);
+  wait.timer.cookie = &wait;
+  wait.timer.handler = _check_connections;
+  _arm_connections_wait(&wait);
+  iv_main();
+}
+
+static AFSocketSourceDriver *
+_create_unix_stream_source(gint max_connections, gint accept_threads)
+{
+  AFUnixSourceDriver *driver = afunix_sd_new_stream(socket_path, configuration);
+  LogDriver *s = &driver->super.super.super;
+
+  afsocket_sd_set_max_connections(s, max_connections);
+  afsocket_sd_set_accept_threads(s, accept_threads);
+  cr_assert(log_pipe_init(&s->super), "Error initializing unix-stream source");
+  return &driver->super;
+}
+
+static AFSocketSourceDriver *
+_create_udp_source(gint listeners)
+{
+  AFInetSourceDriver *driver = afinet_sd_new_udp(configuration);
+  LogDriver *s = &driver->super.super.super;
+  gchar localip[] = "127.0.0.1";
+  gchar port[16];
+
+  g_snprintf(port, sizeof(port), "%d", 20000 + (gint) getpid() % 20000);
+  afinet_sd_set_localip(s, localip);
+  afinet_sd_set_localport(s, port);
+  afsocket_sd_set_listeners(s, listeners);
+  return &driver->super;
+}
+
+static void
+_destroy_source(AFSocketSourceDriver *driver)
+{
+  log_pipe_deinit(&driver->super.super.super);
+  log_pipe_unref(&driver->super.super.super);
+}
+
+static gint
+_connect_client(void)
+{
+  struct sockaddr_un addr;
+  gint fd;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  g_strlcpy(addr.sun_path, socket_path, sizeof(addr.sun_path));
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  cr_assert(fd >= 0);
+  cr_assert(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0, "Error connecting: %s", g_strerror(errno));
+  return fd;
+}
+
+static gboolean
+_client_closed_by_peer(gint fd)
+{
+  gchar c;
+
+  return recv(fd, &c, sizeof(c), MSG_DONTWAIT) == 0;
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  configuration->stats_options.level = 1;
+  cr_assert(cfg_init(configuration));
+
+  g_snprintf(socket_path, sizeof(socket_path), "test_afsocket_source.%d.sock", (gint) getpid());
+}
+
+static void
+teardown(void)
+{
+  unlink(socket_path);
+  cfg_deinit(configuration);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(afsocket_source, .init = setup, .fini = teardown);
+
+Test(afsocket_source, test_accept_threads_set_up_connections)
+{
+  AFSocketSourceDriver *driver = _create_unix_stream_source(10, 2);
+  gint clients[3];
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS(clients); i++)
+    clients[i] = _connect_client();
+
+  _wait_for_connections(driver, G_N_ELEMENTS(clients));
+
+  cr_assert_eq(driver->num_connections, G_N_ELEMENTS(clients));
+  cr_assert_eq(stats_counter_get(driver->handshakes), G_N_ELEMENTS(clients));
+  cr_assert_eq(stats_counter_get(driver->accept_queue), 0);
+  for (i = 0; i < G_N_ELEMENTS(clients); i++)
+    cr_assert_not(_client_closed_by_peer(clients[i]), "client %d should have been accepted", i);
+
+  _destroy_source(driver);
+  for (i = 0; i < G_N_ELEMENTS(clients); i++)
+    close(clients[i]);
+}
+
+Test(afsocket_source, test_connections_being_set_up_count_against_max_connections)
+{
+  AFSocketSourceDriver *driver = _create_unix_stream_source(2, 1);
+  gint clients[3];
+  gint i;
+
+  /* all three are accepted by the same accept callback, before any of
+   * them could be set up by the accept workers */
+  for (i = 0; i < G_N_ELEMENTS(clients); i++)
+    clients[i] = _connect_client();
+
+  _wait_for_connections(driver, 2);
+
+  cr_assert_eq(driver->num_connections, 2);
+  /* the third one was rejected right away, no handshake was attempted */
+  cr_assert_eq(stats_counter_get(driver->handshakes), 2);
+  cr_assert_not(_client_closed_by_peer(clients[0]));
+  cr_assert_not(_client_closed_by_peer(clients[1]));
+  cr_assert(_client_closed_by_peer(clients[2]));
+
+  _destroy_source(driver);
+  for (i = 0; i < G_N_ELEMENTS(clients); i++)
+    close(clients[i]);
+}
+
+Test(afsocket_source, test_dgram_listeners_open_a_socket_each)
+{
+  AFSocketSourceDriver *driver = _create_udp_source(3);
+
+  cr_assert(log_pipe_init(&driver->super.super.super), "Error initializing udp source");
+  cr_assert_eq(driver->num_connections, 3);
+  /* SO_REUSEPORT is set on the sockets only, not in the user's options */
+  cr_assert_not(driver->socket_options->so_reuseport);
+
+  _destroy_source(driver);
+}
+
+Test(afsocket_source, test_single_dgram_listener_is_the_default)
+{
+  AFSocketSourceDriver *driver = _create_udp_source(1);
+
+  cr_assert(log_pipe_init(&driver->super.super.super), "Error initializing udp source");
+  cr_assert_eq(driver->num_connections, 1);
+
+  _destroy_source(driver);
+}
+
+Test(afsocket_source, test_listeners_are_rejected_on_stream_transports)
+{
+  AFUnixSourceDriver *driver = afunix_sd_new_stream(socket_path, configuration);
+  LogDriver *s = &driver->super.super.super;
+
+  afsocket_sd_set_listeners(s, 2);
+  cr_assert_not(log_pipe_init(&s->super), "listeners() should not be accepted by unix-stream");
+
+  log_pipe_unref(&s->super);
+}
@@ -48,12 +48,9 @@ transport_mapper_privileged_bind(gint sock, GSockAddr *bind_addr)
   return status == G_IO_STATUS_NORMAL;
 }
 
-gboolean
-transport_mapper_open_socket(TransportMapper *self,
-                             SocketOptions *socket_options,
-                             GSockAddr *bind_addr,
-                             AFSocketDirection dir,
-                             int *fd)
+static gboolean
+_open_socket(TransportMapper *self, SocketOptions *socket_options, GSockAddr *bind_addr, AFSocketDirection dir,
+             gboolean reuseport, int *fd)
 {
   gint sock;
 
@@ -71,6 +68,9 @@ transport_mapper_open_socket(TransportMapper *self,
   if (!socket_options_setup_socket(socket_options, sock, bind_addr, dir))
     goto error_close;
 
+  if (reuseport && !socket_options_setup_reuseport(sock))
+    goto error_close;
+
   if (!transport_mapper_privileged_bind(sock, bind_addr))
     {
       gchar buf[256];
@@ -91,6 +91,28 @@ error:
   return FALSE;
 }
 
+gboolean
+transport_mapper_open_socket(TransportMapper *self,
+                             SocketOptions *socket_options,
+                             GSockAddr *bind_addr,
+                             AFSocketDirection dir,
+                             int *fd)
+{
+  return _open_socket(self, socket_options, bind_addr, dir, FALSE, fd);
+}
+
+/* opens a socket that shares @bind_addr with others using SO_REUSEPORT,
+ * regardless of the so-reuseport() setting in @socket_options */
+gboolean
+transport_mapper_open_reuseport_socket(TransportMapper *self,
+                                       SocketOptions *socket_options,
+                                       GSockAddr *bind_addr,
+                                       AFSocketDirection dir,
+                                       int *fd)
+{
+  return _open_socket(self, socket_options, bind_addr, dir, TRUE, fd);
+}
+
 gboolean
 transport_mapper_apply_transport_method(TransportMapper *self, GlobalConfig *cfg)
 {
@@ -63,6 +63,11 @@ gboolean transport_mapper_open_socket(TransportMapper *self,
                                       GSockAddr *bind_addr,
                                       AFSocketDirection dir,
                                       int *fd);
+gboolean transport_mapper_open_reuseport_socket(TransportMapper *self,
+                                                SocketOptions *socket_options,
+                                                GSockAddr *bind_addr,
+                                                AFSocketDirection dir,
+                                                int *fd);
 
 gboolean transport_mapper_apply_transport_method(TransportMapper *self, GlobalConfig *cfg);
 LogTransport *transport_mapper_construct_log_transport_method(TransportMapper *self, gint fd);
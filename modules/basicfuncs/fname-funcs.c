@@ -34,7 +34,7 @@ tf_basename(LogMessage *msg, gint argc, GString *argv[], GString *result)
   g_free(base);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_basename);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_basename);
 
 static void
 tf_dirname(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -46,4 +46,4 @@ tf_dirname(LogMessage *msg, gint argc, GString *argv[], GString *result)
   g_free(dir);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_dirname);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_dirname);
@@ -51,7 +51,7 @@ tf_list_concat(LogMessage *msg, gint argc, GString *argv[], GString *result)
   list_scanner_deinit(&scanner);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_concat);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_concat);
 
 static void
 tf_list_append(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -68,7 +68,7 @@ tf_list_append(LogMessage *msg, gint argc, GString *argv[], GString *result)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_append);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_append);
 
 static gint
 _list_count(gint argc, GString *argv[])
@@ -186,7 +186,7 @@ tf_list_head(LogMessage *msg, gint argc, GString *argv[], GString *result)
   _list_nth(argc, argv, result, 0);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_head);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_head);
 
 static void
 tf_list_nth(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -209,7 +209,7 @@ tf_list_nth(LogMessage *msg, gint argc, GString *argv[], GString *result)
   _list_nth(argc - 1, &argv[1], result, ndx);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_nth);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_nth);
 
 static void
 tf_list_tail(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -220,7 +220,7 @@ tf_list_tail(LogMessage *msg, gint argc, GString *argv[], GString *result)
   _list_slice(argc, argv, result, 1, INT_MAX);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_tail);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_tail);
 
 static void
 tf_list_count(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -229,7 +229,7 @@ tf_list_count(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_uint32_padded(result, -1, ' ', 10, count);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_count);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_count);
 
 /* $(list-slice FIRST:LAST list ...) */
 static void
@@ -274,4 +274,4 @@ tf_list_slice(LogMessage *msg, gint argc, GString *argv[], GString *result)
               (gint) first_ndx, (gint) last_ndx);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_list_slice);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_list_slice);
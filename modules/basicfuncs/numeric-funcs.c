@@ -67,7 +67,7 @@ tf_num_plus(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_int64_padded(result, 0, ' ', 10, n + m);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_num_plus);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_num_plus);
 
 static void
 tf_num_minus(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -83,7 +83,7 @@ tf_num_minus(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_int64_padded(result, 0, ' ', 10, n - m);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_num_minus);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_num_minus);
 
 static void
 tf_num_multi(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -99,7 +99,7 @@ tf_num_multi(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_int64_padded(result, 0, ' ', 10, n * m);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_num_multi);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_num_multi);
 
 static void
 tf_num_div(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -115,7 +115,7 @@ tf_num_div(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_int64_padded(result, 0, ' ', 10, n / m);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_num_div);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_num_div);
 
 static void
 tf_num_mod(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -131,7 +131,7 @@ tf_num_mod(LogMessage *msg, gint argc, GString *argv[], GString *result)
   format_uint64_padded(result, 0, ' ', 10, n % m);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_num_mod);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_num_mod);
 
 static gboolean
 _tf_num_parse_arg_with_message(const TFSimpleFuncState *state,
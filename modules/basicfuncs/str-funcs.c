@@ -45,7 +45,7 @@ tf_echo(LogMessage *msg, gint argc, GString *argv[], GString *result)
   _append_args_with_separator(argc, argv, result, ' ');
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_echo);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_echo);
 
 static void
 tf_length(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -60,7 +60,7 @@ tf_length(LogMessage *msg, gint argc, GString *argv[], GString *result)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_length);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_length);
 
 /*
  * $(substr $arg START [LEN])
@@ -172,7 +172,7 @@ tf_substr(LogMessage *msg, gint argc, GString *argv[], GString *result)
   g_string_append_len(result, argv[0]->str + start, len);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_substr);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_substr);
 
 /*
  * $(strip $arg1 $arg2 ...)
@@ -206,7 +206,7 @@ tf_strip(LogMessage *msg, gint argc, GString *argv[], GString *result)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_strip);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_strip);
 
 /*
  * $(sanitize [opts] $arg1 $arg2 ...)
@@ -331,7 +331,7 @@ tf_indent_multi_line(LogMessage *msg, gint argc, GString *argv[], GString *text)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_indent_multi_line);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_indent_multi_line);
 
 void
 tf_lowercase(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -350,7 +350,7 @@ tf_lowercase(LogMessage *msg, gint argc, GString *argv[], GString *result)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_lowercase);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_lowercase);
 
 void
 tf_uppercase(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -369,7 +369,7 @@ tf_uppercase(LogMessage *msg, gint argc, GString *argv[], GString *result)
     }
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_uppercase);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_uppercase);
 
 void
 tf_replace_delimiter(LogMessage *msg, gint argc, GString *argv[], GString *result)
@@ -391,7 +391,7 @@ tf_replace_delimiter(LogMessage *msg, gint argc, GString *argv[], GString *resul
   g_free(haystack);
 }
 
-TEMPLATE_FUNCTION_SIMPLE(tf_replace_delimiter);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_replace_delimiter);
 
 typedef struct _TFStringPaddingState
 {
@@ -628,4 +628,4 @@ tf_base64encode(LogMessage *msg, gint argc, GString *argv[], GString *result)
   g_string_set_size(result, init_len + out_len);
 };
 
-TEMPLATE_FUNCTION_SIMPLE(tf_base64encode);
+TEMPLATE_FUNCTION_SIMPLE_PURE(tf_base64encode);
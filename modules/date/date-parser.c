@@ -26,6 +26,38 @@
 #include "timeutils/strptime-tz.h"
 #include "timeutils/timeutils.h"
 #include "timeutils/cache.h"
+#include "tls-support.h"
+
+#include <string.h>
+
+/* inputs longer than this are always converted from scratch */
+#define DATE_PARSER_CACHE_KEY_MAX 64
+#define DATE_PARSER_CACHE_SIZE 4
+
+/* Remembers the outcome of the last few conversions of this thread.  An
+ * entry is only reused within the same minute of the receive time, as
+ * the year and the timezone offset we deduce depend on it. */
+typedef struct _DateParserCacheEntry
+{
+  guint32 parser_id;
+  gint input_len;
+  gchar input[DATE_PARSER_CACHE_KEY_MAX];
+  time_t now_minute;
+  time_t tv_sec;
+  glong zone_offset;
+} DateParserCacheEntry;
+
+TLS_BLOCK_START
+{
+  DateParserCacheEntry date_parser_cache[DATE_PARSER_CACHE_SIZE];
+  gint date_parser_cache_next;
+}
+TLS_BLOCK_END;
+
+#define date_parser_cache __tls_deref(date_parser_cache)
+#define date_parser_cache_next __tls_deref(date_parser_cache_next)
+
+static gint date_parser_last_id;
 
 typedef struct _DateParser
 {
@@ -34,6 +66,7 @@ typedef struct _DateParser
   gchar *date_tz;
   LogMessageTimeStamp time_stamp;
   TimeZoneInfo *date_tz_info;
+  guint32 cache_id;
 } DateParser;
 
 void
@@ -70,6 +103,10 @@ date_parser_init(LogPipe *s)
   if (self->date_tz_info)
     time_zone_info_free(self->date_tz_info);
   self->date_tz_info = self->date_tz ? time_zone_info_new(self->date_tz) : NULL;
+
+  /* a new id on every init, so that entries cached with the previous
+   * format or timezone are never returned */
+  self->cache_id = (guint32) g_atomic_int_add(&date_parser_last_id, 1) + 1;
   return log_parser_init_method(s);
 }
 
@@ -176,6 +213,63 @@ _convert_timestamp_to_logstamp(DateParser *self, time_t now, LogStamp *target, c
   return TRUE;
 }
 
+static DateParserCacheEntry *
+_lookup_cached_conversion(DateParser *self, time_t now, const gchar *input, gint input_len)
+{
+  gint i;
+
+  for (i = 0; i < DATE_PARSER_CACHE_SIZE; i++)
+    {
+      DateParserCacheEntry *entry = &date_parser_cache[i];
+
+      if (entry->parser_id == self->cache_id &&
+          entry->input_len == input_len &&
+          entry->now_minute == now / 60 &&
+          memcmp(entry->input, input, input_len) == 0)
+        return entry;
+    }
+  return NULL;
+}
+
+static void
+_store_cached_conversion(DateParser *self, time_t now, const gchar *input, gint input_len, const LogStamp *stamp)
+{
+  DateParserCacheEntry *entry = &date_parser_cache[date_parser_cache_next];
+
+  date_parser_cache_next = (date_parser_cache_next + 1) % DATE_PARSER_CACHE_SIZE;
+  entry->parser_id = self->cache_id;
+  entry->input_len = input_len;
+  memcpy(entry->input, input, input_len);
+  entry->now_minute = now / 60;
+  entry->tv_sec = stamp->tv_sec;
+  entry->zone_offset = stamp->zone_offset;
+}
+
+static gboolean
+_convert_timestamp_to_logstamp_cached(DateParser *self, time_t now, LogStamp *target, const gchar *input,
+                                      gsize input_len)
+{
+  DateParserCacheEntry *entry;
+
+  if (input_len > DATE_PARSER_CACHE_KEY_MAX)
+    return _convert_timestamp_to_logstamp(self, now, target, input);
+
+  entry = _lookup_cached_conversion(self, now, input, input_len);
+  if (entry)
+    {
+      target->tv_sec = entry->tv_sec;
+      target->tv_usec = 0;
+      target->zone_offset = entry->zone_offset;
+      return TRUE;
+    }
+
+  if (!_convert_timestamp_to_logstamp(self, now, target, input))
+    return FALSE;
+
+  _store_cached_conversion(self, now, input, input_len, target);
+  return TRUE;
+}
+
 static gboolean
 date_parser_process(LogParser *s,
                     LogMessage **pmsg,
@@ -195,10 +289,10 @@ date_parser_process(LogParser *s,
    */
 
   APPEND_ZERO(input, input, input_len);
-  gboolean res = _convert_timestamp_to_logstamp(self,
-                                                msg->timestamps[LM_TS_RECVD].tv_sec,
-                                                &msg->timestamps[self->time_stamp],
-                                                input);
+  gboolean res = _convert_timestamp_to_logstamp_cached(self,
+                                                       msg->timestamps[LM_TS_RECVD].tv_sec,
+                                                       &msg->timestamps[self->time_stamp],
+                                                       input, input_len);
 
   return res;
 }
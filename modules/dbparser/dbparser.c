@@ -27,6 +27,9 @@
 #include "apphook.h"
 #include "reloc.h"
 #include "stateful-parser.h"
+#include "pdb-load.h"
+#include "mainloop-worker.h"
+#include "mainloop-call.h"
 
 #include <sys/stat.h>
 #include <iv.h>
@@ -36,7 +39,6 @@
 struct _LogDBParser
 {
   StatefulParser super;
-  GStaticMutex lock;
   struct iv_timer tick;
   PatternDB *db;
   gchar *db_file;
@@ -44,9 +46,61 @@ struct _LogDBParser
   ino_t db_file_inode;
   time_t db_file_mtime;
   gboolean db_file_reloading;
+  WorkerOptions reload_worker_options;
   gboolean drop_unmatched;
 };
 
+/* a pattern database reload running in the background.  It is referenced
+ * by the worker until it finishes and by the exit notification, which
+ * the main loop keeps until the next time it asks the workers to exit. */
+typedef struct _LogDBParserReloadJob
+{
+  gint ref_cnt;
+  gint cancelled;
+  LogDBParser *parser;
+  PDBRuleSet *ruleset;
+  gboolean parsed;
+} LogDBParserReloadJob;
+
+/* kept across configuration reloads, together with the stamp of the
+ * file it was loaded from, so that an unchanged pattern database is not
+ * parsed again on every reload */
+typedef struct _LogDBParserReloadStoreItem
+{
+  PatternDB *db;
+  ino_t db_file_inode;
+  time_t db_file_mtime;
+} LogDBParserReloadStoreItem;
+
+static LogDBParserReloadStoreItem *
+_reload_store_item_new(LogDBParser *self)
+{
+  LogDBParserReloadStoreItem *item = g_new(LogDBParserReloadStoreItem, 1);
+
+  item->db = self->db;
+  item->db_file_inode = self->db_file_inode;
+  item->db_file_mtime = self->db_file_mtime;
+  return item;
+}
+
+static void
+_reload_store_item_free(LogDBParserReloadStoreItem *self)
+{
+  if (self->db)
+    pattern_db_free(self->db);
+  g_free(self);
+}
+
+static void
+_reload_store_item_restore(LogDBParserReloadStoreItem *item, LogDBParser *self)
+{
+  self->db = item->db;
+  self->db_file_inode = item->db_file_inode;
+  self->db_file_mtime = item->db_file_mtime;
+  item->db = NULL;
+  _reload_store_item_free(item);
+}
+
 static void
 log_db_parser_emit(LogMessage *msg, gboolean synthetic, gpointer user_data)
 {
@@ -60,39 +114,186 @@ log_db_parser_emit(LogMessage *msg, gboolean synthetic, gpointer user_data)
     }
 }
 
-static void
-log_db_parser_reload_database(LogDBParser *self)
+/* checks the stamp of the database file and records the new one if it changed */
+static gboolean
+log_db_parser_db_file_changed(LogDBParser *self)
 {
   struct stat st;
-  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
 
   if (stat(self->db_file, &st) < 0)
     {
       msg_error("Error stating pattern database file, no automatic reload will be performed",
                 evt_tag_str("error", g_strerror(errno)));
-      return;
+      return FALSE;
     }
   if ((self->db_file_inode == st.st_ino && self->db_file_mtime == st.st_mtime))
     {
-      return;
+      return FALSE;
     }
 
   self->db_file_inode = st.st_ino;
   self->db_file_mtime = st.st_mtime;
+  return TRUE;
+}
+
+static gboolean
+log_db_parser_load_database(LogDBParser *self)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
 
   if (!pattern_db_reload_ruleset(self->db, cfg, self->db_file))
     {
       msg_error("Error reloading pattern database, no automatic reload will be performed");
+      return FALSE;
+    }
+
+  /* the old database is freed if the new was loaded successfully */
+  msg_notice("Log pattern database reloaded",
+             evt_tag_str("file", self->db_file),
+             evt_tag_str("version", pattern_db_get_ruleset_version(self->db)),
+             evt_tag_str("pub_date", pattern_db_get_ruleset_pub_date(self->db)));
+  return TRUE;
+}
+
+static gboolean
+log_db_parser_compile_database(LogDBParser *self)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
+
+  if (!pattern_db_compile_ruleset(self->db, cfg))
+    return FALSE;
+
+  msg_debug("Log pattern database compiled against the new configuration",
+            evt_tag_str("file", self->db_file));
+  return TRUE;
+}
+
+static void
+log_db_parser_reload_database(LogDBParser *self)
+{
+  if (log_db_parser_db_file_changed(self))
+    log_db_parser_load_database(self);
+}
+
+/*
+ * The templates and filters of a database kept from the previous
+ * configuration are bound to that configuration, so they are compiled
+ * again.  That is all that is needed if the file did not change, the
+ * XML is only parsed again when it did.  Whichever fails, the other is
+ * tried, and the correllation state is only dropped if neither works.
+ */
+static void
+log_db_parser_rebind_database(LogDBParser *self)
+{
+  gboolean success;
+
+  if (log_db_parser_db_file_changed(self))
+    success = log_db_parser_load_database(self) || log_db_parser_compile_database(self);
+  else
+    success = log_db_parser_compile_database(self) || log_db_parser_load_database(self);
+
+  if (!success)
+    {
+      msg_error("Error compiling pattern database with the new configuration, dropping correllation state",
+                evt_tag_str("file", self->db_file));
+      pattern_db_free(self->db);
+      self->db = pattern_db_new();
+    }
+}
+
+static void
+log_db_parser_reload_job_unref(LogDBParserReloadJob *job)
+{
+  g_assert(job->ref_cnt > 0);
+  if (--job->ref_cnt == 0)
+    {
+      g_assert(job->ruleset == NULL);
+      g_free(job);
+    }
+}
+
+/* runs in the main thread, once the worker is done with parsing */
+static gpointer
+log_db_parser_reload_job_finish(gpointer s)
+{
+  LogDBParserReloadJob *job = (LogDBParserReloadJob *) s;
+  LogDBParser *self = job->parser;
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
+
+  if (g_atomic_int_get(&job->cancelled))
+    {
+      /* forget the stamp, so that the new configuration loads the file */
+      self->db_file_inode = 0;
+      self->db_file_mtime = 0;
+      pdb_rule_set_free(job->ruleset);
+    }
+  else if (!job->parsed || !pdb_rule_set_compile(job->ruleset, cfg))
+    {
+      msg_error("Error reloading pattern database, no automatic reload will be performed");
+      pdb_rule_set_free(job->ruleset);
     }
   else
     {
-      /* free the old database if the new was loaded successfully */
+      pattern_db_replace_ruleset(self->db, job->ruleset);
       msg_notice("Log pattern database reloaded",
                  evt_tag_str("file", self->db_file),
                  evt_tag_str("version", pattern_db_get_ruleset_version(self->db)),
                  evt_tag_str("pub_date", pattern_db_get_ruleset_pub_date(self->db)));
     }
+  job->ruleset = NULL;
+  self->db_file_reloading = FALSE;
+  log_db_parser_reload_job_unref(job);
+  return NULL;
+}
 
+/*
+ * Only the XML is parsed in the worker thread, templates and filters are
+ * compiled against the configuration in the main thread, where the new
+ * ruleset is swapped in.  Messages are classified using the old ruleset
+ * in the meanwhile.  The worker is a main loop job, so configuration
+ * reloads and shutdown wait for it, after cancelling it.
+ */
+static void
+log_db_parser_reload_job_run(gpointer s)
+{
+  LogDBParserReloadJob *job = (LogDBParserReloadJob *) s;
+
+  job->ruleset = pdb_rule_set_new();
+  job->parsed = pdb_rule_set_parse(job->ruleset, job->parser->db_file, NULL, &job->cancelled);
+  main_loop_call(log_db_parser_reload_job_finish, job, TRUE);
+}
+
+static void
+log_db_parser_reload_job_cancel(gpointer s)
+{
+  LogDBParserReloadJob *job = (LogDBParserReloadJob *) s;
+
+  g_atomic_int_set(&job->cancelled, TRUE);
+  log_db_parser_reload_job_unref(job);
+}
+
+static void
+log_db_parser_check_database(LogDBParser *self)
+{
+  LogDBParserReloadJob *job;
+
+  if (self->db_file_reloading)
+    return;
+
+  if (self->db_file_last_check != 0 && self->db_file_last_check >= iv_now.tv_sec - 5)
+    return;
+
+  self->db_file_last_check = iv_now.tv_sec;
+  if (!log_db_parser_db_file_changed(self))
+    return;
+
+  job = g_new0(LogDBParserReloadJob, 1);
+  job->ref_cnt = 2;
+  job->parser = self;
+
+  self->db_file_reloading = TRUE;
+  main_loop_create_worker_thread(log_db_parser_reload_job_run, log_db_parser_reload_job_cancel, job,
+                                 &self->reload_worker_options);
 }
 
 static void
@@ -102,6 +303,7 @@ log_db_parser_timer_tick(gpointer s)
 
   pattern_db_timer_tick(self->db);
   iv_validate_now();
+  log_db_parser_check_database(self);
   self->tick.expires = iv_now;
   self->tick.expires.tv_sec++;
   iv_timer_register(&self->tick);
@@ -121,23 +323,13 @@ log_db_parser_init(LogPipe *s)
 {
   LogDBParser *self = (LogDBParser *) s;
   GlobalConfig *cfg = log_pipe_get_config(s);
+  LogDBParserReloadStoreItem *item;
 
-  self->db = cfg_persist_config_fetch(cfg, log_db_parser_format_persist_name(self));
-  if (self->db)
+  item = cfg_persist_config_fetch(cfg, log_db_parser_format_persist_name(self));
+  if (item)
     {
-      struct stat st;
-
-      if (stat(self->db_file, &st) < 0)
-        {
-          msg_error("Error stating pattern database file, no automatic reload will be performed",
-                    evt_tag_str("error", g_strerror(errno)));
-        }
-      else if (self->db_file_inode != st.st_ino || self->db_file_mtime != st.st_mtime)
-        {
-          log_db_parser_reload_database(self);
-          self->db_file_inode = st.st_ino;
-          self->db_file_mtime = st.st_mtime;
-        }
+      _reload_store_item_restore(item, self);
+      log_db_parser_rebind_database(self);
     }
   else
     {
@@ -170,7 +362,8 @@ log_db_parser_deinit(LogPipe *s)
       iv_timer_unregister(&self->tick);
     }
 
-  cfg_persist_config_add(cfg, log_db_parser_format_persist_name(self), self->db, (GDestroyNotify) pattern_db_free, FALSE);
+  cfg_persist_config_add(cfg, log_db_parser_format_persist_name(self), _reload_store_item_new(self),
+                         (GDestroyNotify) _reload_store_item_free, FALSE);
   self->db = NULL;
   return stateful_parser_deinit_method(s);
 }
@@ -182,30 +375,6 @@ log_db_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *pat
   LogDBParser *self = (LogDBParser *) s;
   gboolean matched = FALSE;
 
-  if (G_UNLIKELY(!self->db_file_reloading && (self->db_file_last_check == 0
-                                              || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].tv_sec - 5)))
-    {
-      /* first check if we need to reload without doing a lock, then grab
-       * the lock, recheck the condition to rule out parallel database
-       * reloads. This avoids a lock in the fast path. */
-
-      g_static_mutex_lock(&self->lock);
-
-      if (!self->db_file_reloading && (self->db_file_last_check == 0
-                                       || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].tv_sec - 5))
-        {
-          self->db_file_last_check = (*pmsg)->timestamps[LM_TS_RECVD].tv_sec;
-          self->db_file_reloading = TRUE;
-          g_static_mutex_unlock(&self->lock);
-
-          /* only one thread may come here, the others may continue to use self->db, until we update it here. */
-          log_db_parser_reload_database(self);
-
-          g_static_mutex_lock(&self->lock);
-          self->db_file_reloading = FALSE;
-        }
-      g_static_mutex_unlock(&self->lock);
-    }
   if (self->db)
     {
       log_msg_make_writable(pmsg, path_options);
@@ -262,8 +431,6 @@ log_db_parser_free(LogPipe *s)
 {
   LogDBParser *self = (LogDBParser *) s;
 
-  g_static_mutex_free(&self->lock);
-
   if (self->db)
     pattern_db_free(self->db);
 
@@ -284,7 +451,6 @@ log_db_parser_new(GlobalConfig *cfg)
   self->super.super.super.clone = log_db_parser_clone;
   self->super.super.process = log_db_parser_process;
   self->db_file = g_strdup(get_installation_path_for(PATH_PATTERNDB_FILE));
-  g_static_mutex_init(&self->lock);
   if (cfg_is_config_version_older(cfg, 0x0303))
     {
       msg_warning_once("WARNING: The default behaviour for injecting messages in db-parser() has changed in " VERSION_3_3
@@ -530,6 +530,95 @@ pattern_db_advance_time(PatternDB *self, gint timeout)
   _flush_emitted_messages(self, process_params);
 }
 
+typedef struct _PDBRebindContextsParams
+{
+  PatternDB *db;
+  GHashTable *rules_by_id;
+} PDBRebindContextsParams;
+
+static void
+_index_rule_by_id(gpointer data, gpointer user_data)
+{
+  PDBRule *rule = (PDBRule *) data;
+  GHashTable *rules_by_id = (GHashTable *) user_data;
+
+  if (rule->rule_id)
+    g_hash_table_insert(rules_by_id, rule->rule_id, rule);
+}
+
+static gboolean
+_rebind_context_to_new_rule(gpointer key, gpointer value, gpointer user_data)
+{
+  PDBContext *context = (PDBContext *) value;
+  PDBRebindContextsParams *params = (PDBRebindContextsParams *) user_data;
+  PDBRule *new_rule = NULL;
+
+  if (!context->rule)
+    return FALSE;
+
+  if (context->rule->rule_id)
+    new_rule = g_hash_table_lookup(params->rules_by_id, context->rule->rule_id);
+
+  if (!new_rule)
+    {
+      msg_debug("Dropping correllation context, its rule is not present in the new pattern database",
+                evt_tag_str("rule", context->rule->rule_id));
+      if (context->super.timer)
+        {
+          timer_wheel_del_timer(params->db->timer_wheel, context->super.timer);
+          context->super.timer = NULL;
+        }
+      return TRUE;
+    }
+
+  pdb_rule_unref(context->rule);
+  context->rule = pdb_rule_ref(new_rule);
+  return FALSE;
+}
+
+/*
+ * Correllation contexts reference the rule that touched them last, whose
+ * actions are run when the context times out.  Point them to the rule
+ * with the same id in the new ruleset and drop the ones that would be
+ * left without a rule.  Must be called with the writer lock held.
+ */
+static void
+_rebind_contexts_to_ruleset(PatternDB *self, PDBRuleSet *ruleset)
+{
+  PDBRebindContextsParams params;
+
+  if (g_hash_table_size(self->correllation.state) == 0)
+    return;
+
+  params.db = self;
+  params.rules_by_id = g_hash_table_new(g_str_hash, g_str_equal);
+  pdb_rule_set_foreach_rule(ruleset, _index_rule_by_id, params.rules_by_id);
+  g_hash_table_foreach_remove(self->correllation.state, _rebind_context_to_new_rule, &params);
+  g_hash_table_destroy(params.rules_by_id);
+}
+
+/*
+ * Installs @new_ruleset, which must already be compiled.  Correllation
+ * contexts, rate limits and timers are part of the state and survive the
+ * swap.  Lookups keep a reference to the matching rule and only traverse
+ * the ruleset under the reader lock, so the old ruleset can be freed once
+ * the writer lock is released.
+ */
+void
+pattern_db_replace_ruleset(PatternDB *self, PDBRuleSet *new_ruleset)
+{
+  PDBRuleSet *old_ruleset;
+
+  g_static_rw_lock_writer_lock(&self->lock);
+  old_ruleset = self->ruleset;
+  self->ruleset = new_ruleset;
+  _rebind_contexts_to_ruleset(self, new_ruleset);
+  g_static_rw_lock_writer_unlock(&self->lock);
+
+  if (old_ruleset)
+    pdb_rule_set_free(old_ruleset);
+}
+
 gboolean
 pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_file)
 {
@@ -541,15 +630,29 @@ pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_f
       pdb_rule_set_free(new_ruleset);
       return FALSE;
     }
-  else
-    {
-      g_static_rw_lock_writer_lock(&self->lock);
-      if (self->ruleset)
-        pdb_rule_set_free(self->ruleset);
-      self->ruleset = new_ruleset;
-      g_static_rw_lock_writer_unlock(&self->lock);
-      return TRUE;
-    }
+
+  pattern_db_replace_ruleset(self, new_ruleset);
+  return TRUE;
+}
+
+/*
+ * Compiles the current ruleset again against @cfg, without parsing the
+ * pattern database file.  Used when the configuration is reloaded but the
+ * database did not change.  On failure the ruleset is unusable and must
+ * be replaced.
+ */
+gboolean
+pattern_db_compile_ruleset(PatternDB *self, GlobalConfig *cfg)
+{
+  gboolean success;
+
+  if (!self->ruleset)
+    return FALSE;
+
+  g_static_rw_lock_writer_lock(&self->lock);
+  success = pdb_rule_set_compile(self->ruleset, cfg);
+  g_static_rw_lock_writer_unlock(&self->lock);
+  return success;
 }
 
 
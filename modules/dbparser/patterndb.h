@@ -37,6 +37,8 @@ PDBRuleSet *pattern_db_get_ruleset(PatternDB *self);
 const gchar *pattern_db_get_ruleset_version(PatternDB *self);
 const gchar *pattern_db_get_ruleset_pub_date(PatternDB *self);
 gboolean pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_file);
+gboolean pattern_db_compile_ruleset(PatternDB *self, GlobalConfig *cfg);
+void pattern_db_replace_ruleset(PatternDB *self, PDBRuleSet *new_ruleset);
 
 void pattern_db_advance_time(PatternDB *self, gint timeout);
 void pattern_db_timer_tick(PatternDB *self);
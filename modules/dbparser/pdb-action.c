@@ -26,18 +26,22 @@
 
 #include <stdlib.h>
 
-void
+gboolean
 pdb_action_set_condition(PDBAction *self, GlobalConfig *cfg, const gchar *filter_string, GError **error)
 {
   CfgLexer *lexer;
+  FilterExprNode *condition = NULL;
 
   lexer = cfg_lexer_new_buffer(cfg, filter_string, strlen(filter_string));
-  if (!cfg_run_parser(cfg, lexer, &filter_expr_parser, (gpointer *) &self->condition, NULL))
+  if (!cfg_run_parser(cfg, lexer, &filter_expr_parser, (gpointer *) &condition, NULL))
     {
       g_set_error(error, PDB_ERROR, PDB_ERROR_FAILED, "Error compiling conditional expression");
-      self->condition = NULL;
-      return;
+      return FALSE;
     }
+  if (self->condition)
+    filter_expr_unref(self->condition);
+  self->condition = condition;
+  return TRUE;
 }
 
 void
@@ -63,7 +63,7 @@ typedef struct _PDBAction
   } content;
 } PDBAction;
 
-void pdb_action_set_condition(PDBAction *self, GlobalConfig *cfg, const gchar *filter_string, GError **error);
+gboolean pdb_action_set_condition(PDBAction *self, GlobalConfig *cfg, const gchar *filter_string, GError **error);
 void pdb_action_set_rate(PDBAction *self, const gchar *rate_);
 void pdb_action_set_trigger(PDBAction *self, const gchar *trigger, GError **error);
 
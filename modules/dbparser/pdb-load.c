@@ -89,10 +89,10 @@ typedef struct _PDBLoader
   GList *examples;
   gchar *value_name;
   gchar *test_value_name;
-  GlobalConfig *cfg;
   gint action_id;
   GHashTable *ruleset_patterns;
   GArray *program_patterns;
+  GHashTable *value_counts;
 } PDBLoader;
 
 typedef struct _PDBProgramPattern
@@ -101,6 +101,98 @@ typedef struct _PDBProgramPattern
   PDBRule *rule;
 } PDBProgramPattern;
 
+/*
+ * Templates and filter expressions are compiled against a configuration.
+ * The loader only records where they go and what their source is, and
+ * pdb_rule_set_compile() compiles them later.  This way the XML can be
+ * parsed without touching the configuration, and a ruleset can be
+ * compiled again when the configuration is reloaded.
+ */
+typedef enum
+{
+  PDBB_CONTEXT_ID,
+  PDBB_VALUE,
+  PDBB_CONDITION,
+} PDBBindingType;
+
+typedef struct _PDBBinding
+{
+  PDBBindingType type;
+  /* keeps the target alive, the targets are embedded in the rule */
+  PDBRule *rule;
+  gpointer target;
+  gint value_index;
+  gchar *value_name;
+  gchar *source;
+  gchar *location;
+} PDBBinding;
+
+static void
+_pdb_binding_free(PDBBinding *self)
+{
+  pdb_rule_unref(self->rule);
+  g_free(self->value_name);
+  g_free(self->source);
+  g_free(self->location);
+  g_free(self);
+}
+
+static gboolean
+_pdb_binding_compile(PDBBinding *self, GlobalConfig *cfg, GError **error)
+{
+  LogTemplate *template;
+
+  switch (self->type)
+    {
+    case PDBB_CONDITION:
+      return pdb_action_set_condition((PDBAction *) self->target, cfg, self->source, error);
+
+    case PDBB_CONTEXT_ID:
+      template = log_template_new(cfg, NULL);
+      if (!log_template_compile(template, self->source, error))
+        {
+          log_template_unref(template);
+          return FALSE;
+        }
+      synthetic_context_set_context_id_template((SyntheticContext *) self->target, template);
+      return TRUE;
+
+    case PDBB_VALUE:
+      /* NOTE: we shouldn't use the name property for LogTemplate structs, see the comment at log_template_set_name() */
+      template = log_template_new(cfg, self->value_name);
+      if (!log_template_compile(template, self->source, error))
+        {
+          log_template_unref(template);
+          return FALSE;
+        }
+      synthetic_message_set_value_template((SyntheticMessage *) self->target, self->value_index, self->value_name,
+                                           template);
+      log_template_unref(template);
+      return TRUE;
+
+    default:
+      g_assert_not_reached();
+    }
+  return FALSE;
+}
+
+static const gchar *
+_pdb_binding_describe(PDBBinding *self)
+{
+  switch (self->type)
+    {
+    case PDBB_CONDITION:
+      return "conditional expression";
+    case PDBB_CONTEXT_ID:
+      return "context-id template";
+    case PDBB_VALUE:
+      return "value template";
+    default:
+      g_assert_not_reached();
+    }
+  return NULL;
+}
+
 
 static void
 _pdb_state_stack_push(PDBStateStack *self, gint state)
@@ -119,20 +211,27 @@ _pdb_state_stack_pop(PDBStateStack *self)
   return self->stack[self->top];
 }
 
+static gchar *
+pdb_loader_format_location(PDBLoader *state)
+{
+  gint line_number, col_number;
+
+  g_markup_parse_context_get_position(state->context, &line_number, &col_number);
+  return g_strdup_printf("%s:%d:%d", state->filename, line_number, col_number);
+}
+
 static void G_GNUC_PRINTF(3, 4)
 pdb_loader_set_error(PDBLoader *state, GError **error, const gchar *format, ...)
 {
   gchar *error_text;
   gchar *error_location;
-  gint line_number, col_number;
   va_list va;
 
   va_start(va, format);
   error_text = g_strdup_vprintf(format, va);
   va_end(va);
 
-  g_markup_parse_context_get_position(state->context, &line_number, &col_number);
-  error_location = g_strdup_printf("%s:%d:%d", state->filename, line_number, col_number);
+  error_location = pdb_loader_format_location(state);
 
   g_set_error(error, PDB_ERROR, PDB_ERROR_FAILED, "%s: %s", error_location, error_text);
 
@@ -140,6 +239,28 @@ pdb_loader_set_error(PDBLoader *state, GError **error, const gchar *format, ...)
   g_free(error_location);
 }
 
+static void
+pdb_loader_add_binding(PDBLoader *state, PDBBindingType type, gpointer target,
+                       const gchar *value_name, const gchar *source)
+{
+  PDBBinding *binding = g_new0(PDBBinding, 1);
+
+  binding->type = type;
+  binding->rule = pdb_rule_ref(state->current_rule);
+  binding->target = target;
+  binding->value_name = g_strdup(value_name);
+  binding->source = g_strdup(source);
+  binding->location = pdb_loader_format_location(state);
+
+  if (type == PDBB_VALUE)
+    {
+      /* values are applied in order, remember the position of this one */
+      binding->value_index = GPOINTER_TO_INT(g_hash_table_lookup(state->value_counts, target));
+      g_hash_table_insert(state->value_counts, target, GINT_TO_POINTER(binding->value_index + 1));
+    }
+  g_ptr_array_add(state->ruleset->bindings, binding);
+}
+
 static void
 _push_state(PDBLoader *state, gint new_state)
 {
@@ -241,34 +362,22 @@ _process_create_context_element(PDBLoader *state,
                                 SyntheticContext *target,
                                 GError **error)
 {
+  gboolean has_context_id = FALSE;
   gint i;
 
   for (i = 0; attribute_names[i]; i++)
     {
       if (strcmp(attribute_names[i], "context-id") == 0)
         {
-          LogTemplate *template;
-          GError *local_error = NULL;
-
-          template = log_template_new(state->cfg, NULL);
-          if (!log_template_compile(template, attribute_values[i], &local_error))
-            {
-              log_template_unref(template);
-              pdb_loader_set_error(state, error,
-                                   "Error compiling create-context context-id, rule=%s, context-id=%s, error=%s",
-                                   state->current_rule->rule_id, attribute_values[i], local_error->message);
-              g_clear_error(&local_error);
-              return;
-            }
-          else
-            synthetic_context_set_context_id_template(target, template);
+          pdb_loader_add_binding(state, PDBB_CONTEXT_ID, target, NULL, attribute_values[i]);
+          has_context_id = TRUE;
         }
       else if (strcmp(attribute_names[i], "context-timeout") == 0)
         synthetic_context_set_context_timeout(target, strtol(attribute_values[i], NULL, 0));
       else if (strcmp(attribute_names[i], "context-scope") == 0)
         synthetic_context_set_context_scope(target, attribute_values[i], error);
     }
-  if (!target->id_template)
+  if (!has_context_id)
     {
       pdb_loader_set_error(state, error,
                            "context-id attribute is missing from <create-context>, rule=%s",
@@ -488,23 +597,7 @@ _pdbl_rules_start(PDBLoader *state, const gchar *element_name, const gchar **att
           else if (strcmp(attribute_names[i], "id") == 0)
             pdb_rule_set_rule_id(state->current_rule, attribute_values[i]);
           else if (strcmp(attribute_names[i], "context-id") == 0)
-            {
-              LogTemplate *template;
-              GError *local_error = NULL;
-
-              template = log_template_new(state->cfg, NULL);
-              if (!log_template_compile(template, attribute_values[i], &local_error))
-                {
-                  log_template_unref(template);
-                  pdb_loader_set_error(state, error,
-                                       "Error compiling context-id template, rule=%s, context-id=%s, error=%s",
-                                       state->current_rule->rule_id, attribute_values[i], local_error->message);
-                  g_clear_error(&local_error);
-                  return;
-                }
-              else
-                synthetic_context_set_context_id_template(&state->current_rule->context, template);
-            }
+            pdb_loader_add_binding(state, PDBB_CONTEXT_ID, &state->current_rule->context, NULL, attribute_values[i]);
           else if (strcmp(attribute_names[i], "context-timeout") == 0)
             synthetic_context_set_context_timeout(&state->current_rule->context, strtol(attribute_values[i], NULL, 0));
           else if (strcmp(attribute_names[i], "context-scope") == 0)
@@ -768,7 +861,7 @@ _pdbl_rule_actions_start(PDBLoader *state, const gchar *element_name, const gcha
           if (strcmp(attribute_names[i], "trigger") == 0)
             pdb_action_set_trigger(state->current_action, attribute_values[i], error);
           else if (strcmp(attribute_names[i], "condition") == 0)
-            pdb_action_set_condition(state->current_action, state->cfg, attribute_values[i], error);
+            pdb_loader_add_binding(state, PDBB_CONDITION, state->current_action, NULL, attribute_values[i]);
           else if (strcmp(attribute_names[i], "rate") == 0)
             pdb_action_set_rate(state->current_action, attribute_values[i]);
         }
@@ -910,16 +1003,8 @@ _pdbl_value_end(PDBLoader *state, const gchar *element_name, GError **error)
 static gboolean
 _pdbl_value_text(PDBLoader *state, const gchar *text, gsize text_len, GError **error)
 {
-  GError *err = NULL;
-
   g_assert(state->value_name != NULL);
-  if (!synthetic_message_add_value_template_string(state->current_message, state->cfg, state->value_name, text, &err))
-    {
-      pdb_loader_set_error(state, error, "Error compiling value template, rule=%s, name=%s, value=%s, error=%s",
-                           state->current_rule->rule_id, state->value_name, text, err->message);
-      return FALSE;
-    }
-
+  pdb_loader_add_binding(state, PDBB_VALUE, state->current_message, state->value_name, text);
   return TRUE;
 }
 
@@ -1131,8 +1216,13 @@ GMarkupParser db_parser =
   .error = NULL
 };
 
+/*
+ * Parses the pattern database file without compiling anything, so it can
+ * run outside of the main thread.  If @cancelled is not NULL, parsing is
+ * abandoned as soon as it becomes non-zero.
+ */
 gboolean
-pdb_rule_set_load(PDBRuleSet *self, GlobalConfig *cfg, const gchar *config, GList **examples)
+pdb_rule_set_parse(PDBRuleSet *self, const gchar *config, GList **examples, gint *cancelled)
 {
   PDBLoader state;
   GMarkupParseContext *parse_ctx = NULL;
@@ -1156,14 +1246,19 @@ pdb_rule_set_load(PDBRuleSet *self, GlobalConfig *cfg, const gchar *config, GLis
   state.root_program = pdb_program_new();
   state.load_examples = !!examples;
   state.ruleset_patterns = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) pdb_program_unref);
-  state.cfg = cfg;
+  state.value_counts = g_hash_table_new(g_direct_hash, g_direct_equal);
   state.filename = config;
   state.context = parse_ctx = g_markup_parse_context_new(&db_parser, 0, &state, NULL);
 
   self->programs = r_new_node("", state.root_program);
+  if (!self->bindings)
+    self->bindings = g_ptr_array_new_with_free_func((GDestroyNotify) _pdb_binding_free);
 
   while ((bytes_read = fread(buff, sizeof(gchar), 4096, dbfile)) != 0)
     {
+      if (cancelled && g_atomic_int_get(cancelled))
+        goto error;
+
       if (!g_markup_parse_context_parse(parse_ctx, buff, bytes_read, &error))
         {
           msg_error("Error parsing pattern database file",
@@ -1193,6 +1288,46 @@ error:
     fclose(dbfile);
   if (parse_ctx)
     g_markup_parse_context_free(parse_ctx);
+  g_clear_error(&error);
   g_hash_table_unref(state.ruleset_patterns);
+  g_hash_table_unref(state.value_counts);
   return success;
 }
+
+/*
+ * Compiles the templates and filter expressions of a parsed ruleset
+ * against @cfg, replacing the ones compiled earlier.  It can be called
+ * again whenever the configuration changes.  A failure leaves the ruleset
+ * partially compiled, the caller must not use it in that case.
+ */
+gboolean
+pdb_rule_set_compile(PDBRuleSet *self, GlobalConfig *cfg)
+{
+  gint i;
+
+  for (i = 0; self->bindings && i < self->bindings->len; i++)
+    {
+      PDBBinding *binding = g_ptr_array_index(self->bindings, i);
+      GError *error = NULL;
+
+      if (!_pdb_binding_compile(binding, cfg, &error))
+        {
+          msg_error("Error compiling pattern database",
+                    evt_tag_str("location", binding->location),
+                    evt_tag_str("rule", binding->rule->rule_id),
+                    evt_tag_str("type", _pdb_binding_describe(binding)),
+                    evt_tag_str("source", binding->source),
+                    evt_tag_str("error", error ? error->message : "unknown"));
+          g_clear_error(&error);
+          return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+gboolean
+pdb_rule_set_load(PDBRuleSet *self, GlobalConfig *cfg, const gchar *config, GList **examples)
+{
+  return pdb_rule_set_parse(self, config, examples, NULL) &&
+         pdb_rule_set_compile(self, cfg);
+}
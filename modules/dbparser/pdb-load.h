@@ -27,6 +27,8 @@
 #include "pdb-ruleset.h"
 #include "cfg.h"
 
+gboolean pdb_rule_set_parse(PDBRuleSet *self, const gchar *config, GList **examples, gint *cancelled);
+gboolean pdb_rule_set_compile(PDBRuleSet *self, GlobalConfig *cfg);
 gboolean pdb_rule_set_load(PDBRuleSet *self, GlobalConfig *cfg, const gchar *config, GList **examples);
 
 #endif
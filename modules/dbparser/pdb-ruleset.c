@@ -160,6 +160,45 @@ pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_li
 
 }
 
+static void
+_foreach_rule_in_node(RNode *node, GFunc func, gpointer user_data)
+{
+  gint i;
+
+  if (node->value)
+    func(node->value, user_data);
+  for (i = 0; i < node->num_children; i++)
+    _foreach_rule_in_node(node->children[i], func, user_data);
+  for (i = 0; i < node->num_pchildren; i++)
+    _foreach_rule_in_node(node->pchildren[i], func, user_data);
+}
+
+static void
+_foreach_program_in_node(RNode *node, GFunc func, gpointer user_data)
+{
+  gint i;
+
+  if (node->value)
+    {
+      PDBProgram *program = (PDBProgram *) node->value;
+
+      if (program->rules)
+        _foreach_rule_in_node(program->rules, func, user_data);
+    }
+  for (i = 0; i < node->num_children; i++)
+    _foreach_program_in_node(node->children[i], func, user_data);
+  for (i = 0; i < node->num_pchildren; i++)
+    _foreach_program_in_node(node->pchildren[i], func, user_data);
+}
+
+/* NOTE: a program may be registered under several names, in which case
+ * its rules are visited more than once */
+void
+pdb_rule_set_foreach_rule(PDBRuleSet *self, GFunc func, gpointer user_data)
+{
+  if (self->programs)
+    _foreach_program_in_node(self->programs, func, user_data);
+}
 
 PDBRuleSet *
 pdb_rule_set_new(void)
@@ -179,9 +218,12 @@ pdb_rule_set_free(PDBRuleSet *self)
     g_free(self->version);
   if (self->pub_date)
     g_free(self->pub_date);
+  if (self->bindings)
+    g_ptr_array_free(self->bindings, TRUE);
   self->programs = NULL;
   self->version = NULL;
   self->pub_date = NULL;
+  self->bindings = NULL;
 
   g_free(self);
 }
@@ -35,9 +35,12 @@ typedef struct _PDBRuleSet
   gchar *version;
   gchar *pub_date;
   gboolean is_empty;
+  /* templates and filters to be compiled, see pdb_rule_set_compile() */
+  GPtrArray *bindings;
 } PDBRuleSet;
 
 PDBRule *pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_list);
+void pdb_rule_set_foreach_rule(PDBRuleSet *self, GFunc func, gpointer user_data);
 PDBRuleSet *pdb_rule_set_new(void);
 void pdb_rule_set_free(PDBRuleSet *self);
 
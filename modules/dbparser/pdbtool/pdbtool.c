@@ -222,8 +222,34 @@ static gchar *merge_dir = NULL;
 static gchar *merge_glob = NULL;
 static gboolean merge_recursive = FALSE;
 
+/* a single input file of "pdbtool merge", the files are converted in
+ * parallel, each into its own buffer, which are then concatenated in
+ * the order the files were found */
+typedef struct _PdbToolMergeFile
+{
+  gchar *filename;
+  GString *merged;
+  gboolean success;
+} PdbToolMergeFile;
+
+static void
+pdbtool_merge_file_free(PdbToolMergeFile *self)
+{
+  g_free(self->filename);
+  g_string_free(self->merged, TRUE);
+  g_free(self);
+}
+
+static void
+pdbtool_merge_file_worker(gpointer data, gpointer user_data)
+{
+  PdbToolMergeFile *file = (PdbToolMergeFile *) data;
+
+  file->success = pdbtool_merge_file(file->filename, file->merged);
+}
+
 static gboolean
-pdbtool_merge_dir(const gchar *dir, gboolean recursive, GString *merged)
+pdbtool_merge_collect_files(const gchar *dir, gboolean recursive, GPtrArray *files)
 {
   GDir *pdb_dir;
   gboolean ok = TRUE;
@@ -243,16 +269,52 @@ pdbtool_merge_dir(const gchar *dir, gboolean recursive, GString *merged)
 
       if (recursive && is_file_directory(full_name))
         {
-          ok = pdbtool_merge_dir(full_name, recursive, merged);
+          ok = pdbtool_merge_collect_files(full_name, recursive, files);
         }
       else if (is_file_regular(full_name) && (!merge_glob || g_pattern_match_simple(merge_glob, filename)))
         {
-          ok = pdbtool_merge_file(full_name, merged);
+          PdbToolMergeFile *file = g_new0(PdbToolMergeFile, 1);
+
+          file->filename = full_name;
+          file->merged = g_string_sized_new(4096);
+          g_ptr_array_add(files, file);
+          continue;
         }
       g_free(full_name);
     }
   g_dir_close(pdb_dir);
-  return TRUE;
+  return ok;
+}
+
+static gboolean
+pdbtool_merge_dir(const gchar *dir, gboolean recursive, GString *merged)
+{
+  GPtrArray *files = g_ptr_array_new_with_free_func((GDestroyNotify) pdbtool_merge_file_free);
+  GThreadPool *workers;
+  gboolean ok;
+  gint i;
+
+  ok = pdbtool_merge_collect_files(dir, recursive, files);
+  if (ok && files->len > 0)
+    {
+      workers = g_thread_pool_new(pdbtool_merge_file_worker, NULL, MAX(sysconf(_SC_NPROCESSORS_ONLN), 1),
+                                  TRUE, NULL);
+      for (i = 0; i < files->len; i++)
+        g_thread_pool_push(workers, g_ptr_array_index(files, i), NULL);
+
+      /* waits for all the queued files to be converted */
+      g_thread_pool_free(workers, FALSE, TRUE);
+
+      for (i = 0; i < files->len && ok; i++)
+        {
+          PdbToolMergeFile *file = (PdbToolMergeFile *) g_ptr_array_index(files, i);
+
+          ok = file->success;
+          g_string_append_len(merged, file->merged->str, file->merged->len);
+        }
+    }
+  g_ptr_array_free(files, TRUE);
+  return ok;
 }
 
 static gint
@@ -779,28 +779,29 @@ r_free_pnode(RNode *node, void (*free_fn)(gpointer data))
  **************************************************************/
 
 
-gint
-r_node_cmp(const void *ap, const void *bp)
-{
-  RNode *a = *(RNode * const *) ap;
-  RNode *b = *(RNode * const *) bp;
-
-  if (a->key[0] < b->key[0])
-    return -1;
-  else if (a->key[0] > b->key[0])
-    return 1;
-  return 0;
-}
-
+/* children are kept ordered by their first character, find the position
+ * of a new child with a binary search instead of resorting the array on
+ * every insert, which dominated loading large pattern databases */
 void
 r_add_child(RNode *parent, RNode *child)
 {
-  parent->children = g_realloc(parent->children, (sizeof(RNode *) * (parent->num_children + 1)));
+  gint l = 0, u = parent->num_children, idx;
+  gchar k = child->key[0];
 
-  //FIXME: we could do a simple sorted insert without resorting always
-  parent->children[(parent->num_children)++] = child;
+  while (l < u)
+    {
+      idx = (l + u) / 2;
 
-  qsort(&(parent->children[0]), parent->num_children, sizeof(RNode *), r_node_cmp);
+      if (parent->children[idx]->key[0] > k)
+        u = idx;
+      else
+        l = idx + 1;
+    }
+
+  parent->children = g_realloc(parent->children, (sizeof(RNode *) * (parent->num_children + 1)));
+  memmove(&parent->children[l + 1], &parent->children[l], (parent->num_children - l) * sizeof(RNode *));
+  parent->children[l] = child;
+  parent->num_children++;
 }
 
 static inline void
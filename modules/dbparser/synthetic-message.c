@@ -113,6 +113,22 @@ synthetic_message_add_value_template(SyntheticMessage *self, const gchar *name,
   g_ptr_array_add(self->values, log_template_ref(value));
 }
 
+/* replaces the value at @index, @index == number of values appends a new one */
+void
+synthetic_message_set_value_template(SyntheticMessage *self, gint index, const gchar *name, LogTemplate *value)
+{
+  if (!self->values || index >= self->values->len)
+    {
+      g_assert(!self->values ? index == 0 : index == self->values->len);
+      synthetic_message_add_value_template(self, name, value);
+      return;
+    }
+
+  log_template_set_name(value, name);
+  log_template_unref(g_ptr_array_index(self->values, index));
+  g_ptr_array_index(self->values, index) = log_template_ref(value);
+}
+
 void
 synthetic_message_apply(SyntheticMessage *self, CorrellationContext *context, LogMessage *msg, GString *buffer)
 {
@@ -55,6 +55,7 @@ void synthetic_message_set_inherit_properties_string(SyntheticMessage *self, con
 gboolean synthetic_message_set_inherit_mode_string(SyntheticMessage *self, const gchar *inherit_mode_name,
                                                    GError **error);
 void synthetic_message_add_value_template(SyntheticMessage *self, const gchar *name, LogTemplate *value);
+void synthetic_message_set_value_template(SyntheticMessage *self, gint index, const gchar *name, LogTemplate *value);
 void synthetic_message_add_tag(SyntheticMessage *self, const gchar *text);
 void synthetic_message_init(SyntheticMessage *self);
 void synthetic_message_deinit(SyntheticMessage *self);
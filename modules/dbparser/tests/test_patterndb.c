@@ -362,6 +362,58 @@ Test(pattern_db, test_correllation_rule_with_action_on_timeout)
   g_free(filename);
 }
 
+static GlobalConfig *
+_replace_configuration(void)
+{
+  GlobalConfig *old_configuration = configuration;
+
+  configuration = cfg_new_snippet();
+  cfg_load_module(configuration, "basicfuncs");
+  cfg_load_module(configuration, "syslogformat");
+  return old_configuration;
+}
+
+Test(pattern_db, test_ruleset_compiled_against_a_new_configuration)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+  GlobalConfig *old_configuration;
+
+  /* the context references a rule compiled against the configuration being freed */
+  _feed_message_to_correllation_state(patterndb, "prog2", "correllated-message-with-action-on-timeout", NULL, NULL);
+  old_configuration = _replace_configuration();
+  cr_assert(pattern_db_compile_ruleset(patterndb, configuration), "Error compiling ruleset [[[%s]]]", filename);
+  cfg_free(old_configuration);
+
+  _advance_time(patterndb, 60);
+  assert_output_message_nvpair_equals(1, "MESSAGE", "generated-message-on-timeout");
+
+  assert_msg_matches_and_output_message_nvpair_equals(patterndb, "correllated-message-with-action-on-match", 1,
+                                                      "context-id", "999");
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
+Test(pattern_db, test_reloaded_ruleset_keeps_correllation_contexts)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+  GlobalConfig *old_configuration;
+
+  _feed_message_to_correllation_state(patterndb, "prog2", "correllated-message-with-action-on-timeout", NULL, NULL);
+  old_configuration = _replace_configuration();
+  cr_assert(pattern_db_reload_ruleset(patterndb, configuration, filename), "Error reloading ruleset [[[%s]]]",
+            filename);
+  cfg_free(old_configuration);
+
+  _advance_time(patterndb, 60);
+  assert_output_message_nvpair_equals(1, "MESSAGE", "generated-message-on-timeout");
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
 Test(pattern_db, test_correllation_rule_with_action_condition)
 {
   gchar *filename;
@@ -670,6 +722,22 @@ Test(pattern_db, test_tag_outside_of_rule_skeleton)
   g_free(filename);
 }
 
+Test(pattern_db, test_invalid_value_template_fails_loading)
+{
+  PatternDB *patterndb = pattern_db_new();
+
+  char *filename;
+  g_file_open_tmp("patterndbXXXXXX.xml", &filename, NULL);
+  g_file_set_contents(filename, pdb_invalid_value_template_skeleton, strlen(pdb_invalid_value_template_skeleton),
+                      NULL);
+
+  cr_assert_not(pattern_db_reload_ruleset(patterndb, configuration, filename),
+                "successfully loaded a patterndb file with an invalid template");
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
 void setup(void)
 {
   app_startup();
@@ -535,4 +535,22 @@
  </ruleset>\
 </patterndb>"
 
+#define pdb_invalid_value_template_skeleton "<patterndb version='4' pub_date='2010-02-22'>\
+ <ruleset name='testset' id='1'>\
+  <patterns>\
+   <pattern>prog1</pattern>\
+  </patterns>\
+  <rules>\
+   <rule provider='test' id='11' class='system'>\
+    <patterns>\
+     <pattern>simple-message</pattern>\
+    </patterns>\
+    <values>\
+     <value name='n1'>$(no-such-template-function)</value>\
+    </values>\
+   </rule>\
+  </rules>\
+ </ruleset>\
+</patterndb>"
+
 #endif
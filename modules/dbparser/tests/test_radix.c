@@ -219,6 +219,37 @@ Test(dbparser, test_literals, .init = test_setup, .fini = test_teardown)
   r_free_node(root, NULL);
 }
 
+Test(dbparser, test_children_are_found_regardless_of_insertion_order, .init = test_setup, .fini = test_teardown)
+{
+  RNode *root = r_new_node("", NULL);
+  gchar key[3] = { 0, 'x', 0 };
+  gint c;
+
+  /* every first character in an order that is neither ascending nor
+   * descending, including bytes that are negative as a signed char */
+  for (c = 1; c < 256; c++)
+    {
+      key[0] = (c * 97) % 255 + 1;
+      if (key[0] != '@')
+        insert_node_with_value(root, key, GINT_TO_POINTER(c));
+    }
+
+  for (c = 1; c < 256; c++)
+    {
+      RNode *node;
+
+      key[0] = (c * 97) % 255 + 1;
+      if (key[0] == '@')
+        continue;
+
+      node = r_find_node(root, key, 2, NULL);
+      cr_assert(node, "node not found, first character=%d", (guchar) key[0]);
+      cr_expect_eq(node->value, GINT_TO_POINTER(c), "unexpected node found, first character=%d", (guchar) key[0]);
+    }
+
+  r_free_node(root, NULL);
+}
+
 Test(dbparser, test_parsers, .init = test_setup, .fini = test_teardown)
 {
   RNode *root = r_new_node("", NULL);
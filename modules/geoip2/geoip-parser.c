@@ -22,18 +22,74 @@
 
 #include "geoip-parser.h"
 #include "maxminddb-helper.h"
+#include "string-list.h"
+#include "tls-support.h"
+
+#include <arpa/inet.h>
 
 typedef struct _GeoIPParser GeoIPParser;
 
+typedef struct _GeoIPField
+{
+  NVHandle handle;
+  gchar **path;
+} GeoIPField;
+
 struct _GeoIPParser
 {
   LogParser super;
   MMDB_s *database;
+  /* identifies the opened database in the per-thread lookup cache */
+  guint32 database_id;
 
   gchar *database_path;
   gchar *prefix;
+  GList *fields;
+  GArray *projected_fields;
 };
 
+/*
+ * Per-thread cache of database lookups, keyed by the binary address.
+ * Entries belonging to different parser instances are told apart by
+ * database_id, which is unique for every opened database, so entries of a
+ * database closed by a reload are never matched again and age out of the
+ * cache.  The cache is 4-way set associative with LRU replacement within
+ * a set.
+ */
+#define GEOIP_CACHE_SETS 64
+#define GEOIP_CACHE_WAYS 4
+
+typedef struct _GeoIPCacheEntry
+{
+  guint32 database_id;
+  guint32 last_used;
+  gint family;
+  guint8 addr[16];
+  gboolean found;
+  MMDB_entry_s entry;
+} GeoIPCacheEntry;
+
+TLS_BLOCK_START
+{
+  GeoIPCacheEntry geoip_cache[GEOIP_CACHE_SETS][GEOIP_CACHE_WAYS];
+  guint32 geoip_cache_clock;
+}
+TLS_BLOCK_END;
+
+#define geoip_cache __tls_deref(geoip_cache)
+#define geoip_cache_clock __tls_deref(geoip_cache_clock)
+
+static gint geoip_last_database_id;
+
+void
+geoip_parser_set_fields(LogParser *s, GList *fields)
+{
+  GeoIPParser *self = (GeoIPParser *) s;
+
+  string_list_free(self->fields);
+  self->fields = fields;
+}
+
 void
 geoip_parser_set_prefix(LogParser *s, const gchar *prefix)
 {
@@ -66,8 +122,43 @@ mmdb_problem_to_error(const int _gai_error, const int _mmdb_error, gchar *where)
               evt_tag_str("where", where));
 }
 
+static GeoIPCacheEntry *
+_cache_lookup(GeoIPParser *self, gint family, const guint8 *addr, gsize addr_len)
+{
+  guint32 hash = family;
+
+  for (gsize i = 0; i < addr_len; i += 4)
+    hash ^= *(guint32 *) &addr[i];
+  hash = (hash * 2654435761U) >> 16;
+
+  GeoIPCacheEntry *set = geoip_cache[hash % GEOIP_CACHE_SETS];
+  GeoIPCacheEntry *victim = &set[0];
+
+  geoip_cache_clock++;
+  for (gint i = 0; i < GEOIP_CACHE_WAYS; i++)
+    {
+      GeoIPCacheEntry *entry = &set[i];
+
+      if (entry->database_id == self->database_id && entry->family == family &&
+          memcmp(entry->addr, addr, addr_len) == 0)
+        {
+          entry->last_used = geoip_cache_clock;
+          return entry;
+        }
+      if (entry->last_used < victim->last_used)
+        victim = entry;
+    }
+
+  /* miss: hand out the least recently used entry, the caller fills it */
+  victim->database_id = 0;
+  victim->family = family;
+  memcpy(victim->addr, addr, addr_len);
+  victim->last_used = geoip_cache_clock;
+  return victim;
+}
+
 static gboolean
-_mmdb_load_entry_data_list(GeoIPParser *self, const gchar *input, MMDB_entry_data_list_s **entry_data_list)
+_mmdb_lookup_entry_by_string(GeoIPParser *self, const gchar *input, MMDB_entry_s *entry)
 {
   int _gai_error, mmdb_error;
   MMDB_lookup_result_s result =
@@ -78,15 +169,132 @@ _mmdb_load_entry_data_list(GeoIPParser *self, const gchar *input, MMDB_entry_dat
       mmdb_problem_to_error(_gai_error, mmdb_error, "lookup");
       return FALSE;
     }
+  *entry = result.entry;
+  return TRUE;
+}
+
+/*
+ * Addresses are parsed with inet_pton() and looked up in binary form,
+ * which avoids the getaddrinfo() call of MMDB_lookup_string() and gives
+ * us the cache key at the same time.
+ */
+static gboolean
+_mmdb_lookup_entry(GeoIPParser *self, const gchar *input, MMDB_entry_s *entry)
+{
+  union
+  {
+    struct sockaddr sa;
+    struct sockaddr_in sin;
+    struct sockaddr_in6 sin6;
+  } sa;
+  const guint8 *addr;
+  gsize addr_len;
+
+  memset(&sa, 0, sizeof(sa));
+  if (inet_pton(AF_INET, input, &sa.sin.sin_addr) == 1)
+    {
+      sa.sin.sin_family = AF_INET;
+      addr = (const guint8 *) &sa.sin.sin_addr;
+      addr_len = sizeof(sa.sin.sin_addr);
+    }
+  else if (inet_pton(AF_INET6, input, &sa.sin6.sin6_addr) == 1)
+    {
+      sa.sin6.sin6_family = AF_INET6;
+      addr = (const guint8 *) &sa.sin6.sin6_addr;
+      addr_len = sizeof(sa.sin6.sin6_addr);
+    }
+  else
+    return _mmdb_lookup_entry_by_string(self, input, entry);
+
+  GeoIPCacheEntry *cached = _cache_lookup(self, sa.sa.sa_family, addr, addr_len);
+  if (cached->database_id != self->database_id)
+    {
+      int mmdb_error;
+      MMDB_lookup_result_s result = MMDB_lookup_sockaddr(self->database, &sa.sa, &mmdb_error);
+
+      if (MMDB_SUCCESS != mmdb_error)
+        {
+          mmdb_problem_to_error(0, mmdb_error, "lookup");
+          return FALSE;
+        }
+      cached->database_id = self->database_id;
+      cached->found = result.found_entry;
+      cached->entry = result.entry;
+    }
+
+  if (!cached->found)
+    {
+      msg_debug("GeoIP2: address not found in database",
+                evt_tag_str("address", input));
+      return FALSE;
+    }
+  *entry = cached->entry;
+  return TRUE;
+}
+
+static void
+_dump_entry_into_msg(GeoIPParser *self, LogMessage *msg, MMDB_entry_s *entry)
+{
+  MMDB_entry_data_list_s *entry_data_list;
+  gint mmdb_error = MMDB_get_entry_data_list(entry, &entry_data_list);
 
-  mmdb_error = MMDB_get_entry_data_list(&result.entry, entry_data_list);
   if (MMDB_SUCCESS != mmdb_error)
     {
       msg_debug("GeoIP2: MMDB_get_entry_data_list",
                 evt_tag_str("error", MMDB_strerror(mmdb_error)));
+      return;
+    }
+
+  GArray *path = g_array_new(TRUE, FALSE, sizeof(gchar *));
+  g_array_append_val(path, self->prefix);
+
+  gint status;
+  dump_geodata_into_msg(msg, entry_data_list, path, &status);
+
+  MMDB_free_entry_data_list(entry_data_list);
+  g_array_free(path, TRUE);
+}
+
+static gboolean
+_is_scalar_entry_data(MMDB_entry_data_s *entry_data)
+{
+  switch (entry_data->type)
+    {
+    case MMDB_DATA_TYPE_MAP:
+    case MMDB_DATA_TYPE_ARRAY:
+    case MMDB_DATA_TYPE_BYTES:
+    case MMDB_DATA_TYPE_UINT128:
       return FALSE;
+    default:
+      return TRUE;
+    }
+}
+
+static void
+_extract_projected_fields_into_msg(GeoIPParser *self, LogMessage *msg, MMDB_entry_s *entry)
+{
+  GString *value = scratch_buffers_alloc();
+
+  for (gint i = 0; i < self->projected_fields->len; i++)
+    {
+      GeoIPField *field = &g_array_index(self->projected_fields, GeoIPField, i);
+      MMDB_entry_data_s entry_data;
+
+      gint mmdb_error = MMDB_aget_value(entry, &entry_data, (const char *const *const) field->path);
+      if (MMDB_SUCCESS != mmdb_error || !entry_data.has_data)
+        continue;
+
+      if (!_is_scalar_entry_data(&entry_data))
+        {
+          msg_debug("GeoIP2: field does not refer to a scalar value, skipping",
+                    evt_tag_str("field", log_msg_get_value_name(field->handle, NULL)));
+          continue;
+        }
+
+      g_string_truncate(value, 0);
+      append_mmdb_entry_data_to_gstring(value, &entry_data);
+      log_msg_set_value(msg, field->handle, value->str, value->len);
     }
-  return TRUE;
 }
 
 static gboolean
@@ -101,18 +309,14 @@ maxminddb_parser_process(LogParser *s, LogMessage **pmsg,
             evt_tag_str ("prefix", self->prefix),
             evt_tag_printf("msg", "%p", *pmsg));
 
-  MMDB_entry_data_list_s *entry_data_list;
-  if (!_mmdb_load_entry_data_list(self, input, &entry_data_list))
+  MMDB_entry_s entry;
+  if (!_mmdb_lookup_entry(self, input, &entry))
     return TRUE;
 
-  GArray *path = g_array_new(TRUE, FALSE, sizeof(gchar *));
-  g_array_append_val(path, self->prefix);
-
-  gint status;
-  dump_geodata_into_msg(msg, entry_data_list, path, &status);
-
-  MMDB_free_entry_data_list(entry_data_list);
-  g_array_free(path, TRUE);
+  if (self->projected_fields)
+    _extract_projected_fields_into_msg(self, msg, &entry);
+  else
+    _dump_entry_into_msg(self, msg, &entry);
 
   return TRUE;
 }
@@ -127,11 +331,47 @@ maxminddb_parser_clone(LogPipe *s)
 
   geoip_parser_set_database_path(&cloned->super, self->database_path);
   geoip_parser_set_prefix(&cloned->super, self->prefix);
+  geoip_parser_set_fields(&cloned->super, string_list_clone(self->fields));
   log_parser_set_template(&cloned->super, log_template_ref(self->super.template));
 
   return &cloned->super.super;
 }
 
+static void
+_free_projected_fields(GeoIPParser *self)
+{
+  if (!self->projected_fields)
+    return;
+
+  for (gint i = 0; i < self->projected_fields->len; i++)
+    g_strfreev(g_array_index(self->projected_fields, GeoIPField, i).path);
+  g_array_free(self->projected_fields, TRUE);
+  self->projected_fields = NULL;
+}
+
+static void
+_init_projected_fields(GeoIPParser *self)
+{
+  _free_projected_fields(self);
+  if (!self->fields)
+    return;
+
+  self->projected_fields = g_array_new(FALSE, FALSE, sizeof(GeoIPField));
+  for (GList *l = self->fields; l; l = l->next)
+    {
+      const gchar *field_name = (const gchar *) l->data;
+      gchar *name = g_strdup_printf("%s.%s", self->prefix, field_name);
+      GeoIPField field =
+      {
+        .handle = log_msg_get_value_handle(name),
+        .path = g_strsplit(field_name, ".", -1),
+      };
+
+      g_array_append_val(self->projected_fields, field);
+      g_free(name);
+    }
+}
+
 static void
 maxminddb_parser_free(LogPipe *s)
 {
@@ -139,6 +379,8 @@ maxminddb_parser_free(LogPipe *s)
 
   g_free(self->database_path);
   g_free(self->prefix);
+  string_list_free(self->fields);
+  _free_projected_fields(self);
   if (self->database)
     {
       MMDB_close(self->database);
@@ -170,8 +412,10 @@ maxminddb_parser_init(LogPipe *s)
 
   if (!mmdb_open_database(self->database_path, self->database))
     return FALSE;
+  self->database_id = (guint32) g_atomic_int_add(&geoip_last_database_id, 1) + 1;
 
   remove_trailing_dot(self->prefix);
+  _init_projected_fields(self);
 
   return log_parser_init_method(s);
 }
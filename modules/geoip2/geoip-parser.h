@@ -32,5 +32,6 @@ LogParser *maxminddb_parser_new(GlobalConfig *cfg);
 void mmdb_problem_to_error(const int _gai_error, const int mmdb_error, gchar *where);
 void geoip_parser_set_database_path(LogParser *s, const gchar *database);
 void geoip_parser_set_prefix(LogParser *s, const gchar *prefix);
+void geoip_parser_set_fields(LogParser *s, GList *fields);
 
 #endif
@@ -22,6 +22,7 @@
 #include "geoip-parser.h"
 #include "apphook.h"
 #include "msg_parse_lib.h"
+#include "string-list.h"
 
 #define geoip2_parser_testcase_begin(func, args)             \
   do                                                            \
@@ -118,11 +119,27 @@ test_geoip_parser_uses_template_to_parse_input(void)
   log_msg_unref(msg);
 }
 
+static void
+test_geoip_parser_extracts_only_the_configured_fields(void)
+{
+  LogMessage *msg;
+  const gchar *fields[] = { "country.iso_code", "location.latitude", NULL };
+
+  geoip_parser_set_fields(geoip_parser, string_array_to_list(fields));
+
+  msg = parse_geoip_into_log_message("217.20.130.99");
+  assert_log_message_value(msg, log_msg_get_value_handle(".geoip2.country.iso_code"), "HU");
+  assert_log_message_value(msg, log_msg_get_value_handle(".geoip2.location.latitude"), "47.513900");
+  assert_log_message_value(msg, log_msg_get_value_handle(".geoip2.location.longitude"), NULL);
+  log_msg_unref(msg);
+}
+
 static void
 test_geoip_parser(void)
 {
   KV_PARSER_TESTCASE(test_geoip_parser_basics);
   KV_PARSER_TESTCASE(test_geoip_parser_uses_template_to_parse_input);
+  KV_PARSER_TESTCASE(test_geoip_parser_extracts_only_the_configured_fields);
 }
 
 int
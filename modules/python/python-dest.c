@@ -35,6 +35,12 @@
 #include "str-utils.h"
 #include "messages.h"
 
+typedef struct
+{
+  LogMessage *msg;
+  gint32 seq_num;
+} PythonDestBatchEntry;
+
 typedef struct
 {
   LogThreadedDestDriver super;
@@ -46,12 +52,16 @@ typedef struct
   GHashTable *options;
   ValuePairs *vp;
 
+  /* messages collected for send_batch(), see python_dd_insert() */
+  GArray *batch;
+
   struct
   {
     PyObject *class;
     PyObject *instance;
     PyObject *is_opened;
     PyObject *send;
+    PyObject *send_batch;
     PyObject *flush;
     PyObject *log_template_options;
     PyObject *seqnum;
@@ -254,6 +264,20 @@ _py_invoke_send(PythonDestDriver *self, PyObject *dict)
   return result;
 }
 
+static LogThreadedResult
+_py_invoke_send_batch(PythonDestDriver *self, PyObject *list)
+{
+  PyObject *ret;
+  ret = _py_invoke_function(self->py.send_batch, list, self->class, self->super.super.super.id);
+
+  if (!ret)
+    return LTR_ERROR;
+
+  LogThreadedResult result = pyobject_to_worker_insert_result(ret);
+  Py_XDECREF(ret);
+  return result;
+}
+
 static gboolean
 _py_invoke_init(PythonDestDriver *self)
 {
@@ -338,9 +362,10 @@ _py_init_bindings(PythonDestDriver *self)
   self->py.is_opened = _py_get_attr_or_null(self->py.instance, "is_opened");
   self->py.flush = _py_get_attr_or_null(self->py.instance, "flush");
   self->py.send = _py_get_attr_or_null(self->py.instance, "send");
-  if (!self->py.send)
+  self->py.send_batch = _py_get_attr_or_null(self->py.instance, "send_batch");
+  if (!self->py.send && !self->py.send_batch)
     {
-      msg_error("Error initializing Python destination, class does not have a send() method",
+      msg_error("Error initializing Python destination, class does not have a send() or send_batch() method",
                 evt_tag_str("driver", self->super.super.super.id),
                 evt_tag_str("class", self->class));
       return FALSE;
@@ -351,6 +376,7 @@ _py_init_bindings(PythonDestDriver *self)
   g_ptr_array_add(self->py._refs_to_clean, self->py.is_opened);
   g_ptr_array_add(self->py._refs_to_clean, self->py.flush);
   g_ptr_array_add(self->py._refs_to_clean, self->py.send);
+  g_ptr_array_add(self->py._refs_to_clean, self->py.send_batch);
   g_ptr_array_add(self->py._refs_to_clean, self->py.log_template_options);
   g_ptr_array_add(self->py._refs_to_clean, self->py.seqnum);
 
@@ -385,14 +411,14 @@ _py_init_object(PythonDestDriver *self)
 }
 
 static gboolean
-_py_construct_message(PythonDestDriver *self, LogMessage *msg, PyObject **msg_object)
+_py_construct_message(PythonDestDriver *self, LogMessage *msg, gint32 seq_num, PyObject **msg_object)
 {
   gboolean success;
   *msg_object = NULL;
 
   if (self->vp)
     {
-      success = py_value_pairs_apply(self->vp, &self->template_options, self->super.worker.instance.seq_num, msg, msg_object);
+      success = py_value_pairs_apply(self->vp, &self->template_options, seq_num, msg, msg_object);
       if (!success && (self->template_options.on_error & ON_ERROR_DROP_MESSAGE))
         return FALSE;
     }
@@ -405,26 +431,31 @@ _py_construct_message(PythonDestDriver *self, LogMessage *msg, PyObject **msg_ob
 }
 
 
+static gboolean
+_py_ensure_opened(PythonDestDriver *self)
+{
+  if (_py_invoke_is_opened(self))
+    return TRUE;
+
+  _py_invoke_open(self);
+  return _py_invoke_is_opened(self);
+}
+
 static LogThreadedResult
-python_dd_insert(LogThreadedDestDriver *d, LogMessage *msg)
+_insert_single(PythonDestDriver *self, LogMessage *msg)
 {
-  PythonDestDriver *self = (PythonDestDriver *)d;
   LogThreadedResult result = LTR_ERROR;
   PyObject *msg_object;
   PyGILState_STATE gstate;
 
   gstate = PyGILState_Ensure();
-  if (!_py_invoke_is_opened(self))
+  if (!_py_ensure_opened(self))
     {
-      _py_invoke_open(self);
-      if (!_py_invoke_is_opened(self))
-        {
-          result = LTR_NOT_CONNECTED;
-          goto exit;
-        }
+      result = LTR_NOT_CONNECTED;
+      goto exit;
     }
 
-  if (!_py_construct_message(self, msg, &msg_object))
+  if (!_py_construct_message(self, msg, self->super.worker.instance.seq_num, &msg_object))
     goto exit;
 
   result =_py_invoke_send(self, msg_object);
@@ -435,6 +466,120 @@ exit:
   return result;
 }
 
+/* If the Python class implements send_batch(), messages are only
+ * collected here, without touching the interpreter.  The Python objects
+ * are constructed and passed to send_batch() as a list in
+ * python_dd_flush(), so the GIL is taken once per batch instead of once
+ * per message. */
+static LogThreadedResult
+_insert_batch(PythonDestDriver *self, LogMessage *msg)
+{
+  PythonDestBatchEntry entry =
+  {
+    .msg = log_msg_ref(msg),
+    .seq_num = self->super.worker.instance.seq_num,
+  };
+
+  g_array_append_val(self->batch, entry);
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+python_dd_insert(LogThreadedDestDriver *d, LogMessage *msg)
+{
+  PythonDestDriver *self = (PythonDestDriver *)d;
+
+  if (self->py.send_batch)
+    return _insert_batch(self, msg);
+  return _insert_single(self, msg);
+}
+
+static void
+_clear_batch(PythonDestDriver *self)
+{
+  for (guint i = 0; i < self->batch->len; i++)
+    log_msg_unref(g_array_index(self->batch, PythonDestBatchEntry, i).msg);
+  g_array_set_size(self->batch, 0);
+}
+
+/* Messages that cannot be formatted are dropped, the rest of the batch is
+ * still sent.  The number of dropped messages is returned in @dropped.
+ * Returns NULL if the list itself could not be built. */
+static PyObject *
+_py_construct_batch(PythonDestDriver *self, gint *dropped)
+{
+  PyObject *list = PyList_New(0);
+
+  *dropped = 0;
+  if (!list)
+    return NULL;
+
+  for (guint i = 0; i < self->batch->len; i++)
+    {
+      PythonDestBatchEntry *entry = &g_array_index(self->batch, PythonDestBatchEntry, i);
+      PyObject *msg_object;
+
+      if (!_py_construct_message(self, entry->msg, entry->seq_num, &msg_object) || !msg_object)
+        {
+          msg_error("Error formatting message for Python destination, dropping message from the batch",
+                    evt_tag_str("driver", self->super.super.super.id),
+                    evt_tag_str("class", self->class));
+          (*dropped)++;
+          continue;
+        }
+
+      gint append_result = PyList_Append(list, msg_object);
+      Py_DECREF(msg_object);
+      if (append_result < 0)
+        {
+          gchar buf[256];
+
+          msg_error("Error constructing the message list for send_batch()",
+                    evt_tag_str("driver", self->super.super.super.id),
+                    evt_tag_str("class", self->class),
+                    evt_tag_str("exception", _py_format_exception_text(buf, sizeof(buf))));
+          _py_finish_exception_handling();
+          Py_DECREF(list);
+          return NULL;
+        }
+    }
+  return list;
+}
+
+/* NOTE: the result of send_batch() applies to the whole batch, the
+ * messages are acked, dropped or rewound together, except for the ones
+ * that could not be formatted, which are dropped upon success.  Upon
+ * rewind they are inserted (and thus collected) again, so the batch can
+ * always be cleared here. */
+static LogThreadedResult
+_py_flush_batch(PythonDestDriver *self)
+{
+  LogThreadedResult result = LTR_NOT_CONNECTED;
+  PyObject *list;
+  gint dropped;
+
+  if (self->batch->len == 0)
+    return LTR_SUCCESS;
+
+  if (_py_ensure_opened(self))
+    {
+      list = _py_construct_batch(self, &dropped);
+      if (!list)
+        result = LTR_ERROR;
+      else if (PyList_Size(list) == 0)
+        result = LTR_SUCCESS;
+      else
+        result = _py_invoke_send_batch(self, list);
+      Py_XDECREF(list);
+
+      if (result == LTR_SUCCESS && dropped > 0)
+        log_threaded_dest_worker_drop_messages(&self->super.worker.instance, dropped);
+    }
+
+  _clear_batch(self);
+  return result;
+}
+
 static void
 python_dd_open(PythonDestDriver *self)
 {
@@ -454,7 +599,9 @@ python_dd_flush(LogThreadedDestDriver *s)
   PyGILState_STATE gstate;
 
   gstate = PyGILState_Ensure();
-  LogThreadedResult result = _py_invoke_flush(self);
+  LogThreadedResult result = _py_flush_batch(self);
+  if (result == LTR_SUCCESS)
+    result = _py_invoke_flush(self);
   PyGILState_Release(gstate);
   return result;
 };
@@ -560,6 +707,9 @@ python_dd_free(LogPipe *d)
 
   string_list_free(self->loaders);
 
+  _clear_batch(self);
+  g_array_free(self->batch, TRUE);
+
   log_threaded_dest_driver_free(d);
 }
 
@@ -585,6 +735,7 @@ python_dd_new(GlobalConfig *cfg)
   self->super.stats_source = SCS_PYTHON;
 
   self->options = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  self->batch = g_array_new(FALSE, FALSE, sizeof(PythonDestBatchEntry));
 
   return (LogDriver *)self;
 }
@@ -97,3 +97,13 @@ class DummyBatchDestination(object):
         print("flushing: " + ",".join(self.bulk))
         self.bulk = list()
         return self.SUCCESS
+
+class DummySendBatchDestination(object):
+    """If send_batch() is implemented, it is called with a list of messages
+    instead of calling send() for each message.  The batch is sized by the
+    batch-lines() and batch-timeout() options and the return value applies
+    to the entire batch, similarly to the flush() method."""
+
+    def send_batch(self, msgs):
+        print("sending batch: " + ",".join([msg["MSG"].decode() for msg in msgs]))
+        return self.SUCCESS
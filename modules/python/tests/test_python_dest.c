@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "python-dest.c"
+#include "python-logtemplate.h"
+#include "apphook.h"
+#include "logqueue-fifo.h"
+
+#include <criterion/criterion.h>
+
+static const gchar *batch_dest_code =
+  "class BatchDest(object):\n"
+  "    batches = []\n"
+  "    def send_batch(self, msgs):\n"
+  "        BatchDest.batches.append([int(msg['n']) for msg in msgs])\n"
+  "        return True\n";
+
+static PyObject *_python_main_dict;
+
+static void
+_py_init_interpreter(void)
+{
+  Py_Initialize();
+  py_init_argv();
+
+  PyEval_InitThreads();
+  py_log_message_init();
+  py_log_template_init();
+  py_log_template_options_init();
+  py_integer_pointer_init();
+  PyEval_SaveThread();
+}
+
+static void
+_define_batch_dest_class(void)
+{
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  PyObject *result;
+
+  _python_main_dict = PyModule_GetDict(PyImport_AddModule("__main__"));
+  result = PyRun_String(batch_dest_code, Py_file_input, _python_main_dict, _python_main_dict);
+  cr_assert_not_null(result, "Error defining the Python destination class");
+  Py_DECREF(result);
+  PyGILState_Release(gstate);
+}
+
+static gchar *
+_format_sent_batches(void)
+{
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  PyObject *batches = PyRun_String("repr(BatchDest.batches)", Py_eval_input, _python_main_dict, _python_main_dict);
+  gchar *result = g_strdup(_py_get_string_as_string(batches));
+
+  Py_DECREF(batches);
+  PyGILState_Release(gstate);
+  return result;
+}
+
+static PythonDestDriver *
+_create_batch_dest(void)
+{
+  PythonDestDriver *self = (PythonDestDriver *) python_dd_new(configuration);
+  LogTemplate *template = log_template_new(configuration, NULL);
+  ValuePairs *vp = value_pairs_new();
+  PyGILState_STATE gstate;
+
+  cr_assert(log_template_compile(template, "$MSG", NULL));
+  cr_assert(log_template_set_type_hint(template, "int", NULL));
+  value_pairs_add_pair(vp, "n", template);
+  log_template_unref(template);
+
+  python_dd_set_class(&self->super.super.super, "__main__.BatchDest");
+  python_dd_set_value_pairs(&self->super.super.super, vp);
+  log_template_options_init(&self->template_options, configuration);
+
+  gstate = PyGILState_Ensure();
+  cr_assert(_py_init_bindings(self));
+  PyGILState_Release(gstate);
+
+  /* the worker acks and drops messages from the backlog of its queue */
+  self->super.worker.instance.queue = log_queue_fifo_new(100, NULL);
+  log_queue_set_use_backlog(self->super.worker.instance.queue, TRUE);
+  return self;
+}
+
+static void
+_insert_message(PythonDestDriver *self, const gchar *text)
+{
+  LogThreadedDestWorker *worker = &self->super.worker.instance;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = log_msg_new_empty();
+
+  log_msg_set_value(msg, LM_V_MESSAGE, text, -1);
+  log_queue_push_tail(worker->queue, msg, &path_options);
+
+  msg = log_queue_pop_head(worker->queue, &path_options);
+  cr_assert_eq(python_dd_insert(&self->super, msg), LTR_QUEUED);
+  worker->batch_size++;
+  log_msg_unref(msg);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  _py_init_interpreter();
+  _define_batch_dest_class();
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(python_dest, .init = setup, .fini = teardown);
+
+Test(python_dest, test_messages_are_sent_in_one_batch)
+{
+  PythonDestDriver *self = _create_batch_dest();
+  gchar *batches;
+
+  _insert_message(self, "1");
+  _insert_message(self, "2");
+  _insert_message(self, "3");
+
+  cr_assert_eq(python_dd_flush(&self->super), LTR_SUCCESS);
+  cr_assert_eq(self->super.worker.instance.batch_size, 3);
+  cr_assert_eq(self->batch->len, 0);
+
+  batches = _format_sent_batches();
+  cr_assert_str_eq(batches, "[[1, 2, 3]]");
+  g_free(batches);
+
+  log_pipe_unref(&self->super.super.super.super);
+}
+
+Test(python_dest, test_messages_failing_to_format_are_dropped_from_the_batch)
+{
+  PythonDestDriver *self = _create_batch_dest();
+  gchar *batches;
+
+  _insert_message(self, "1");
+  _insert_message(self, "not-a-number");
+  _insert_message(self, "3");
+
+  cr_assert_eq(python_dd_flush(&self->super), LTR_SUCCESS);
+  /* the dropped message is no longer part of the batch to be acked */
+  cr_assert_eq(self->super.worker.instance.batch_size, 2);
+  cr_assert_eq(self->batch->len, 0);
+
+  batches = _format_sent_batches();
+  cr_assert_str_eq(batches, "[[1, 3]]");
+  g_free(batches);
+
+  log_pipe_unref(&self->super.super.super.super);
+}
+
+Test(python_dest, test_batch_is_not_sent_if_no_message_could_be_formatted)
+{
+  PythonDestDriver *self = _create_batch_dest();
+  gchar *batches;
+
+  _insert_message(self, "foo");
+  _insert_message(self, "bar");
+
+  cr_assert_eq(python_dd_flush(&self->super), LTR_SUCCESS);
+  cr_assert_eq(self->super.worker.instance.batch_size, 0);
+
+  batches = _format_sent_batches();
+  cr_assert_str_eq(batches, "[]");
+  g_free(batches);
+
+  log_pipe_unref(&self->super.super.super.super);
+}
@@ -53,6 +53,10 @@ typedef struct
   GString *param2_str;
 
   redisContext *c;
+
+  /* number of commands appended to the output buffer of the context
+   * (redisAppendCommandArgv) whose replies have not been read yet */
+  gint pending_replies;
 } RedisDriver;
 
 /*
@@ -225,26 +229,28 @@ redis_dd_disconnect(LogThreadedDestDriver *s)
  * Worker thread
  */
 
-static LogThreadedResult
-redis_worker_insert(LogThreadedDestDriver *s, LogMessage *msg)
+static gboolean
+_is_pipelining_enabled(RedisDriver *self)
 {
-  RedisDriver *self = (RedisDriver *)s;
-  redisReply *reply;
-  const char *argv[5];
-  size_t argvlen[5];
-  int argc = 2;
-
-  if (!redis_dd_connect(self))
-    return LTR_NOT_CONNECTED;
+  return self->super.batch_lines > 1;
+}
 
-  if (self->c->err)
-    return LTR_ERROR;
+/* Replies of a pipelined batch can only be matched to the commands in
+ * order, so once something went wrong in the middle of a batch, the only
+ * safe thing to do is to throw away the connection along with the pending
+ * replies: the batch is rewound by LogThreadedDestDriver and sent again on
+ * a fresh connection. */
+static void
+_reset_pipeline(RedisDriver *self)
+{
+  self->pending_replies = 0;
+  redis_dd_disconnect(&self->super);
+}
 
-  if (!check_connection_to_redis(self))
-    {
-      msg_error("REDIS: worker failed to connect");
-      return LTR_NOT_CONNECTED;
-    }
+static gint
+_format_command_argv(RedisDriver *self, LogMessage *msg, const char *argv[], size_t argvlen[])
+{
+  gint argc = 2;
 
   log_template_format(self->key, msg, &self->template_options, LTZ_SEND,
                       self->super.worker.instance.seq_num, NULL, self->key_str);
@@ -275,6 +281,40 @@ redis_worker_insert(LogThreadedDestDriver *s, LogMessage *msg)
       argc++;
     }
 
+  return argc;
+}
+
+static LogThreadedResult
+_worker_prepare_connection(RedisDriver *self)
+{
+  if (!redis_dd_connect(self))
+    return LTR_NOT_CONNECTED;
+
+  if (self->c->err)
+    return LTR_ERROR;
+
+  if (!check_connection_to_redis(self))
+    {
+      msg_error("REDIS: worker failed to connect");
+      return LTR_NOT_CONNECTED;
+    }
+
+  return LTR_SUCCESS;
+}
+
+static LogThreadedResult
+_insert_single(RedisDriver *self, LogMessage *msg)
+{
+  redisReply *reply;
+  const char *argv[5];
+  size_t argvlen[5];
+  int argc;
+
+  LogThreadedResult result = _worker_prepare_connection(self);
+  if (result != LTR_SUCCESS)
+    return result;
+
+  argc = _format_command_argv(self, msg, argv, argvlen);
   reply = redisCommandArgv(self->c, argc, argv, argvlen);
 
   if (!reply)
@@ -301,6 +341,89 @@ redis_worker_insert(LogThreadedDestDriver *s, LogMessage *msg)
   return LTR_SUCCESS;
 }
 
+/* In pipelined mode the connection is only verified at the start of a
+ * batch, as any synchronous command issued in the middle of a batch would
+ * receive the reply of the first pending command.  Commands are only
+ * appended to the output buffer of hiredis here, they are written to the
+ * socket and their replies collected in redis_worker_flush(). */
+static LogThreadedResult
+_insert_batch(RedisDriver *self, LogMessage *msg)
+{
+  const char *argv[5];
+  size_t argvlen[5];
+  int argc;
+
+  if (self->pending_replies == 0)
+    {
+      LogThreadedResult result = _worker_prepare_connection(self);
+      if (result != LTR_SUCCESS)
+        return result;
+    }
+
+  argc = _format_command_argv(self, msg, argv, argvlen);
+  if (redisAppendCommandArgv(self->c, argc, argv, argvlen) != REDIS_OK)
+    {
+      msg_error("REDIS: error appending command to pipeline",
+                evt_tag_str("driver", self->super.super.super.id),
+                evt_tag_str("command", self->command->str),
+                evt_tag_str("key", self->key_str->str),
+                evt_tag_str("error", self->c->errstr));
+      _reset_pipeline(self);
+      return LTR_ERROR;
+    }
+  self->pending_replies++;
+
+  msg_trace("REDIS command appended to pipeline",
+            evt_tag_str("driver", self->super.super.super.id),
+            evt_tag_str("command", self->command->str),
+            evt_tag_str("key", self->key_str->str),
+            evt_tag_int("pending_replies", self->pending_replies));
+
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+redis_worker_insert(LogThreadedDestDriver *s, LogMessage *msg)
+{
+  RedisDriver *self = (RedisDriver *)s;
+
+  if (_is_pipelining_enabled(self))
+    return _insert_batch(self, msg);
+  return _insert_single(self, msg);
+}
+
+static LogThreadedResult
+redis_worker_flush(LogThreadedDestDriver *s)
+{
+  RedisDriver *self = (RedisDriver *)s;
+  redisReply *reply;
+
+  if (self->pending_replies == 0)
+    return LTR_SUCCESS;
+
+  msg_trace("REDIS flushing pipelined commands",
+            evt_tag_str("driver", self->super.super.super.id),
+            evt_tag_int("batch_size", self->pending_replies));
+
+  for (; self->pending_replies > 0; self->pending_replies--)
+    {
+      if (redisGetReply(self->c, (void **) &reply) != REDIS_OK || !reply)
+        {
+          msg_error("REDIS server error while flushing pipelined commands, suspending",
+                    evt_tag_str("driver", self->super.super.super.id),
+                    evt_tag_str("command", self->command->str),
+                    evt_tag_int("pending_replies", self->pending_replies),
+                    evt_tag_str("error", self->c->errstr),
+                    evt_tag_int("time_reopen", self->super.time_reopen));
+          _reset_pipeline(self);
+          return LTR_ERROR;
+        }
+      freeReplyObject(reply);
+    }
+
+  return LTR_SUCCESS;
+}
+
 static void
 redis_worker_thread_init(LogThreadedDestDriver *d)
 {
@@ -325,6 +448,7 @@ redis_worker_thread_deinit(LogThreadedDestDriver *d)
   g_string_free(self->param1_str, TRUE);
   g_string_free(self->param2_str, TRUE);
 
+  self->pending_replies = 0;
   redis_dd_disconnect(d);
 }
 
@@ -395,6 +519,7 @@ redis_dd_new(GlobalConfig *cfg)
   self->super.worker.thread_deinit = redis_worker_thread_deinit;
   self->super.worker.disconnect = redis_dd_disconnect;
   self->super.worker.insert = redis_worker_insert;
+  self->super.worker.flush = redis_worker_flush;
 
   self->super.format_stats_instance = redis_dd_format_stats_instance;
   self->super.stats_source = SCS_REDIS;
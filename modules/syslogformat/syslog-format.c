@@ -46,6 +46,53 @@ static struct
   NVHandle raw_message;
 } handles;
 
+/* character classes used by the header parser, indexed by the character */
+enum
+{
+  /* valid in a hostname if check-hostname() is enabled */
+  SCC_HOSTNAME_CHAR = 0x01,
+  /* terminate the hostname */
+  SCC_HOSTNAME_DELIM = 0x02,
+  /* terminate the legacy program name */
+  SCC_PROGRAM_DELIM = 0x04,
+  /* terminate the pid in the legacy program name */
+  SCC_PID_DELIM = 0x08,
+};
+
+static guint8 char_classes[256];
+
+static void
+_init_char_classes(void)
+{
+  gint i;
+
+  for (i = 0; i < 256; i++)
+    {
+      guint8 cc = 0;
+
+      if ((i >= 'A' && i <= 'Z') ||
+          (i >= 'a' && i <= 'z') ||
+          (i >= '0' && i <= '9') ||
+          i == '-' || i == '_' ||
+          i == '.' || i == ':' ||
+          i == '@' || i == '/')
+        cc |= SCC_HOSTNAME_CHAR;
+      if (i == ' ' || i == '[')
+        cc |= SCC_HOSTNAME_DELIM;
+      if (i == ' ' || i == '[' || i == ':')
+        cc |= SCC_PROGRAM_DELIM;
+      if (i == ' ' || i == ']' || i == ':')
+        cc |= SCC_PID_DELIM;
+      char_classes[i] = cc;
+    }
+}
+
+static inline gboolean
+_char_is_in_class(guchar c, guint8 cc)
+{
+  return (char_classes[c] & cc) != 0;
+}
+
 static gboolean
 log_msg_parse_pri(LogMessage *self, const guchar **data, gint *length, guint flags, guint16 default_pri)
 {
@@ -110,6 +157,21 @@ log_msg_parse_skip_chars(LogMessage *self, const guchar **data, gint *length, co
   return num_skipped;
 }
 
+static void
+log_msg_parse_skip_spaces(LogMessage *self, const guchar **data, gint *length)
+{
+  const guchar *src = *data;
+  gint left = *length;
+
+  while (left && *src == ' ')
+    {
+      src++;
+      left--;
+    }
+  *data = src;
+  *length = left;
+}
+
 static gboolean
 log_msg_parse_skip_space(LogMessage *self, const guchar **data, gint *length)
 {
@@ -313,7 +375,7 @@ log_msg_parse_legacy_program_name(LogMessage *self, const guchar **data, gint *l
   src = *data;
   left = *length;
   prog_start = src;
-  while (left && *src != ' ' && *src != '[' && *src != ':')
+  while (left && !_char_is_in_class(*src, SCC_PROGRAM_DELIM))
     {
       src++;
       left--;
@@ -322,7 +384,7 @@ log_msg_parse_legacy_program_name(LogMessage *self, const guchar **data, gint *l
   if (left > 0 && *src == '[')
     {
       const guchar *pid_start = src + 1;
-      while (left && *src != ' ' && *src != ']' && *src != ':')
+      while (left && !_char_is_in_class(*src, SCC_PID_DELIM))
         {
           src++;
           left--;
@@ -355,33 +417,6 @@ log_msg_parse_legacy_program_name(LogMessage *self, const guchar **data, gint *l
   *length = left;
 }
 
-static guint8 invalid_chars[32];
-
-static void
-_init_parse_hostname_invalid_chars(void)
-{
-  if ((invalid_chars[0] & 0x1) == 0)
-    {
-      gint i;
-      /* we use a bit string to represent valid/invalid characters  when check_hostname is enabled */
-
-      /* not yet initialized */
-      for (i = 0; i < 256; i++)
-        {
-          if (!((i >= 'A' && i <= 'Z') ||
-                (i >= 'a' && i <= 'z') ||
-                (i >= '0' && i <= '9') ||
-                i == '-' || i == '_' ||
-                i == '.' || i == ':' ||
-                i == '@' || i == '/'))
-            {
-              invalid_chars[i >> 8] |= 1 << (i % 8);
-            }
-        }
-      invalid_chars[0] |= 0x1;
-    }
-}
-
 typedef struct _IPv6Heuristics
 {
   gint8 current_segment;
@@ -445,7 +480,7 @@ log_msg_parse_hostname(LogMessage *self, const guchar **data, gint *length,
   oldsrc = src;
   oldleft = left;
 
-  while (left && *src != ' ' && *src != '[' && dst < sizeof(hostname_buf) - 1)
+  while (left && !_char_is_in_class(*src, SCC_HOSTNAME_DELIM) && dst < sizeof(hostname_buf) - 1)
     {
       ipv6_heuristics_feed_gchar(&ipv6_heuristics, *src);
 
@@ -454,15 +489,21 @@ log_msg_parse_hostname(LogMessage *self, const guchar **data, gint *length,
           break;
         }
 
-      if (G_UNLIKELY((flags & LP_CHECK_HOSTNAME) && (invalid_chars[((guint) *src) >> 8] & (1 << (((guint) *src) % 8)))))
+      if (G_UNLIKELY((flags & LP_CHECK_HOSTNAME) && !_char_is_in_class(*src, SCC_HOSTNAME_CHAR)))
         {
           break;
         }
-      hostname_buf[dst++] = *src;
+      dst++;
       src++;
       left--;
     }
-  hostname_buf[dst] = 0;
+
+  /* the NUL terminated copy is only needed by regexec() */
+  if (bad_hostname)
+    {
+      memcpy(hostname_buf, oldsrc, dst);
+      hostname_buf[dst] = 0;
+    }
 
   if (left && *src == ' ' &&
       (!bad_hostname || regexec(bad_hostname, hostname_buf, 0, NULL, 0)))
@@ -752,7 +793,7 @@ log_msg_parse_legacy(const MsgFormatOptions *parse_options,
     }
 
   log_msg_parse_cisco_sequence_id(self, &src, &left);
-  log_msg_parse_skip_chars(self, &src, &left, " ", -1);
+  log_msg_parse_skip_spaces(self, &src, &left);
   log_msg_parse_cisco_timestamp_attributes(self, &src, &left, parse_options->flags);
 
   cached_g_current_time(&now);
@@ -764,7 +805,7 @@ log_msg_parse_legacy(const MsgFormatOptions *parse_options,
       const guchar *hostname_start = NULL;
       int hostname_len = 0;
 
-      log_msg_parse_skip_chars(self, &src, &left, " ", -1);
+      log_msg_parse_skip_spaces(self, &src, &left);
 
       /* Detect funny AIX syslogd forwarded message. */
       if (G_UNLIKELY(left >= (sizeof(aix_fwd_string) - 1) &&
@@ -793,7 +834,7 @@ log_msg_parse_legacy(const MsgFormatOptions *parse_options,
                                      parse_options->bad_hostname);
 
               /* Skip whitespace. */
-              log_msg_parse_skip_chars(self, &src, &left, " ", -1);
+              log_msg_parse_skip_spaces(self, &src, &left);
             }
 
           /* Try to extract a program name */
@@ -1040,5 +1081,5 @@ syslog_format_init(void)
       handles.initialized = TRUE;
     }
 
-  _init_parse_hostname_invalid_chars();
+  _init_char_classes();
 }
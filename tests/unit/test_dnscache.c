@@ -239,3 +239,150 @@ Test(dnscache, test_lru_lists)
   _fill_dns_cache(cache, cache_size);
   dns_cache_free(cache);
 }
+
+static gint resolve_calls;
+
+static const gchar *
+_slow_resolve(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+  g_atomic_int_inc(&resolve_calls);
+  g_usleep(100000);
+  g_strlcpy(buf, "resolved", buf_len);
+  return buf;
+}
+
+Test(dnscache, test_async_lookups_of_the_same_address_are_coalesced)
+{
+  GSockAddr *saddr = g_sockaddr_inet_new("192.0.2.1", 0);
+  void *addr = &((struct sockaddr_in *) &saddr->sa)->sin_addr;
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+  gint i;
+
+  resolve_calls = 0;
+  for (i = 0; i < 10; i++)
+    cr_assert(dns_caching_resolve_async(AF_INET, addr, saddr, _slow_resolve));
+
+  for (i = 0; i < 100 && !dns_caching_lookup(AF_INET, addr, hn, sizeof(hn), &hn_len, &positive); i++)
+    g_usleep(50000);
+
+  cr_assert(dns_caching_lookup(AF_INET, addr, hn, sizeof(hn), &hn_len, &positive),
+            "resolved name did not appear in the cache");
+  cr_assert(positive);
+  cr_assert_str_eq(hn, "resolved");
+  cr_assert_eq(hn_len, strlen("resolved"));
+  cr_assert_eq(g_atomic_int_get(&resolve_calls), 1, "concurrent lookups of the same address were not coalesced");
+
+  g_sockaddr_unref(saddr);
+}
+
+static gchar *
+_create_hosts_file(const gchar *contents)
+{
+  GError *error = NULL;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp("test_dnscache_hosts.XXXXXX", &filename, &error);
+  cr_assert(fd >= 0, "Error creating hosts file: %s", error ? error->message : "");
+  close(fd);
+  cr_assert(g_file_set_contents(filename, contents, -1, NULL));
+  return filename;
+}
+
+static gboolean
+_reject_second_address(gint family, void *addr, gpointer user_data)
+{
+  struct in_addr *second = (struct in_addr *) user_data;
+
+  return memcmp(addr, second, sizeof(*second)) != 0;
+}
+
+Test(dnscache, test_hosts_filter_selects_the_entries_to_load)
+{
+  gchar *hosts = _create_hosts_file("192.0.2.1 first\n192.0.2.2 second\n");
+  DNSCacheOptions options =
+  {
+    .cache_size = 10,
+    .expire = 600,
+    .expire_failed = 300,
+    .hosts = hosts
+  };
+  DNSCache *cache = dns_cache_new(&options);
+  struct in_addr first, second;
+  const gchar *hn;
+  gsize hn_len;
+  gboolean positive;
+
+  inet_pton(AF_INET, "192.0.2.1", &first);
+  inet_pton(AF_INET, "192.0.2.2", &second);
+  dns_cache_set_hosts_filter(cache, _reject_second_address, &second);
+
+  cr_assert(dns_cache_lookup(cache, AF_INET, &first, &hn, &hn_len, &positive));
+  cr_assert_str_eq(hn, "first");
+  cr_assert_not(dns_cache_lookup(cache, AF_INET, &second, &hn, &hn_len, &positive));
+
+  dns_cache_free(cache);
+  unlink(hosts);
+  g_free(hosts);
+}
+
+Test(dnscache, test_hosts_file_entries_are_found_in_the_shared_cache)
+{
+  gchar *hosts = _create_hosts_file("192.0.2.1 first\n192.0.2.2 second\n198.51.100.1 third\n");
+  const gchar *names[] = { "first", "second", "third" };
+  const gchar *addresses[] = { "192.0.2.1", "192.0.2.2", "198.51.100.1" };
+  DNSCacheOptions options;
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+  gint i;
+
+  dns_cache_options_defaults(&options);
+  options.hosts = hosts;
+  dns_caching_update_options(&options);
+
+  for (i = 0; i < G_N_ELEMENTS(addresses); i++)
+    {
+      struct in_addr addr;
+
+      inet_pton(AF_INET, addresses[i], &addr);
+      cr_assert(dns_caching_lookup(AF_INET, &addr, hn, sizeof(hn), &hn_len, &positive),
+                "hosts file entry not found: %s", addresses[i]);
+      cr_assert(positive);
+      cr_assert_str_eq(hn, names[i]);
+    }
+
+  unlink(hosts);
+  dns_cache_options_destroy(&options);
+}
+
+Test(dnscache, test_small_cache_size_is_not_shrunk_by_sharding)
+{
+  DNSCacheOptions options;
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+  gint i;
+
+  dns_cache_options_defaults(&options);
+  options.cache_size = 17;
+  dns_caching_update_options(&options);
+
+  /* 0.0.0.0 and 0.0.0.16 end up in the same shard */
+  for (i = 0; i < options.cache_size; i++)
+    {
+      guint32 ni = htonl(i);
+
+      dns_caching_store(AF_INET, &ni, positive_hostname, TRUE);
+    }
+
+  for (i = 0; i < options.cache_size; i++)
+    {
+      guint32 ni = htonl(i);
+
+      cr_assert(dns_caching_lookup(AF_INET, &ni, hn, sizeof(hn), &hn_len, &positive),
+                "entry %d was evicted from a cache of %d entries", i, options.cache_size);
+    }
+}
@@ -801,3 +801,38 @@ Test(zone, test_logstamp_format)
 
   g_string_free(target, TRUE);
 }
+
+Test(zone, test_logstamp_format_with_cached_prefix)
+{
+  LogStamp stamp;
+  GString *target = g_string_sized_new(32);
+  TimestampFormatTestCase test_cases[] =
+  {
+    /* more formats/zones than cache slots in the same second */
+    {TS_FMT_ISO, 3600, 3, "2005-10-14T20:47:37.123+01:00"},
+    {TS_FMT_BSD, 3600, 3, "Oct 14 20:47:37.123"},
+    {TS_FMT_ISO, -3600, 6, "2005-10-14T18:47:37.123456-01:00"},
+    {TS_FMT_FULL, 3600, 0, "2005 Oct 14 20:47:37"},
+    {TS_FMT_ISO, 5400, 3, "2005-10-14T21:17:37.123+01:30"},
+    {TS_FMT_ISO, 3600, 0, "2005-10-14T20:47:37+01:00"},
+    {TS_FMT_BSD, 3600, 1, "Oct 14 20:47:37.1"},
+  };
+  gint i, nr_of_cases;
+
+  stamp.tv_sec = 1129319257;
+  stamp.tv_usec = 123456;
+  stamp.zone_offset = 0;
+  nr_of_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+  for (i = 0; i < nr_of_cases; i++)
+    assert_timestamp_format(target, &stamp, test_cases[i]);
+
+  /* next second, same format & zone */
+  stamp.tv_sec++;
+  stamp.tv_usec = 654321;
+  assert_timestamp_format(target, &stamp, (TimestampFormatTestCase)
+  {
+    TS_FMT_ISO, 3600, 3, "2005-10-14T20:47:38.654+01:00"
+  });
+
+  g_string_free(target, TRUE);
+}